@@ -0,0 +1,318 @@
+#include "AssemblyGenerator.h"
+
+#include <map>
+
+#include "RegisterAllocator.h"
+
+// Helper function to check for integer literals
+static bool isIntegerLiteral(const std::string& value) {
+    size_t digits = !value.empty() && value[0] == '-' ? 1 : 0;
+    return value.size() > digits && value.find_first_not_of("0123456789", digits) == std::string::npos;
+}
+
+// Helper function to get the assembly label of a block
+static std::string blockLabel(const std::string& blockName) { return ".L" + blockName; }
+
+void AsmProgram::generateAssembly(const ControlFlowGraph& cfg, const SymbolTable& symbolTable) {
+    TypeTracker typeTracker(symbolTable);
+
+    // Group the blocks by method, keeping the methods in the order they first appear
+    std::vector<std::string> methodOrder;
+    std::map<std::string, std::vector<const BasicBlock*>> methodBlocks;
+    for (const auto& block : cfg.getBlocks()) {
+        if (methodBlocks.find(block->method) == methodBlocks.end()) methodOrder.push_back(block->method);
+        methodBlocks[block->method].push_back(block);
+    }
+
+    lines.push_back("\t.text");
+    for (const auto& methodName : methodOrder) {
+        typeTracker.enterMethod(methodName);
+        generateMethod(methodName, methodBlocks[methodName], typeTracker);
+    }
+    lines.push_back("\t.section .note.GNU-stack,\"\",@progbits");
+}
+
+void AsmProgram::generateMethod(const std::string& methodName, const std::vector<const BasicBlock*>& blocks,
+                                TypeTracker& typeTracker) {
+    const Method* method = typeTracker.getMethod();
+    bool isMain = typeTracker.inMainMethod();
+
+    auto emit = [&](const std::string& line) { lines.push_back("\t" + line); };
+    auto label = [&](const std::string& name) { lines.push_back(name + ":"); };
+
+    // The receiver and parameters live in the caller's frame, everything else gets a slot in ours
+    std::unordered_map<std::string, std::string> locations;
+    if (!isMain) {
+        locations["this"] = "16(%rbp)";
+        if (method) {
+            const auto& parameters = method->getParameters();
+            for (size_t i = 0; i < parameters.size(); i++) {
+                locations[parameters[i].getName()] = std::to_string(24 + 8 * i) + "(%rbp)";
+            }
+        }
+    }
+    auto isCandidate = [&](const std::string& name) {
+        if (name.empty() || isIntegerLiteral(name) || name == "true" || name == "false") return false;
+        return typeTracker.getFieldIndex(name) < 0 && !locations.count(name);
+    };
+
+    // Keep locals and temporaries in callee-saved registers, which survive calls, and spill the rest
+    static const std::vector<std::string> registers = {"%rbx", "%r12", "%r13", "%r14", "%r15"};
+    LivenessAnalysis liveness(blocks, isCandidate);
+    std::vector<LiveInterval> intervals = liveness.getIntervals();
+    auto assignment = LinearScanAllocator(registers.size()).allocate(intervals);
+
+    int frameSlots = 0;
+    auto newSlot = [&]() { return std::to_string(-8 * ++frameSlots) + "(%rbp)"; };
+    std::vector<std::pair<std::string, std::string>> savedRegisters;
+    std::vector<std::string> spillSlots;
+    for (size_t reg = 0; reg < registers.size(); reg++) {
+        for (const auto& entry : assignment) {
+            if (entry.second == static_cast<int>(reg)) {
+                savedRegisters.emplace_back(registers[reg], newSlot());
+                break;
+            }
+        }
+    }
+    for (const auto& interval : intervals) {
+        int reg = assignment[interval.name];
+        if (reg == LinearScanAllocator::SPILLED) {
+            locations[interval.name] = newSlot();
+            spillSlots.push_back(locations[interval.name]);
+        } else {
+            locations[interval.name] = registers[reg];
+        }
+    }
+
+    // Helper functions moving values between variables and registers, reading fields through the receiver
+    auto load = [&](Symbol value, const std::string& reg) {
+        if (isIntegerLiteral(value)) {
+            emit("movq $" + value + ", " + reg);
+        } else if (value == tac::TRUE_LITERAL || value == tac::FALSE_LITERAL) {
+            emit("movq $" + std::string(value == tac::TRUE_LITERAL ? "1" : "0") + ", " + reg);
+        } else if (typeTracker.getFieldIndex(value) >= 0) {
+            emit("movq 16(%rbp), %r11");
+            emit("movq " + std::to_string(8 * (typeTracker.getFieldIndex(value) + 1)) + "(%r11), " + reg);
+        } else {
+            emit("movq " + locations[value] + ", " + reg);
+        }
+    };
+    auto store = [&](Symbol variable, const std::string& reg) {
+        int field = typeTracker.getFieldIndex(variable);
+        if (field >= 0) {
+            emit("movq 16(%rbp), %r11");
+            emit("movq " + reg + ", " + std::to_string(8 * (field + 1)) + "(%r11)");
+        } else {
+            emit("movq " + reg + ", " + locations[variable]);
+        }
+    };
+
+    // Runtime checks on the array in %rax and the index in %rcx
+    auto checkNull = [&]() {
+        emit("testq %rax, %rax");
+        emit("jnz 1f");
+        emit("call mj_null_reference");
+        label("1");
+    };
+    auto checkIndex = [&]() {
+        checkNull();
+        emit("cmpl (%rax), %ecx");
+        emit("jb 1f");
+        emit("movl %ecx, %edi");
+        emit("call mj_index_out_of_bounds");
+        label("1");
+    };
+
+    // Booleans are printed as true or false, so the type of every value has to be known statically.
+    // Temporaries are reused between statements and take the type of their latest definition.
+    std::unordered_map<Symbol, bool> booleanTemps;
+    auto isBoolean = [&](Symbol value) {
+        if (value == tac::TRUE_LITERAL || value == tac::FALSE_LITERAL) return true;
+        std::string declaredType = typeTracker.getDeclaredType(value);
+        if (!declaredType.empty()) return declaredType == "Bool";
+        auto it = booleanTemps.find(value);
+        return it != booleanTemps.end() && it->second;
+    };
+
+    // Prologue, reserving 16-byte aligned space for the zero-initialized local slots
+    std::string functionName = isMain ? "main" : methodName;
+    lines.push_back("");
+    emit(".globl " + functionName);
+    emit(".type " + functionName + ", @function");
+    label(functionName);
+    emit("pushq %rbp");
+    emit("movq %rsp, %rbp");
+    int frameSize = (frameSlots * 8 + 15) / 16 * 16;
+    if (frameSize > 0) emit("subq $" + std::to_string(frameSize) + ", %rsp");
+    for (const auto& saved : savedRegisters) emit("movq " + saved.first + ", " + saved.second);
+
+    // Variables can be read before they are written, and then hold zero
+    for (const auto& slot : spillSlots) emit("movq $0, " + slot);
+    const BasicBlock* entryBlock = nullptr;
+    for (const auto& block : blocks) {
+        if (block->name == methodName) entryBlock = block;
+    }
+    if (entryBlock) {
+        for (const auto& name : liveness.getLiveIn(entryBlock)) {
+            if (locations[name][0] == '%') emit("movq $0, " + locations[name]);
+        }
+    }
+    emit("jmp " + blockLabel(methodName));
+
+    auto emitEpilogue = [&]() {
+        for (const auto& saved : savedRegisters) emit("movq " + saved.second + ", " + saved.first);
+        emit("leave");
+        emit("ret");
+    };
+
+    static const std::unordered_map<Symbol, std::string> arithmetic = {
+        {tac::ADD, "addl"}, {tac::SUB, "subl"}, {tac::MUL, "imull"}};
+    static const std::unordered_map<Symbol, std::string> comparisons = {
+        {tac::LESS, "setl"}, {tac::GREATER, "setg"}, {tac::EQUAL, "sete"}};
+
+    for (const auto& block : blocks) {
+        label(blockLabel(block->name));
+        std::vector<Symbol> pendingParams;
+        bool stop = true;
+
+        for (const auto& tacInst : block->getTacInstructions()) {
+            if (tacInst.op == tac::PARAM) {
+                pendingParams.push_back(tacInst.arg1);
+            } else if (tacInst.op == tac::PRINT) {
+                load(tacInst.arg1, "%rdi");
+                emit(isBoolean(tacInst.arg1) ? "call mj_print_bool" : "call mj_print_int");
+            } else if (tacInst.op == tac::RETURN) {
+                load(tacInst.arg1, "%rax");
+                emitEpilogue();
+                stop = false;
+            } else if (arithmetic.count(tacInst.op)) {
+                load(tacInst.arg1, "%rax");
+                load(tacInst.arg2, "%rcx");
+                emit(arithmetic.at(tacInst.op) + " %ecx, %eax");
+                store(tacInst.result, "%rax");
+                booleanTemps[tacInst.result] = false;
+            } else if (comparisons.count(tacInst.op)) {
+                load(tacInst.arg1, "%rax");
+                load(tacInst.arg2, "%rcx");
+                emit("cmpl %ecx, %eax");
+                emit(comparisons.at(tacInst.op) + " %al");
+                emit("movzbl %al, %eax");
+                store(tacInst.result, "%rax");
+                booleanTemps[tacInst.result] = true;
+            } else if (tacInst.op == tac::AND || tacInst.op == tac::OR) {
+                load(tacInst.arg1, "%rax");
+                load(tacInst.arg2, "%rcx");
+                emit("testl %eax, %eax");
+                emit("setne %al");
+                emit("testl %ecx, %ecx");
+                emit("setne %cl");
+                emit(std::string(tacInst.op == tac::AND ? "andb" : "orb") + " %cl, %al");
+                emit("movzbl %al, %eax");
+                store(tacInst.result, "%rax");
+                booleanTemps[tacInst.result] = true;
+            } else if (tacInst.op == tac::NOT) {
+                load(tacInst.arg1, "%rax");
+                emit("testl %eax, %eax");
+                emit("sete %al");
+                emit("movzbl %al, %eax");
+                store(tacInst.result, "%rax");
+                booleanTemps[tacInst.result] = true;
+            } else if (tacInst.op == tac::LOAD_INDEX || tacInst.op == tac::LOAD_INDEX_UNCHECKED) {
+                load(tacInst.arg1, "%rax");
+                load(tacInst.arg2, "%rcx");
+                if (tacInst.op == tac::LOAD_INDEX) checkIndex();
+                emit("movq 8(%rax,%rcx,8), %rax");
+                store(tacInst.result, "%rax");
+                booleanTemps[tacInst.result] = false;
+            } else if (tacInst.op == tac::STORE_INDEX || tacInst.op == tac::STORE_INDEX_UNCHECKED) {
+                load(tacInst.result, "%rax");
+                load(tacInst.arg1, "%rcx");
+                load(tacInst.arg2, "%rdx");
+                if (tacInst.op == tac::STORE_INDEX) checkIndex();
+                emit("movq %rdx, 8(%rax,%rcx,8)");
+            } else if (tacInst.op == tac::LOAD_FIELD || tacInst.op == tac::STORE_FIELD) {
+                // Field access through an object other than the receiver
+                bool isLoad = tacInst.op == tac::LOAD_FIELD;
+                std::string type;
+                int field = typeTracker.resolveField(isLoad ? tacInst.arg2 : tacInst.arg1, type);
+                if (field < 0) throw std::runtime_error("Unknown field: " + (isLoad ? tacInst.arg2 : tacInst.arg1));
+                std::string address = std::to_string(8 * (field + 1)) + "(%rax)";
+                load(isLoad ? tacInst.arg1 : tacInst.result, "%rax");
+                checkNull();
+                if (isLoad) {
+                    emit("movq " + address + ", %rax");
+                    typeTracker.trackFieldLoad(tacInst.result, tacInst.arg2);
+                    store(tacInst.result, "%rax");
+                    booleanTemps[tacInst.result] = type == "Bool";
+                } else {
+                    load(tacInst.arg2, "%rcx");
+                    emit("movq %rcx, " + address);
+                }
+            } else if (tacInst.op == tac::LENGTH) {
+                load(tacInst.arg1, "%rax");
+                checkNull();
+                emit("movq (%rax), %rax");
+                store(tacInst.result, "%rax");
+                booleanTemps[tacInst.result] = false;
+            } else if (tacInst.op == tac::NEW_ARRAY) {
+                load(tacInst.arg1, "%rdi");
+                emit("call mj_new_array");
+                store(tacInst.result, "%rax");
+                booleanTemps[tacInst.result] = false;
+            } else if (tacInst.op == tac::NEW) {
+                typeTracker.trackNewObject(tacInst.result, tacInst.arg1);
+                emit("movq $" + std::to_string(typeTracker.getFieldCount(tacInst.arg1)) + ", %rdi");
+                emit("call mj_new_object");
+                store(tacInst.result, "%rax");
+                booleanTemps[tacInst.result] = false;
+            } else if (tacInst.op == tac::IF) {
+                load(tacInst.arg1, "%rax");
+                emit("testl %eax, %eax");
+                emit("jz " + blockLabel(block->falseExit->name));
+            } else if (tacInst.op == tac::CALL) {
+                if (pendingParams.empty()) throw std::runtime_error("Call without receiver: " + tacInst.arg1);
+
+                // Keep %rsp 16-byte aligned at the call, then push the arguments with the receiver on top
+                std::string className, methodName;
+                typeTracker.resolveCall(pendingParams[0], tacInst.arg1, className, methodName);
+                size_t padding = pendingParams.size() % 2 ? 8 : 0;
+                if (padding) emit("subq $8, %rsp");
+                for (auto it = pendingParams.rbegin(); it != pendingParams.rend(); ++it) {
+                    load(*it, "%rax");
+                    emit("pushq %rax");
+                }
+                emit("call " + className + "." + methodName);
+                emit("addq $" + std::to_string(8 * pendingParams.size() + padding) + ", %rsp");
+                pendingParams.clear();
+
+                typeTracker.trackCall(tacInst.result, className, methodName);
+                if (!tacInst.result.empty()) {
+                    store(tacInst.result, "%rax");
+                    booleanTemps[tacInst.result] = typeTracker.getReturnType(className, methodName) == "Bool";
+                }
+            } else if (tacInst.op.empty()) {
+                typeTracker.trackAssignment(tacInst.result, tacInst.arg1);
+                load(tacInst.arg1, "%rax");
+                store(tacInst.result, "%rax");
+                booleanTemps[tacInst.result] = isBoolean(tacInst.arg1);
+            }
+        }
+
+        // Handle block exits
+        if (block->trueExit) {
+            emit("jmp " + blockLabel(block->trueExit->name));
+        } else if (stop && isMain) {
+            emit("xorl %eax, %eax");
+            emitEpilogue();
+        } else if (stop) {
+            emit("call mj_stop");
+        }
+    }
+    emit(".size " + functionName + ", .-" + functionName);
+}
+
+void AsmProgram::print(std::ofstream& outFile) const {
+    for (const auto& line : lines) {
+        outFile << line << std::endl;
+    }
+}
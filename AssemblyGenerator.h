@@ -0,0 +1,54 @@
+#ifndef ASSEMBLYGENERATOR_H
+#define ASSEMBLYGENERATOR_H
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BytecodeGenerator.h"
+#include "IntermediateRepresentation.h"
+#include "SymbolTable.h"
+
+/*
+ * Ahead-of-time backend producing GNU as x86-64 assembly from the control flow graph.
+ *
+ * Every MiniJava method becomes a function; the main method becomes the C entry point main. Integers and
+ * booleans are 32-bit values in 64-bit locations, references are pointers into memory from the runtime
+ * in runtime.c, which also prints values and reports runtime errors. Locals and temporaries are assigned
+ * callee-saved registers by linear scan over their live intervals, the rest live in 8-byte stack slots.
+ *
+ * Calling convention: the caller pushes the arguments from last to first and the receiver last, so the
+ * callee finds the receiver at 16(%rbp) and parameter i at 24+8i(%rbp). The caller removes them after the
+ * call. The result is returned in %rax. Objects and arrays start with a header word holding the number
+ * of fields or elements, followed by one 8-byte word per field or element.
+ */
+class AsmProgram {
+   public:
+    /**
+     * @brief Generates assembly for every method in the control flow graph.
+     * @param cfg The control flow graph to convert.
+     * @param symbolTable The symbol table, used for object layouts and variable types.
+     */
+    void generateAssembly(const ControlFlowGraph &cfg, const SymbolTable &symbolTable);
+
+    /**
+     * @brief Prints the assembly to a file.
+     * @param outFile The file to print the assembly to.
+     */
+    void print(std::ofstream &outFile) const;
+
+   private:
+    std::vector<std::string> lines;
+
+    /**
+     * @brief Generates the function for one method.
+     * @param methodName The qualified name of the method.
+     * @param blocks The blocks of the method, in the order of the control flow graph.
+     * @param typeTracker A type tracker that has entered the method.
+     */
+    void generateMethod(const std::string &methodName, const std::vector<const BasicBlock *> &blocks,
+                        TypeTracker &typeTracker);
+};
+
+#endif  // ASSEMBLYGENERATOR_H
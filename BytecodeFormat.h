@@ -0,0 +1,52 @@
+#ifndef BYTECODEFORMAT_H
+#define BYTECODEFORMAT_H
+
+#include <cstdint>
+
+/*
+ * Layout of the binary bytecode container (.bcb), written by BCProgram::writeBinary and loaded by the
+ * interpreter. All sections follow each other directly after the header, in this order:
+ *
+ *   BinaryHeader
+ *   uint32_t stringOffsets[stringCount]         Offsets into the string data
+ *   char     stringData[stringDataSize]          NUL-terminated block, variable and layout names, padded with NULs
+ *                                                to a multiple of 4 bytes so that the constants are aligned
+ *   int32_t  constants[constantCount]            Constant pool for iconst
+ *   BinaryBlock blocks[blockCount]
+ *   BinaryInstruction instructions[instructionCount]
+ *
+ * Values are stored in the byte order of the machine that wrote the file. The version changes with every change
+ * to the opcodes or their operands, so that a loader rejects files it would misread.
+ */
+
+const char BYTECODE_MAGIC[4] = {'M', 'J', 'B', 'C'};
+const uint16_t BYTECODE_VERSION = 3;
+
+struct BinaryHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t stringCount;
+    uint32_t stringDataSize;
+    uint32_t constantCount;
+    uint32_t blockCount;
+    uint32_t instructionCount;
+};
+
+struct BinaryBlock {
+    uint32_t name;              // Index into the string table
+    uint32_t firstInstruction;  // Index of the first instruction of the block
+    uint32_t instructionCount;
+};
+
+// Fixed-width instruction. The operand is an index into the string table for iload/istore and for new,
+// whose string is the layout of the object with one character per field, Z for a boolean and I for
+// anything else. It is an index into the constant pool for iconst and into the block table for jumps
+// and invokevirtual, and for getfield/putfield the index of the field.
+struct BinaryInstruction {
+    uint8_t opcode;
+    uint8_t reserved[3];
+    uint32_t operand;
+};
+
+#endif  // BYTECODEFORMAT_H
@@ -1,145 +1,360 @@
 #include "BytecodeGenerator.h"
 
+#include <functional>
+
+#include "RegisterAllocator.h"
+
 // Helper function to normalize boolean values
-std::string normalizeBooleanValue(const std::string& value) {
-    if (value == "true") return "1";
-    if (value == "false") return "0";
+Symbol normalizeBooleanValue(Symbol value) {
+    if (value == tac::TRUE_LITERAL) return tac::ONE;
+    if (value == tac::FALSE_LITERAL) return tac::ZERO;
     return value;
 }
 
 // Get the corresponding opcode for an operation
-OpCode getOpCodeForOperation(const std::string& op, std::string& arg1, std::string& arg2) {
-    if (op == " + ") return OpCode::IADD;
-    if (op == " - ") return OpCode::ISUB;
-    if (op == " * ") return OpCode::IMUL;
-    if (op == " < ") return OpCode::ILT;
-    if (op == " > ") return OpCode::IGT;
-    if (op == " == ") return OpCode::IEQ;
-
-    if (op == " && " || op == " || ") {
+OpCode getOpCodeForOperation(Symbol op, Symbol& arg1, Symbol& arg2) {
+    if (op == tac::ADD) return OpCode::IADD;
+    if (op == tac::SUB) return OpCode::ISUB;
+    if (op == tac::MUL) return OpCode::IMUL;
+    if (op == tac::LESS) return OpCode::ILT;
+    if (op == tac::GREATER) return OpCode::IGT;
+    if (op == tac::EQUAL) return OpCode::IEQ;
+
+    if (op == tac::AND || op == tac::OR) {
         arg1 = normalizeBooleanValue(arg1);
         arg2 = normalizeBooleanValue(arg2);
-        return (op == " && ") ? OpCode::IAND : OpCode::IOR;
+        return (op == tac::AND) ? OpCode::IAND : OpCode::IOR;
     }
 
     throw std::runtime_error("Unknown operation: " + op);
 }
 
+OpCode invertJump(OpCode opcode) {
+    switch (opcode) {
+        case OpCode::IFFALSEGOTO:
+            return OpCode::IFNE;
+        case OpCode::IFNE:
+            return OpCode::IFFALSEGOTO;
+        case OpCode::IF_ICMPLT:
+            return OpCode::IF_ICMPGE;
+        case OpCode::IF_ICMPGE:
+            return OpCode::IF_ICMPLT;
+        case OpCode::IF_ICMPGT:
+            return OpCode::IF_ICMPLE;
+        case OpCode::IF_ICMPLE:
+            return OpCode::IF_ICMPGT;
+        case OpCode::IF_ICMPEQ:
+            return OpCode::IF_ICMPNE;
+        case OpCode::IF_ICMPNE:
+            return OpCode::IF_ICMPEQ;
+        default:
+            throw std::runtime_error("Not a conditional jump: " + std::to_string(static_cast<int>(opcode)));
+    }
+}
+
+void TypeTracker::enterMethod(const std::string& qualifiedName) {
+    tempVarTypes.clear();
+    cls = nullptr;
+    method = nullptr;
+
+    std::string className = qualifiedName.substr(0, qualifiedName.find('.'));
+    std::string methodName = qualifiedName.substr(qualifiedName.find('.') + 1);
+    if (symbolTable.hasClass(className)) {
+        cls = &symbolTable.getClass(className);
+        method = cls->findMethod(methodName);
+    }
+}
+
+bool TypeTracker::isMethodVariable(const std::string& name) const {
+    if (!method) return false;
+    return method->findParameter(name) || method->isLocalVariable(name);
+}
+
+std::string TypeTracker::resolveClassName(const std::string& ref) const {
+    auto it = tempVarTypes.find(ref);
+    if (it != tempVarTypes.end()) {
+        return it->second;
+    }
+    if (!cls) return ref;
+    if (ref == "this") return cls->getName();
+
+    std::string type = getDeclaredType(ref);
+    return type.empty() ? ref : type;
+}
+
+void TypeTracker::resolveCall(const std::string& receiver, const std::string& target, std::string& className,
+                              std::string& methodName) const {
+    size_t dot = target.find('.');
+    if (dot != std::string::npos) {
+        className = target.substr(0, dot);
+        methodName = target.substr(dot + 1);
+    } else {
+        className = resolveClassName(receiver);
+        methodName = target;
+    }
+}
+
+int TypeTracker::resolveField(const std::string& qualifiedName, std::string& type) const {
+    std::string className = qualifiedName.substr(0, qualifiedName.find('.'));
+    std::string fieldName = qualifiedName.substr(qualifiedName.find('.') + 1);
+    if (!symbolTable.hasClass(className)) return -1;
+    const Class& fieldClass = symbolTable.getClass(className);
+    const Variable* field = fieldClass.findVariable(fieldName);
+    if (!field) return -1;
+    type = field->getType();
+    return field - fieldClass.getVariables().data();
+}
+
+int TypeTracker::getFieldIndex(const std::string& name) const {
+    if (!cls || isMethodVariable(name)) return -1;
+    const Variable* field = cls->findVariable(name);
+    return field ? field - cls->getVariables().data() : -1;
+}
+
+std::string TypeTracker::getDeclaredType(const std::string& name) const {
+    if (method) {
+        if (const Variable* param = method->findParameter(name)) return param->getType();
+        if (const Variable* local = method->findLocalVariable(name)) return local->getType();
+    }
+    if (cls) {
+        if (const Variable* var = cls->findVariable(name)) return var->getType();
+    }
+    return "";
+}
+
+std::string TypeTracker::getReturnType(const std::string& className, const std::string& methodName) const {
+    if (!symbolTable.hasClass(className)) return "";
+    const Method* method = symbolTable.getClass(className).findMethod(methodName);
+    return method ? method->getReturnType() : "";
+}
+
+int TypeTracker::getFieldCount(const std::string& className) const {
+    // Undeclared classes are reported by the semantic analyzer
+    if (!symbolTable.hasClass(className)) return 0;
+    return symbolTable.getClass(className).getVariables().size();
+}
+
+std::string TypeTracker::getFieldLayout(const std::string& className) const {
+    std::string layout;
+    if (!symbolTable.hasClass(className)) return layout;
+    for (const Variable& field : symbolTable.getClass(className).getVariables()) {
+        layout += field.getType() == "Bool" ? 'Z' : 'I';
+    }
+    return layout;
+}
+
 void BCProgram::generateBytecode(const ControlFlowGraph& cfg, const SymbolTable& symbolTable) {
     TypeTracker typeTracker(symbolTable);
+    std::string currentMethod;
+    std::unique_ptr<LivenessAnalysis> liveness;
 
     // Process each basic block in the CFG
-    for (const auto& block : cfg.getBlocks()) {
+    const auto& cfgBlocks = cfg.getBlocks();
+    for (size_t blockIndex = 0; blockIndex < cfgBlocks.size(); blockIndex++) {
+        const BasicBlock* block = cfgBlocks[blockIndex];
         auto bytecodeBlock = std::make_unique<BCBlock>(block->name);
         bool stop = true;
 
-        // Extract class and method names
-        std::string className = block->name.substr(0, block->name.find('.'));
-        std::string methodName = block->name.substr(block->name.find('.') + 1);
-        bool isMainMethod = methodName == "main";
-
-        // Store method parameters
-        if (symbolTable.hasClass(className)) {
-            Class cls = symbolTable.getClass(className);
-            if (cls.hasMethod(methodName)) {
-                for (const auto& param : cls.getMethod(methodName).getParameters()) {
-                    bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(OpCode::ISTORE, param.getName()));
-                }
+        if (block->method != currentMethod) {
+            currentMethod = block->method;
+            typeTracker.enterMethod(currentMethod);
+
+            // Temporaries live across blocks decide which comparisons can be fused with their branch
+            std::vector<const BasicBlock*> methodBlocks;
+            for (size_t i = blockIndex; i < cfgBlocks.size() && cfgBlocks[i]->method == currentMethod; i++) {
+                methodBlocks.push_back(cfgBlocks[i]);
             }
+            liveness.reset(new LivenessAnalysis(methodBlocks, isTemporary));
         }
 
-        // Helper function for loading values
-        auto addLoadInstruction = [&](const std::string& arg) {
-            OpCode opType = (arg.find_first_not_of("0123456789") == std::string::npos) ? OpCode::ICONST : OpCode::ILOAD;
-            bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(opType, arg));
+        auto emit = [&](OpCode opcode, Symbol argument = Symbol()) {
+            bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(opcode, argument));
         };
 
-        // First pass - identify variable types
-        for (const auto& tacInst : block->getTacInstructions()) {
-            if (tacInst.op.empty()) {
-                typeTracker.trackAssignment(tacInst.result, tacInst.arg1);
-            } else if (tacInst.op == "new") {
-                typeTracker.trackNewObject(tacInst.result, tacInst.arg1);
+        // Store the receiver and method parameters, which the caller pushed in declaration order
+        const Method* method = typeTracker.getMethod();
+        if (block->name == block->method && method && !typeTracker.inMainMethod()) {
+            const auto& parameters = method->getParameters();
+            for (auto it = parameters.rbegin(); it != parameters.rend(); ++it) {
+                emit(OpCode::ISTORE, it->getName());
             }
+            emit(OpCode::ISTORE, tac::THIS);
         }
 
-        // Second pass - generate bytecode
-        std::vector<std::string> pendingParams;
+        // Helper function for loading values, reading fields through the receiver
+        auto addLoadInstruction = [&](Symbol arg) {
+            // Integer literals, which constant propagation may leave negative
+            const std::string& text = arg.str();
+            size_t digits = !text.empty() && text[0] == '-' ? 1 : 0;
+            if (text.size() > digits && text.find_first_not_of("0123456789", digits) == std::string::npos) {
+                emit(OpCode::ICONST, arg);
+                return;
+            }
+            int field = typeTracker.getFieldIndex(arg);
+            if (field >= 0) {
+                emit(OpCode::ILOAD, tac::THIS);
+                emit(OpCode::GETFIELD, std::to_string(field));
+            } else {
+                emit(OpCode::ILOAD, arg);
+            }
+        };
+
+        // Helper function for storing a value produced by loadValue, writing fields through the receiver
+        auto addStoreInstruction = [&](Symbol var, const std::function<void()>& loadValue) {
+            int field = typeTracker.getFieldIndex(var);
+            if (field >= 0) {
+                emit(OpCode::ILOAD, tac::THIS);
+                loadValue();
+                emit(OpCode::PUTFIELD, std::to_string(field));
+            } else {
+                loadValue();
+                emit(OpCode::ISTORE, var);
+            }
+        };
+
+        std::vector<Symbol> pendingParams;
 
-        for (const auto& tacInst : block->getTacInstructions()) {
-            if (tacInst.op == "param") {
+        // A comparison or negation whose temporary is only read by the branch ending the block is fused with it
+        auto tacInstructions = block->getTacInstructions();
+        size_t fusedCondition = tacInstructions.size();
+        if (tacInstructions.size() >= 2 && tacInstructions.back().op == tac::IF) {
+            const auto& condition = tacInstructions[tacInstructions.size() - 2];
+            Symbol name = tacInstructions.back().arg1;
+            if (condition.result == name && isTemporary(name) && !liveness->getLiveOut(block).count(name) &&
+                (condition.op == tac::LESS || condition.op == tac::GREATER || condition.op == tac::EQUAL ||
+                 condition.op == tac::NOT)) {
+                fusedCondition = tacInstructions.size() - 2;
+            }
+        }
+
+        for (size_t i = 0; i < tacInstructions.size(); i++) {
+            const auto& tacInst = tacInstructions[i];
+            if (i == fusedCondition) {
+                continue;  // Emitted with the branch
+            } else if (tacInst.op == tac::PARAM) {
                 pendingParams.push_back(tacInst.arg1);
-            } else if (tacInst.op == "print") {
+            } else if (tacInst.op == tac::PRINT) {
                 addLoadInstruction(tacInst.arg1);
-                bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(OpCode::PRINT));
-            } else if (tacInst.op == "return") {
+                emit(OpCode::PRINT);
+            } else if (tacInst.op == tac::RETURN) {
                 addLoadInstruction(tacInst.arg1);
-                bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(OpCode::IRETURN));
+                emit(OpCode::IRETURN);
                 stop = false;
-            } else if (tacInst.op == " + " || tacInst.op == " - " || tacInst.op == " * " || tacInst.op == " < " ||
-                       tacInst.op == " > " || tacInst.op == " == " || tacInst.op == " && " || tacInst.op == " || ") {
+            } else if (tacInst.op == tac::ADD || tacInst.op == tac::SUB || tacInst.op == tac::MUL ||
+                       tacInst.op == tac::LESS || tacInst.op == tac::GREATER || tacInst.op == tac::EQUAL ||
+                       tacInst.op == tac::AND || tacInst.op == tac::OR) {
                 // Handle binary operations
-                std::string arg1 = tacInst.arg1;
-                std::string arg2 = tacInst.arg2;
+                Symbol arg1 = tacInst.arg1;
+                Symbol arg2 = tacInst.arg2;
                 OpCode op = getOpCodeForOperation(tacInst.op, arg1, arg2);
 
-                addLoadInstruction(arg1);
-                addLoadInstruction(arg2);
-                bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(op));
-                bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(OpCode::ISTORE, tacInst.result));
-            } else if (tacInst.op == "!") {
+                addStoreInstruction(tacInst.result, [&]() {
+                    addLoadInstruction(arg1);
+                    addLoadInstruction(arg2);
+                    emit(op);
+                });
+            } else if (tacInst.op == tac::NOT) {
                 // Unary NOT operation
-                std::string arg1 = normalizeBooleanValue(tacInst.arg1);
-                addLoadInstruction(arg1);
-                bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(OpCode::INOT));
-                bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(OpCode::ISTORE, tacInst.result));
-            } else if (tacInst.op == "if") {
+                Symbol arg1 = normalizeBooleanValue(tacInst.arg1);
+                addStoreInstruction(tacInst.result, [&]() {
+                    addLoadInstruction(arg1);
+                    emit(OpCode::INOT);
+                });
+            } else if (tacInst.op == tac::LOAD_INDEX || tacInst.op == tac::LOAD_INDEX_UNCHECKED) {
+                // Array element load
+                addStoreInstruction(tacInst.result, [&]() {
+                    addLoadInstruction(tacInst.arg1);
+                    addLoadInstruction(tacInst.arg2);
+                    emit(tacInst.op == tac::LOAD_INDEX ? OpCode::IALOAD : OpCode::IALOAD_UNCHECKED);
+                });
+            } else if (tacInst.op == tac::STORE_INDEX || tacInst.op == tac::STORE_INDEX_UNCHECKED) {
+                // Array element store
+                addLoadInstruction(tacInst.result);
                 addLoadInstruction(tacInst.arg1);
-                bytecodeBlock->addInstruction(
-                    std::make_unique<BCInstruction>(OpCode::IFFALSEGOTO, block->falseExit->name));
-            } else if (tacInst.op == "call") {
-                // Process method call
-                std::string methodToCall = tacInst.arg1;
-
-                if (!pendingParams.empty()) {
-                    // Get the class reference and resolve its type
-                    std::string classRef = pendingParams[0];
-                    std::string actualClassName = typeTracker.resolveClassName(classRef);
-
-                    // Add all parameters except the first (class reference)
-                    for (int i = pendingParams.size() - 1; i > 0; i--) {
-                        addLoadInstruction(pendingParams[i]);
-                    }
-
-                    // Form the fully qualified method name
-                    size_t dotPos = methodToCall.find('.');
-                    std::string methodNamePart = methodToCall.substr(dotPos + 1);
-                    methodToCall = actualClassName + "." + methodNamePart;
-
-                    pendingParams.clear();
+                addLoadInstruction(tacInst.arg2);
+                emit(tacInst.op == tac::STORE_INDEX ? OpCode::IASTORE : OpCode::IASTORE_UNCHECKED);
+            } else if (tacInst.op == tac::LOAD_FIELD) {
+                // Field load through an object other than the receiver
+                std::string type;
+                int field = typeTracker.resolveField(tacInst.arg2, type);
+                if (field < 0) throw std::runtime_error("Unknown field: " + tacInst.arg2);
+                typeTracker.trackFieldLoad(tacInst.result, tacInst.arg2);
+                addStoreInstruction(tacInst.result, [&]() {
+                    addLoadInstruction(tacInst.arg1);
+                    emit(OpCode::GETFIELD, std::to_string(field));
+                });
+            } else if (tacInst.op == tac::STORE_FIELD) {
+                std::string type;
+                int field = typeTracker.resolveField(tacInst.arg1, type);
+                if (field < 0) throw std::runtime_error("Unknown field: " + tacInst.arg1);
+                addLoadInstruction(tacInst.result);
+                addLoadInstruction(tacInst.arg2);
+                emit(OpCode::PUTFIELD, std::to_string(field));
+            } else if (tacInst.op == tac::LENGTH) {
+                addStoreInstruction(tacInst.result, [&]() {
+                    addLoadInstruction(tacInst.arg1);
+                    emit(OpCode::ARRAYLENGTH);
+                });
+            } else if (tacInst.op == tac::NEW_ARRAY) {
+                addStoreInstruction(tacInst.result, [&]() {
+                    addLoadInstruction(tacInst.arg1);
+                    emit(OpCode::NEWARRAY);
+                });
+            } else if (tacInst.op == tac::NEW) {
+                // Object allocation, laid out like the class so that boolean fields start out as false
+                typeTracker.trackNewObject(tacInst.result, tacInst.arg1);
+                Symbol layout = typeTracker.getFieldLayout(tacInst.arg1);
+                addStoreInstruction(tacInst.result, [&]() { emit(OpCode::NEW, layout); });
+            } else if (tacInst.op == tac::IF && fusedCondition < tacInstructions.size()) {
+                // Jump to the false exit when the condition does not hold
+                const auto& condition = tacInstructions[fusedCondition];
+                if (condition.op == tac::NOT) {
+                    addLoadInstruction(normalizeBooleanValue(condition.arg1));
+                    emit(OpCode::IFNE, block->falseExit->name);
+                } else {
+                    Symbol arg1 = condition.arg1;
+                    Symbol arg2 = condition.arg2;
+                    OpCode op = getOpCodeForOperation(condition.op, arg1, arg2);
+                    addLoadInstruction(arg1);
+                    addLoadInstruction(arg2);
+                    OpCode jump = op == OpCode::ILT   ? OpCode::IF_ICMPGE
+                                  : op == OpCode::IGT ? OpCode::IF_ICMPLE
+                                                      : OpCode::IF_ICMPNE;
+                    emit(jump, block->falseExit->name);
+                }
+            } else if (tacInst.op == tac::IF) {
+                addLoadInstruction(tacInst.arg1);
+                emit(OpCode::IFFALSEGOTO, block->falseExit->name);
+            } else if (tacInst.op == tac::CALL) {
+                if (pendingParams.empty()) throw std::runtime_error("Call without receiver: " + tacInst.arg1);
+
+                // The first param is the receiver, whose class decides the method to call
+                std::string className, methodName;
+                typeTracker.resolveCall(pendingParams[0], tacInst.arg1, className, methodName);
+                for (const auto& param : pendingParams) {
+                    addLoadInstruction(param);
                 }
+                pendingParams.clear();
 
-                // Add method call instruction
-                bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(OpCode::INVOKEVIRTUAL, methodToCall));
+                emit(OpCode::INVOKEVIRTUAL, className + "." + methodName);
+                typeTracker.trackCall(tacInst.result, className, methodName);
 
                 // Store the result if needed
                 if (!tacInst.result.empty()) {
-                    bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(OpCode::ISTORE, tacInst.result));
+                    emit(OpCode::ISTORE, tacInst.result);
                 }
             } else if (tacInst.op.empty()) {
                 // Handle simple assignment
-                if (typeTracker.directClassNames.find(tacInst.arg1) == typeTracker.directClassNames.end()) {
-                    addLoadInstruction(tacInst.arg1);
-                    bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(OpCode::ISTORE, tacInst.result));
-                }
+                typeTracker.trackAssignment(tacInst.result, tacInst.arg1);
+                addStoreInstruction(tacInst.result, [&]() { addLoadInstruction(tacInst.arg1); });
             }
         }
 
         // Handle block exits
         if (block->trueExit) {
-            bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(OpCode::GOTO, block->trueExit->name));
+            emit(OpCode::GOTO, block->trueExit->name);
         } else if (stop) {
-            bytecodeBlock->addInstruction(std::make_unique<BCInstruction>(OpCode::STOP));
+            emit(OpCode::STOP);
         }
 
         blocks.emplace_back(std::move(bytecodeBlock));
@@ -187,6 +402,38 @@ std::string getOpcodeName(OpCode code) {
             return "print";
         case OpCode::STOP:
             return "stop";
+        case OpCode::NEWARRAY:
+            return "newarray";
+        case OpCode::IALOAD:
+            return "iaload";
+        case OpCode::IASTORE:
+            return "iastore";
+        case OpCode::ARRAYLENGTH:
+            return "arraylength";
+        case OpCode::NEW:
+            return "new";
+        case OpCode::GETFIELD:
+            return "getfield";
+        case OpCode::PUTFIELD:
+            return "putfield";
+        case OpCode::IFNE:
+            return "ifne";
+        case OpCode::IF_ICMPLT:
+            return "if_icmplt";
+        case OpCode::IF_ICMPGE:
+            return "if_icmpge";
+        case OpCode::IF_ICMPGT:
+            return "if_icmpgt";
+        case OpCode::IF_ICMPLE:
+            return "if_icmple";
+        case OpCode::IF_ICMPEQ:
+            return "if_icmpeq";
+        case OpCode::IF_ICMPNE:
+            return "if_icmpne";
+        case OpCode::IALOAD_UNCHECKED:
+            return "iaload_unchecked";
+        case OpCode::IASTORE_UNCHECKED:
+            return "iastore_unchecked";
         default:
             throw std::runtime_error("Unknown opcode" + std::to_string(static_cast<int>(code)));
     }
@@ -214,3 +461,107 @@ void BCProgram::print(std::ofstream& outFile) const {
         method->print(outFile);
     }
 }
+
+void BCProgram::writeBinary(std::ofstream& outFile) const {
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32_t> stringIndices;
+    std::vector<int32_t> constants;
+    std::unordered_map<int32_t, uint32_t> constantIndices;
+    std::unordered_map<std::string, uint32_t> blockIndices;
+
+    auto internString = [&](const std::string& str) {
+        auto it = stringIndices.find(str);
+        if (it != stringIndices.end()) return it->second;
+        uint32_t index = strings.size();
+        strings.push_back(str);
+        stringIndices[str] = index;
+        return index;
+    };
+
+    auto internConstant = [&](int32_t value) {
+        auto it = constantIndices.find(value);
+        if (it != constantIndices.end()) return it->second;
+        uint32_t index = constants.size();
+        constants.push_back(value);
+        constantIndices[value] = index;
+        return index;
+    };
+
+    // Block names go first so that jumps can be resolved to block indices
+    std::vector<BinaryBlock> binaryBlocks;
+    uint32_t instructionCount = 0;
+    for (const auto& block : blocks) {
+        blockIndices[block->getName()] = binaryBlocks.size();
+        uint32_t size = block->getInstructions().size();
+        binaryBlocks.push_back({internString(block->getName()), instructionCount, size});
+        instructionCount += size;
+    }
+
+    std::vector<BinaryInstruction> binaryInstructions;
+    for (const auto& block : blocks) {
+        for (const auto& instruction : block->getInstructions()) {
+            BinaryInstruction encoded = {static_cast<uint8_t>(instruction->getOpcode()), {0, 0, 0}, 0};
+            Symbol argument = instruction->getArgument();
+
+            switch (instruction->getOpcode()) {
+                case OpCode::ICONST:
+                    encoded.operand = internConstant(std::stoi(argument));
+                    break;
+                case OpCode::GETFIELD:
+                case OpCode::PUTFIELD:
+                    encoded.operand = std::stoi(argument);
+                    break;
+                case OpCode::NEW:
+                case OpCode::ILOAD:
+                case OpCode::ISTORE:
+                    encoded.operand = internString(argument);
+                    break;
+                case OpCode::GOTO:
+                case OpCode::IFFALSEGOTO:
+                case OpCode::IFNE:
+                case OpCode::IF_ICMPLT:
+                case OpCode::IF_ICMPGE:
+                case OpCode::IF_ICMPGT:
+                case OpCode::IF_ICMPLE:
+                case OpCode::IF_ICMPEQ:
+                case OpCode::IF_ICMPNE:
+                case OpCode::INVOKEVIRTUAL: {
+                    auto it = blockIndices.find(argument);
+                    if (it == blockIndices.end()) throw std::runtime_error("Jump to unknown block: " + argument);
+                    encoded.operand = it->second;
+                    break;
+                }
+                default:
+                    break;
+            }
+            binaryInstructions.push_back(encoded);
+        }
+    }
+
+    std::vector<uint32_t> stringOffsets;
+    std::string stringData;
+    for (const auto& str : strings) {
+        stringOffsets.push_back(stringData.size());
+        stringData += str;
+        stringData += '\0';
+    }
+    // Keep the sections that follow 4-byte aligned so they can be read in place
+    while (stringData.size() % 4 != 0) stringData += '\0';
+
+    BinaryHeader header = {};
+    std::copy(BYTECODE_MAGIC, BYTECODE_MAGIC + 4, header.magic);
+    header.version = BYTECODE_VERSION;
+    header.stringCount = strings.size();
+    header.stringDataSize = stringData.size();
+    header.constantCount = constants.size();
+    header.blockCount = binaryBlocks.size();
+    header.instructionCount = binaryInstructions.size();
+
+    outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    outFile.write(reinterpret_cast<const char*>(stringOffsets.data()), stringOffsets.size() * sizeof(uint32_t));
+    outFile.write(stringData.data(), stringData.size());
+    outFile.write(reinterpret_cast<const char*>(constants.data()), constants.size() * sizeof(int32_t));
+    outFile.write(reinterpret_cast<const char*>(binaryBlocks.data()), binaryBlocks.size() * sizeof(BinaryBlock));
+    outFile.write(reinterpret_cast<const char*>(binaryInstructions.data()),
+                  binaryInstructions.size() * sizeof(BinaryInstruction));
+}
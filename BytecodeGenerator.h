@@ -9,31 +9,89 @@
 #include <unordered_set>
 #include <vector>
 
+#include "BytecodeFormat.h"
 #include "IntermediateRepresentation.h"
 #include "SymbolTable.h"
 
 enum class OpCode : uint8_t {
-    ILOAD = 0,           // Load integer
-    ICONST = 1,          // Load integer constant
-    ISTORE = 2,          // Store integer
-    IADD = 3,            // Integer addition
-    ISUB = 4,            // Integer subtraction
-    IMUL = 5,            // Integer multiplication
-    IDIV = 6,            // Integer division
-    ILT = 7,             // Integer less than
-    IGT = 8,             // Integer greater than
-    IEQ = 9,             // Integer equal
-    IAND = 10,           // Integer AND
-    IOR = 11,            // Integer OR
-    INOT = 12,           // Integer NOT
-    GOTO = 13,           // Unconditional jump
-    IFFALSEGOTO = 14,    // Conditional jump
-    INVOKEVIRTUAL = 15,  // Method call
-    IRETURN = 16,        // Return integer
-    PRINT = 17,          // Print integer or boolean
-    STOP = 18            // End execution
+    ILOAD = 0,               // Load integer
+    ICONST = 1,              // Load integer constant
+    ISTORE = 2,              // Store integer
+    IADD = 3,                // Integer addition
+    ISUB = 4,                // Integer subtraction
+    IMUL = 5,                // Integer multiplication
+    IDIV = 6,                // Integer division
+    ILT = 7,                 // Integer less than
+    IGT = 8,                 // Integer greater than
+    IEQ = 9,                 // Integer equal
+    IAND = 10,               // Integer AND
+    IOR = 11,                // Integer OR
+    INOT = 12,               // Integer NOT
+    GOTO = 13,               // Unconditional jump
+    IFFALSEGOTO = 14,        // Conditional jump
+    INVOKEVIRTUAL = 15,      // Method call
+    IRETURN = 16,            // Return integer
+    PRINT = 17,              // Print integer or boolean
+    STOP = 18,               // End execution
+    NEWARRAY = 19,           // Allocate int array
+    IALOAD = 20,             // Load array element
+    IASTORE = 21,            // Store array element
+    ARRAYLENGTH = 22,        // Array length
+    NEW = 23,                // Allocate object
+    GETFIELD = 24,           // Load object field
+    PUTFIELD = 25,           // Store object field
+    IFNE = 26,               // Conditional jump if true, the inverse of IFFALSEGOTO
+    IF_ICMPLT = 27,          // Compare two integers and jump if less than
+    IF_ICMPGE = 28,          // Compare two integers and jump if greater than or equal
+    IF_ICMPGT = 29,          // Compare two integers and jump if greater than
+    IF_ICMPLE = 30,          // Compare two integers and jump if less than or equal
+    IF_ICMPEQ = 31,          // Compare two integers and jump if equal
+    IF_ICMPNE = 32,          // Compare two integers and jump if not equal
+    IALOAD_UNCHECKED = 33,   // Load array element whose index is proven within bounds
+    IASTORE_UNCHECKED = 34,  // Store array element whose index is proven within bounds
+
+    // Superinstructions, each executing the sequence it is named after. The interpreter forms them when it
+    // loads a program, they are never generated or written to bytecode files.
+    ILOAD_ILOAD = 35,
+    ILOAD_ICONST = 36,
+    ILOAD_GETFIELD = 37,
+    IADD_ISTORE = 38,
+    ISUB_ISTORE = 39,
+    ISTORE_GOTO = 40,
+    ILOAD_ILOAD_IADD = 41,
+    ILOAD_ICONST_IADD_ISTORE = 42,
+    ILOAD_ICONST_ISUB_ISTORE = 43
 };
 
+// Number of opcodes that may appear in bytecode files, one past the highest of them
+const uint8_t OPCODE_COUNT = static_cast<uint8_t>(OpCode::IASTORE_UNCHECKED) + 1;
+
+// Number of opcodes including the superinstructions, one past the highest OpCode value
+const uint8_t LINKED_OPCODE_COUNT = static_cast<uint8_t>(OpCode::ILOAD_ICONST_ISUB_ISTORE) + 1;
+
+/**
+ * @brief Checks if an opcode is a conditional jump, whose argument is the block it may jump to.
+ * @param opcode The opcode to check.
+ * @return True for IFFALSEGOTO, IFNE and the compare-and-jump opcodes.
+ */
+inline bool isConditionalJump(OpCode opcode) {
+    return opcode == OpCode::IFFALSEGOTO || (opcode >= OpCode::IFNE && opcode <= OpCode::IF_ICMPNE);
+}
+
+/**
+ * @brief Checks if an opcode jumps to the block named by its argument.
+ * @param opcode The opcode to check.
+ * @return True for GOTO and the conditional jumps.
+ */
+inline bool isJump(OpCode opcode) { return opcode == OpCode::GOTO || isConditionalJump(opcode); }
+
+/**
+ * @brief Gets the conditional jump taken exactly when another one is not.
+ * @param opcode A conditional jump.
+ * @return The inverted jump.
+ */
+OpCode invertJump(OpCode opcode);
+
 class BCBlock;
 class BCInstruction;
 
@@ -54,7 +112,14 @@ class BCProgram {
      */
     void print(std::ofstream &outFile) const;
 
+    /**
+     * @brief Writes the program in the binary bytecode format described in BytecodeFormat.h.
+     * @param outFile The file to write the program to, opened in binary mode.
+     */
+    void writeBinary(std::ofstream &outFile) const;
+
     const std::vector<std::unique_ptr<BCBlock>> &getBlocks() const { return blocks; }
+    std::vector<std::unique_ptr<BCBlock>> &getBlocks() { return blocks; }
 };
 
 class BCBlock {
@@ -84,6 +149,7 @@ class BCBlock {
      * @return The instructions of the block.
      */
     const std::vector<std::unique_ptr<BCInstruction>> &getInstructions() const { return instructions; }
+    std::vector<std::unique_ptr<BCInstruction>> &getInstructions() { return instructions; }
 
     const std::string &getName() const { return name; }
 };
@@ -91,10 +157,10 @@ class BCBlock {
 class BCInstruction {
    private:
     OpCode id;
-    std::string argument;
+    Symbol argument;
 
    public:
-    BCInstruction(OpCode id, const std::string &argument = "") : id(id), argument(argument) {}
+    BCInstruction(OpCode id, Symbol argument = Symbol()) : id(id), argument(argument) {}
 
     /**
      * @brief Prints the instruction to a file.
@@ -112,47 +178,122 @@ class BCInstruction {
      * @brief Gets the argument of the instruction.
      * @return The argument of the instruction.
      */
-    const std::string &getArgument() const { return argument; }
+    Symbol getArgument() const { return argument; }
 };
 
-// Helper class to track variable types and class references
+// Helper class to track variable types and class references within a method
 class TypeTracker {
    public:
-    std::unordered_map<std::string, std::string> tempVarTypes;
-    std::unordered_map<std::string, bool> isClassReference;
-    std::unordered_set<std::string> directClassNames;
+    TypeTracker(const SymbolTable &symbolTable) : symbolTable(symbolTable), cls(nullptr), method(nullptr) {}
+
+    /**
+     * @brief Starts tracking a new method, forgetting the types of the previous method's temporaries.
+     * @param qualifiedName The method name in the form Class.method.
+     */
+    void enterMethod(const std::string &qualifiedName);
 
-    TypeTracker(const SymbolTable &symbolTable) {
-        for (const auto &cls : symbolTable.getAllClasses()) {
-            directClassNames.insert(cls.getName());
+    /**
+     * @brief Gets the class name of a value, looking at temporaries, parameters, locals and fields in that order.
+     * @param ref The name of the value.
+     * @return The class name, or the reference itself if it has no known type.
+     */
+    std::string resolveClassName(const std::string &ref) const;
+
+    /**
+     * @brief Gets the class and method a call invokes.
+     * @param receiver The receiver, passed as the first param of the call.
+     * @param target The called method, or Class.method once the inliner has resolved the call.
+     * @param className Receives the class declaring the method.
+     * @param methodName Receives the name of the method.
+     */
+    void resolveCall(const std::string &receiver, const std::string &target, std::string &className,
+                     std::string &methodName) const;
+
+    /**
+     * @brief Looks up a field read or written through an object, as in inlined methods.
+     * @param qualifiedName The field in the form Class.field.
+     * @param type Receives the declared type of the field.
+     * @return The index of the field in the object layout, or -1 if the class has no such field.
+     */
+    int resolveField(const std::string &qualifiedName, std::string &type) const;
+
+    /**
+     * @brief Gets the index of a field of the current class, unless a parameter or local shadows it.
+     * @param name The name of the variable.
+     * @return The index of the field in the object layout, or -1 if the name is not a field.
+     */
+    int getFieldIndex(const std::string &name) const;
+
+    /**
+     * @brief Gets the declared type of a parameter, local variable or field visible in the current method.
+     * @param name The name of the variable.
+     * @return The declared type, or an empty string for temporaries.
+     */
+    std::string getDeclaredType(const std::string &name) const;
+
+    /**
+     * @brief Gets the return type of a method.
+     * @param className The class declaring the method.
+     * @param methodName The name of the method.
+     * @return The return type, or an empty string if the method is unknown.
+     */
+    std::string getReturnType(const std::string &className, const std::string &methodName) const;
+
+    /**
+     * @brief Gets the number of fields in the object layout of a class.
+     * @param className The name of the class.
+     * @return The number of fields.
+     */
+    int getFieldCount(const std::string &className) const;
+
+    /**
+     * @brief Gets the object layout of a class, as the operand of new.
+     * @param className The name of the class.
+     * @return One character per field: Z for a boolean field and I for any other.
+     */
+    std::string getFieldLayout(const std::string &className) const;
+
+    /**
+     * @brief Checks whether the current method is the static main method.
+     * @return True if the current method is main.
+     */
+    bool inMainMethod() const { return method && method->getReturnType() == "void"; }
+
+    const Method *getMethod() const { return method; }
+
+    void trackAssignment(const std::string &result, const std::string &source) {
+        std::string type = resolveClassName(source);
+        if (symbolTable.hasClass(type)) {
+            tempVarTypes[result] = type;
         }
     }
 
-    std::string resolveClassName(const std::string &ref) {
-        if (tempVarTypes.find(ref) != tempVarTypes.end()) {
-            return tempVarTypes[ref];
-        }
-        if (directClassNames.find(ref) != directClassNames.end()) {
-            return ref;
+    void trackNewObject(const std::string &var, const std::string &className) { tempVarTypes[var] = className; }
+
+    void trackFieldLoad(const std::string &result, const std::string &qualifiedName) {
+        std::string type;
+        if (resolveField(qualifiedName, type) >= 0 && symbolTable.hasClass(type)) {
+            tempVarTypes[result] = type;
         }
-        return ref;
     }
 
-    void trackAssignment(const std::string &result, const std::string &source) {
-        if (directClassNames.find(source) != directClassNames.end()) {
-            // Direct assignment of a class name
-            tempVarTypes[result] = source;
-            isClassReference[result] = true;
-        } else if (isClassReference.find(source) != isClassReference.end() && isClassReference[source]) {
-            tempVarTypes[result] = tempVarTypes[source];
-            isClassReference[result] = true;
+    void trackCall(const std::string &result, const std::string &className, const std::string &methodName) {
+        std::string returnType = getReturnType(className, methodName);
+        if (!returnType.empty()) {
+            tempVarTypes[result] = returnType;
         }
     }
 
-    void trackNewObject(const std::string &var, const std::string &className) {
-        tempVarTypes[var] = className;
-        isClassReference[var] = true;
-    }
+   private:
+    const SymbolTable &symbolTable;
+    const Class *cls;
+    const Method *method;
+    std::unordered_map<Symbol, std::string> tempVarTypes;
+
+    /**
+     * @brief Checks whether a name is a parameter or local variable of the current method.
+     */
+    bool isMethodVariable(const std::string &name) const;
 };
 
 #endif  // BYTECODEGENERATOR_H
@@ -0,0 +1,183 @@
+#include "Heap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <new>
+
+const int Heap::NURSERY_BASE;
+const size_t Heap::DEFAULT_NURSERY_WORDS;
+const size_t Heap::DEFAULT_OLD_SPACE_WORDS;
+
+Heap::Heap(size_t nurseryWords) : nursery(nurseryWords), nurseryTop(0), oldSpaceLimit(DEFAULT_OLD_SPACE_WORDS) {
+    reset();
+}
+
+void Heap::reset() {
+    std::fill(nursery.begin(), nursery.end(), StackValue());
+    nurseryTop = 0;
+
+    // Address 0 is reserved for null
+    oldSpace.assign(1, StackValue());
+    oldSpaceLimit = DEFAULT_OLD_SPACE_WORDS;
+    rememberedSet.clear();
+    remembered.clear();
+    stats = HeapStats();
+}
+
+int Heap::allocate(int size) {
+    if (isLarge(size) || nurseryTop + 1 + size > nursery.size()) {
+        // Old space addresses have to stay below the nursery
+        if (oldSpace.size() + 1 + size > static_cast<size_t>(NURSERY_BASE)) return 0;
+        int address;
+        try {
+            address = allocateOld(size);
+        } catch (const std::bad_alloc &) {
+            return 0;
+        }
+        stats.allocatedWords += static_cast<uint64_t>(size) + 1;
+        return address;
+    }
+    stats.allocatedWords += static_cast<uint64_t>(size) + 1;
+
+    // The nursery is zeroed when it is emptied, only the header has to be written
+    int address = NURSERY_BASE + static_cast<int>(nurseryTop);
+    nursery[nurseryTop] = StackValue(size);
+    nurseryTop += 1 + size;
+    return address;
+}
+
+int Heap::allocateOld(int size) {
+    // A single resize leaves the old space as it was when it runs out of memory
+    int address = static_cast<int>(oldSpace.size());
+    oldSpace.resize(oldSpace.size() + 1 + size, StackValue());
+    oldSpace[address] = StackValue(size);
+    return address;
+}
+
+void Heap::remember(int address) {
+    if (remembered.size() < oldSpace.size()) remembered.resize(oldSpace.size(), false);
+    if (remembered[address]) return;
+    remembered[address] = true;
+    rememberedSet.push_back(address);
+}
+
+void Heap::collect(const std::vector<StackValue *> &roots) {
+    auto start = std::chrono::steady_clock::now();
+
+    collectNursery(roots);
+    stats.minorCollections++;
+
+    // Compact before the next round of promotions could push the old space past its limit
+    if (oldSpace.size() + nursery.size() > oldSpaceLimit) {
+        compactOldSpace(roots);
+        stats.majorCollections++;
+        oldSpaceLimit = std::max(DEFAULT_OLD_SPACE_WORDS, 2 * oldSpace.size() + nursery.size());
+    }
+
+    std::chrono::duration<double, std::milli> pause = std::chrono::steady_clock::now() - start;
+    stats.totalPauseMs += pause.count();
+    stats.maxPauseMs = std::max(stats.maxPauseMs, pause.count());
+}
+
+int Heap::evacuate(int address) {
+    // A forwarded object has its header replaced by a reference to the copy
+    size_t offset = address - NURSERY_BASE;
+    if (!nursery[offset].isReference) {
+        int size = nursery[offset].value;
+        int copy = allocateOld(size);
+        std::copy_n(nursery.begin() + offset + 1, size, oldSpace.begin() + copy + 1);
+        stats.promotedWords += static_cast<uint64_t>(size) + 1;
+        nursery[offset] = StackValue::reference(copy);
+    }
+    return nursery[offset].value;
+}
+
+void Heap::evacuateFields(size_t address) {
+    // Evacuating appends to the old space, so fields are addressed by index rather than by reference
+    int size = oldSpace[address].value;
+    for (size_t field = address + 1; field <= address + size; field++) {
+        if (oldSpace[field].isReference && oldSpace[field].value >= NURSERY_BASE) {
+            int copy = evacuate(oldSpace[field].value);
+            oldSpace[field].value = copy;
+        }
+    }
+}
+
+void Heap::collectNursery(const std::vector<StackValue *> &roots) {
+    size_t scan = oldSpace.size();
+
+    for (StackValue *root : roots) {
+        if (root->isReference && root->value >= NURSERY_BASE) root->value = evacuate(root->value);
+    }
+    for (int address : rememberedSet) {
+        evacuateFields(address);
+        remembered[address] = false;
+    }
+    rememberedSet.clear();
+
+    // Scan the promoted objects in the order they were copied until no new ones appear
+    while (scan < oldSpace.size()) {
+        evacuateFields(scan);
+        scan += 1 + oldSpace[scan].value;
+    }
+
+    std::fill_n(nursery.begin(), nurseryTop, StackValue());
+    nurseryTop = 0;
+}
+
+void Heap::compactOldSpace(const std::vector<StackValue *> &roots) {
+    // Mark everything reachable from the roots
+    std::vector<bool> marked(oldSpace.size(), false);
+    std::vector<int> pending;
+    for (StackValue *root : roots) {
+        if (root->isReference && root->value != 0) pending.push_back(root->value);
+    }
+    while (!pending.empty()) {
+        int address = pending.back();
+        pending.pop_back();
+        if (marked[address]) continue;
+        marked[address] = true;
+
+        int size = oldSpace[address].value;
+        for (int i = 1; i <= size; i++) {
+            const StackValue &field = oldSpace[address + i];
+            if (field.isReference && field.value != 0 && !marked[field.value]) pending.push_back(field.value);
+        }
+    }
+
+    // Assign every live object its address after sliding
+    std::vector<int> forwarding(oldSpace.size(), 0);
+    size_t free = 1;
+    for (size_t address = 1; address < oldSpace.size(); address += 1 + oldSpace[address].value) {
+        if (!marked[address]) continue;
+        forwarding[address] = static_cast<int>(free);
+        free += 1 + oldSpace[address].value;
+    }
+
+    // Redirect the roots and the fields of live objects
+    for (StackValue *root : roots) {
+        if (root->isReference && root->value != 0) root->value = forwarding[root->value];
+    }
+    for (size_t address = 1; address < oldSpace.size(); address += 1 + oldSpace[address].value) {
+        if (!marked[address]) continue;
+        int size = oldSpace[address].value;
+        for (int i = 1; i <= size; i++) {
+            StackValue &field = oldSpace[address + i];
+            if (field.isReference && field.value != 0) field.value = forwarding[field.value];
+        }
+    }
+
+    // Slide the live objects down. Objects only move towards lower addresses, so copying in order is safe.
+    size_t address = 1;
+    while (address < oldSpace.size()) {
+        size_t next = address + 1 + oldSpace[address].value;
+        if (marked[address]) {
+            std::copy(oldSpace.begin() + address, oldSpace.begin() + next, oldSpace.begin() + forwarding[address]);
+        }
+        address = next;
+    }
+    oldSpace.resize(free);
+
+    // Give memory back when the heap has shrunk substantially
+    if (oldSpace.capacity() > 4 * std::max(free, DEFAULT_OLD_SPACE_WORDS)) oldSpace.shrink_to_fit();
+}
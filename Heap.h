@@ -0,0 +1,173 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct StackValue {
+    int value;
+    bool isBoolean;
+    bool isReference;  // Value is a heap address
+
+    StackValue() : value(0), isBoolean(false), isReference(false) {}
+    StackValue(int v, bool b = false) : value(v), isBoolean(b), isReference(false) {}
+
+    static StackValue reference(int address) {
+        StackValue ref(address);
+        ref.isReference = true;
+        return ref;
+    }
+};
+
+// Counters describing the work done by the garbage collector.
+struct HeapStats {
+    size_t minorCollections = 0;
+    size_t majorCollections = 0;
+    uint64_t allocatedWords = 0;
+    uint64_t promotedWords = 0;
+    double totalPauseMs = 0;
+    double maxPauseMs = 0;
+};
+
+/*
+ * Generational heap for objects and int arrays.
+ *
+ * Every allocation is a header word holding the number of payload words, followed by the payload:
+ * the fields of an object or the elements of an array. New objects are bump-allocated in the nursery.
+ * A minor collection copies the live nursery objects into the old space. When the old space outgrows
+ * its limit, a major collection marks it and slides the live objects together.
+ *
+ * The collector is precise: a word is a pointer exactly when its StackValue is a reference. Stores
+ * of nursery pointers into old objects are recorded by a write barrier so that minor collections
+ * only have to scan the roots and the remembered objects.
+ *
+ * Address 0 stands for null. Nursery addresses start at NURSERY_BASE, old space addresses are below.
+ */
+class Heap {
+   public:
+    static const int NURSERY_BASE = 1 << 30;
+    static const size_t DEFAULT_NURSERY_WORDS = 1 << 16;
+    static const size_t DEFAULT_OLD_SPACE_WORDS = 1 << 18;
+
+    explicit Heap(size_t nurseryWords = DEFAULT_NURSERY_WORDS);
+
+    /**
+     * @brief Frees every object and resets the statistics
+     */
+    void reset();
+
+    /**
+     * @brief Checks whether an allocation fits without collecting first
+     * @param size The number of payload words
+     * @return True if allocate can be called right away
+     */
+    bool canAllocate(int size) const {
+        if (isLarge(size)) return oldSpace.size() + 1 + size <= oldSpaceLimit;
+        return nurseryTop + 1 + size <= nursery.size();
+    }
+
+    /**
+     * @brief Allocates a zeroed object or array. Call collect first unless canAllocate holds.
+     * @param size The number of payload words
+     * @return The address of the allocation, or 0 when the heap is out of memory
+     */
+    int allocate(int size);
+
+    /**
+     * @brief Collects garbage. Always empties the nursery and compacts the old space when it is full.
+     * @param roots Every reference outside the heap. They are updated when their objects move.
+     */
+    void collect(const std::vector<StackValue *> &roots);
+
+    /**
+     * @brief Gets the number of payload words of an allocation
+     * @param address The address of the allocation
+     * @return The array length or field count
+     */
+    int sizeOf(int address) const { return word(address).value; }
+
+    /**
+     * @brief Reads a payload word
+     * @param address The address of the allocation
+     * @param index The field or element index
+     * @return The stored value
+     */
+    const StackValue &load(int address, int index) const { return word(address + 1 + index); }
+
+    /**
+     * @brief Writes a payload word, remembering old objects that start pointing into the nursery
+     * @param address The address of the allocation
+     * @param index The field or element index
+     * @param value The value to store
+     */
+    void store(int address, int index, const StackValue &value) {
+        if (address < NURSERY_BASE) {
+            oldSpace[address + 1 + index] = value;
+            if (value.isReference && value.value >= NURSERY_BASE) remember(address);
+        } else {
+            nursery[address - NURSERY_BASE + 1 + index] = value;
+        }
+    }
+
+    const HeapStats &getStats() const { return stats; }
+
+   private:
+    std::vector<StackValue> nursery;
+    size_t nurseryTop;
+    std::vector<StackValue> oldSpace;
+    size_t oldSpaceLimit;
+
+    // Old objects that may point into the nursery, with a flag per old space word to avoid duplicates
+    std::vector<int> rememberedSet;
+    std::vector<bool> remembered;
+
+    HeapStats stats;
+
+    const StackValue &word(int address) const {
+        return address < NURSERY_BASE ? oldSpace[address] : nursery[address - NURSERY_BASE];
+    }
+
+    // Objects that would take up a large part of the nursery go straight to the old space
+    bool isLarge(int size) const { return static_cast<size_t>(size) + 1 > nursery.size() / 4; }
+
+    /**
+     * @brief Appends an allocation to the old space
+     * @param size The number of payload words
+     * @return The address of the allocation
+     */
+    int allocateOld(int size);
+
+    /**
+     * @brief Adds an old object to the remembered set
+     * @param address The address of the object
+     */
+    void remember(int address);
+
+    /**
+     * @brief Copies every live nursery object into the old space and empties the nursery
+     * @param roots The references outside the heap
+     */
+    void collectNursery(const std::vector<StackValue *> &roots);
+
+    /**
+     * @brief Moves a nursery object into the old space, leaving a forwarding address behind
+     * @param address The nursery address of the object
+     * @return The address of the object in the old space
+     */
+    int evacuate(int address);
+
+    /**
+     * @brief Evacuates the nursery objects referenced by the fields of an old object
+     * @param address The address of the old object
+     */
+    void evacuateFields(size_t address);
+
+    /**
+     * @brief Marks the live old space objects and slides them to the start of the old space
+     * @param roots The references outside the heap. The nursery must be empty.
+     */
+    void compactOldSpace(const std::vector<StackValue *> &roots);
+};
+
+#endif  // HEAP_H
@@ -1,6 +1,11 @@
 #ifndef HELPERFUNCTIONS_H
 #define HELPERFUNCTIONS_H
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+
 #include "Node.h"
+#include "TacSymbols.h"
 
 // Define colors for error messages
 #define RESET "\033[0m"
@@ -11,16 +16,16 @@
 #define PURPLE "\033[35m"
 
 /**
- * @brief Finds a child node with a specific type and occurrence.
+ * @brief Finds a child node with a specific kind and occurrence.
  * @param node The parent node.
- * @param type The type of the child node to find.
+ * @param kind The kind of the child node to find.
  * @param occurrence The occurrence of the child node to find.
  * @return The child node if found, otherwise nullptr.
  */
-inline Node *findChild(Node *node, const std::string &type, int occurrence = 1) {
+inline Node *findChild(Node *node, NodeKind kind, int occurrence = 1) {
     int count = 1;
     for (auto child : node->children) {
-        if (child->type == type) {
+        if (child->kind == kind) {
             if (count == occurrence) {
                 return child;
             }
@@ -31,55 +36,57 @@ inline Node *findChild(Node *node, const std::string &type, int occurrence = 1)
 }
 
 /**
- * @brief Checks if a string ends with a specific suffix.
- * @param str The string to check.
- * @param suffix The suffix to check for.
- * @return True if the string ends with the suffix, otherwise false.
+ * @brief Checks if a node kind is a statement.
+ * @param kind The node kind to check.
+ * @return True if the node kind is a statement, otherwise false.
  */
-inline bool endsWith(const std::string &str, const std::string &suffix) {
-    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
-}
+inline bool isStatement(NodeKind kind) { return kind >= NodeKind::IfStatement && kind <= NodeKind::ArrayInitStatement; }
 
 /**
- * @brief Checks if an expression type is a unary expression.
- * @param type The expression type to check.
- * @return True if the expression type is a unary expression, otherwise false.
+ * @brief Checks if an expression kind is a unary expression.
+ * @param kind The expression kind to check.
+ * @return True if the expression kind is a unary expression, otherwise false.
  */
-inline bool isUnaryExpression(const std::string &type) {
-    return type == "NotExpression" || type == "LengthExpression" || type == "NewIntArrayExpression";
+inline bool isUnaryExpression(NodeKind kind) {
+    return kind == NodeKind::NotExpression || kind == NodeKind::LengthExpression ||
+           kind == NodeKind::NewIntArrayExpression;
 }
 
 /**
- * @brief Checks if an expression type is an arithmetic expression.
- * @param type The expression type to check.
- * @return True if the expression type is an arithmetic expression, otherwise false.
+ * @brief Checks if an expression kind is an arithmetic expression.
+ * @param kind The expression kind to check.
+ * @return True if the expression kind is an arithmetic expression, otherwise false.
  */
-inline bool isArithmeticExpression(const std::string &type) {
-    return type == "AddExpression" || type == "SubExpression" || type == "MultExpression";
+inline bool isArithmeticExpression(NodeKind kind) {
+    return kind == NodeKind::AddExpression || kind == NodeKind::SubExpression || kind == NodeKind::MultExpression;
 }
 
 /**
- * @brief Checks if an expression type is a logical expression.
- * @param type The expression type to check.
- * @return True if the expression type is a logical expression, otherwise false.
+ * @brief Checks if an expression kind is a logical expression.
+ * @param kind The expression kind to check.
+ * @return True if the expression kind is a logical expression, otherwise false.
  */
-inline bool isLogicalExpression(const std::string &type) { return type == "AndExpression" || type == "OrExpression"; }
+inline bool isLogicalExpression(NodeKind kind) {
+    return kind == NodeKind::AndExpression || kind == NodeKind::OrExpression;
+}
 
 /**
- * @brief Checks if an expression type is a comparison expression.
- * @param type The expression type to check.
- * @return True if the expression type is a comparison expression, otherwise false.
+ * @brief Checks if an expression kind is a comparison expression.
+ * @param kind The expression kind to check.
+ * @return True if the expression kind is a comparison expression, otherwise false.
  */
-inline bool isComparisonExpression(const std::string &type) { return type == "LTExpression" || type == "GTExpression"; }
+inline bool isComparisonExpression(NodeKind kind) {
+    return kind == NodeKind::LTExpression || kind == NodeKind::GTExpression;
+}
 
 /**
- * @brief Checks if an expression type is a binary expression.
- * @param type The expression type to check.
- * @return True if the expression type is a binary expression, otherwise false.
+ * @brief Checks if an expression kind is a binary expression.
+ * @param kind The expression kind to check.
+ * @return True if the expression kind is a binary expression, otherwise false.
  */
-inline bool isBinaryExpression(const std::string &type) {
-    return isArithmeticExpression(type) || isLogicalExpression(type) || isComparisonExpression(type) ||
-           type == "EqualExpression" || type == "ArrayExpression";
+inline bool isBinaryExpression(NodeKind kind) {
+    return isArithmeticExpression(kind) || isLogicalExpression(kind) || isComparisonExpression(kind) ||
+           kind == NodeKind::EqualExpression || kind == NodeKind::ArrayExpression;
 }
 
 /**
@@ -91,38 +98,91 @@ inline bool isValidEqualityType(const std::string &type) {
     return type == "Int" || type == "Bool" || type == "IntArray";
 }
 
-inline bool isLiteral(const std::string &type) { return type == "IntLiteral" || type == "BoolLiteral"; }
+inline bool isLiteral(NodeKind kind) { return kind == NodeKind::IntLiteral || kind == NodeKind::BoolLiteral; }
+
+/**
+ * @brief Gets the TAC operator for a given expression kind.
+ * @param kind The expression kind.
+ * @return The operator.
+ */
+inline Symbol getOperator(NodeKind kind) {
+    switch (kind) {
+        case NodeKind::AddExpression:
+            return tac::ADD;
+        case NodeKind::SubExpression:
+            return tac::SUB;
+        case NodeKind::MultExpression:
+            return tac::MUL;
+        case NodeKind::AndExpression:
+            return tac::AND;
+        case NodeKind::OrExpression:
+            return tac::OR;
+        case NodeKind::LTExpression:
+            return tac::LESS;
+        case NodeKind::GTExpression:
+            return tac::GREATER;
+        case NodeKind::EqualExpression:
+            return tac::EQUAL;
+        case NodeKind::ArrayExpression:
+            return tac::LOAD_INDEX;
+        case NodeKind::NotExpression:
+            return tac::NOT;
+        case NodeKind::LengthExpression:
+            return tac::LENGTH;
+        case NodeKind::NewIntArrayExpression:
+            return tac::NEW_ARRAY;
+        default:
+            throw std::runtime_error("Couldn't get operator for expression type: " + getKindName(kind));
+    }
+}
+
+/**
+ * @brief Checks if a name is a temporary of the TAC, _t followed by its number.
+ * @param name The name to check.
+ * @return True if the name is a temporary, otherwise false.
+ */
+inline bool isTemporary(const std::string &name) {
+    return name.size() > 2 && name.compare(0, 2, "_t") == 0 &&
+           name.find_first_not_of("0123456789", 2) == std::string::npos;
+}
+
+/**
+ * @brief Gets the value of an integer literal, including the negative literals folding produces.
+ * @param name The name to parse.
+ * @param value Set to the value of the literal.
+ * @return True if the name is an integer literal that fits in 32 bits, which the interpreter would accept.
+ */
+inline bool parseIntegerLiteral(const std::string &name, int32_t &value) {
+    size_t digits = !name.empty() && name[0] == '-' ? 1 : 0;
+    if (name.size() <= digits || name.find_first_not_of("0123456789", digits) != std::string::npos) return false;
+    errno = 0;
+    long long parsed = std::strtoll(name.c_str(), nullptr, 10);
+    if (errno == ERANGE || parsed < INT32_MIN || parsed > INT32_MAX) return false;
+    value = static_cast<int32_t>(parsed);
+    return true;
+}
 
 /**
- * @brief Gets the operator string for a given expression type.
- * @param expressionType The expression type.
- * @return The operator string.
+ * @brief Gets the value of a boolean literal.
+ * @param name The name to parse.
+ * @param value Set to the value of the literal.
+ * @return True if the name is a boolean literal.
  */
-inline std::string getOperator(const std::string &expressionType) {
-    if (expressionType == "AddExpression") return " + ";
-    if (expressionType == "SubExpression") return " - ";
-    if (expressionType == "MultExpression") return " * ";
-    if (expressionType == "AndExpression") return " && ";
-    if (expressionType == "OrExpression") return " || ";
-    if (expressionType == "LTExpression") return " < ";
-    if (expressionType == "GTExpression") return " > ";
-    if (expressionType == "EqualExpression") return " == ";
-    if (expressionType == "ArrayExpression") return "[";
-    if (expressionType == "NotExpression") return "!";
-    if (expressionType == "LengthExpression") return "length ";
-    if (expressionType == "NewIntArrayExpression") return "new int[";
-    throw std::runtime_error("Couldn't get operator for expression type: " + expressionType);
+inline bool parseBooleanLiteral(const std::string &name, bool &value) {
+    if (name != "true" && name != "false") return false;
+    value = name == "true";
+    return true;
 }
 
 /**
- * @brief Gets the color string for a given expression type.
- * @param expressionType The expression type.
+ * @brief Gets the color string for a given expression kind.
+ * @param kind The expression kind.
  * @return The color string.
  */
-inline std::string getColor(const std::string &expressionType) {
-    if (isArithmeticExpression(expressionType)) return BLUE;
-    if (isLogicalExpression(expressionType)) return RED;
-    if (isComparisonExpression(expressionType)) return RED;
+inline std::string getColor(NodeKind kind) {
+    if (isArithmeticExpression(kind)) return BLUE;
+    if (isLogicalExpression(kind)) return RED;
+    if (isComparisonExpression(kind)) return RED;
     return RED;
 }
 
@@ -0,0 +1,492 @@
+#include "Inliner.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+#include "BytecodeGenerator.h"
+#include "RegisterAllocator.h"
+
+namespace {
+
+// A TAC instruction detached from its block
+struct Instruction {
+    Symbol result;
+    Symbol arg1;
+    Symbol op;
+    Symbol arg2;
+};
+
+// A method as it was before inlining, with what is needed to copy it into a caller
+struct Callee {
+    std::string className;
+    std::vector<std::vector<Instruction>> blocks;  // In layout order, starting with the entry
+    std::vector<int> trueExits;                    // Block indices, or -1
+    std::vector<int> falseExits;
+    std::vector<std::string> parameters;
+    std::set<std::string> assignedParameters;
+    std::set<std::string> fields;  // Fields of the class the method reads or writes
+    std::vector<std::pair<std::string, std::string>> uninitializedLocals;  // Read before written, with their type
+};
+
+bool isConstant(Symbol name) {
+    if (name == tac::TRUE_LITERAL || name == tac::FALSE_LITERAL) return true;
+    const std::string &text = name.str();
+    size_t digits = !text.empty() && text[0] == '-' ? 1 : 0;
+    return text.size() > digits && text.find_first_not_of("0123456789", digits) == std::string::npos;
+}
+
+std::vector<Instruction> readInstructions(const BasicBlock *block) {
+    std::vector<Instruction> instructions;
+    for (const auto &tacInst : block->getTacInstructions()) {
+        instructions.push_back({tacInst.result, tacInst.arg1, tacInst.op, tacInst.arg2});
+    }
+    return instructions;
+}
+
+void writeInstructions(BasicBlock *block, const std::vector<Instruction> &instructions) {
+    block->clearInstructions();
+    for (const auto &instruction : instructions) {
+        block->addInstruction(instruction.result, instruction.arg1, instruction.op, instruction.arg2);
+    }
+}
+
+// Calls a function for every operand that holds a value, telling whether the instruction writes it
+void forEachOperand(Instruction &instruction, const std::function<void(Symbol &, bool)> &visit) {
+    Symbol op = instruction.op;
+    if (op == tac::PARAM || op == tac::PRINT || op == tac::IF || op == tac::RETURN) {
+        visit(instruction.arg1, false);
+    } else if (op == tac::STORE_INDEX) {
+        visit(instruction.result, false);
+        visit(instruction.arg1, false);
+        visit(instruction.arg2, false);
+    } else if (op == tac::STORE_FIELD) {
+        visit(instruction.result, false);
+        visit(instruction.arg2, false);
+    } else if (op == tac::NEW || op == tac::CALL) {
+        if (!instruction.result.empty()) visit(instruction.result, true);
+    } else {
+        visit(instruction.arg1, false);
+        if (op != tac::LOAD_FIELD && !instruction.arg2.empty()) visit(instruction.arg2, false);
+        visit(instruction.result, true);
+    }
+}
+
+// Tells whether a value is returned as it is from an instruction on, copied only into temporaries along the way
+bool isReturned(const BasicBlock *block, size_t start, Symbol value) {
+    std::set<const BasicBlock *> visited;
+    while (block && visited.insert(block).second) {
+        std::vector<Instruction> instructions = readInstructions(block);
+        for (size_t i = start; i < instructions.size(); i++) {
+            const Instruction &instruction = instructions[i];
+            if (instruction.op == tac::RETURN) return instruction.arg1 == value;
+            if (!instruction.op.empty() || instruction.arg1 != value || !isTemporary(instruction.result)) return false;
+            value = instruction.result;
+        }
+        if (block->falseExit) return false;
+        block = block->trueExit;
+        start = 0;
+    }
+    return false;
+}
+
+// Splits the blocks into methods. Duplicate methods share a name, but each starts with an entry block of its own.
+std::vector<std::pair<size_t, size_t>> getMethodRanges(const std::vector<BasicBlock *> &blocks) {
+    std::vector<std::pair<size_t, size_t>> ranges;
+    size_t first = 0;
+    while (first < blocks.size()) {
+        size_t last = first + 1;
+        while (last < blocks.size() && blocks[last]->method == blocks[first]->method &&
+               blocks[last]->name != blocks[last]->method) {
+            last++;
+        }
+        ranges.emplace_back(first, last);
+        first = last;
+    }
+    return ranges;
+}
+
+/**
+ * @brief Copies a method in place of a call, splitting the calling block around it.
+ * @param block The calling block, which keeps the instructions before the call.
+ * @param instructions The instructions of the calling block.
+ * @param call The index of the call instruction.
+ * @param callee The called method.
+ * @param caller The type tracker of the calling method.
+ * @param nextTemporary The number of the next fresh temporary of the calling method.
+ * @param layout Receives the copied blocks.
+ * @param resume Receives the index of the first instruction after the inlined code in the returned block.
+ * @return The block holding the instructions after the call, which is the calling block itself when the
+ * callee is a single block.
+ */
+BasicBlock *inlineCall(BasicBlock *block, const std::vector<Instruction> &instructions, size_t call,
+                       const Callee &callee, const TypeTracker &caller, int &nextTemporary,
+                       std::vector<BasicBlock *> &layout, size_t &resume) {
+    auto fresh = [&]() { return Symbol("_t" + std::to_string(nextTemporary++)); };
+    size_t firstParam = call - callee.parameters.size() - 1;
+    std::vector<Instruction> entry(instructions.begin(), instructions.begin() + firstParam);
+
+    // Arguments are used in place unless the callee writes its parameter or the argument is a field, which
+    // the callee may write through the receiver
+    std::unordered_map<Symbol, Symbol> names;
+    auto bind = [&](Symbol name, Symbol argument, bool assigned) {
+        if (!assigned && caller.getFieldIndex(argument) < 0) {
+            names[name] = argument;
+        } else {
+            names[name] = fresh();
+            entry.push_back({names[name], argument, Symbol(), Symbol()});
+        }
+    };
+    bind(tac::THIS, instructions[firstParam].arg1, false);
+    for (size_t i = 0; i < callee.parameters.size(); i++) {
+        Symbol parameter = callee.parameters[i];
+        bind(parameter, instructions[firstParam + 1 + i].arg1, callee.assignedParameters.count(parameter) > 0);
+    }
+
+    // Locals start out empty on every call, not with the value of the previous one
+    for (const auto &local : callee.uninitializedLocals) {
+        names[local.first] = fresh();
+        Symbol initial = local.second == "Bool" ? tac::FALSE_LITERAL : tac::ZERO;
+        entry.push_back({names[local.first], initial, Symbol(), Symbol()});
+    }
+
+    // A field the caller sees under the same name, on the same object, is accessed directly
+    Symbol receiver = names[tac::THIS];
+    std::string callerClass = block->method.substr(0, block->method.find('.'));
+    auto isDirect = [&](const std::string &field) {
+        return receiver == tac::THIS && callee.className == callerClass && caller.getFieldIndex(field) >= 0;
+    };
+
+    // Copy the callee's blocks, renaming its variables and turning its return into a copy
+    std::vector<std::vector<Instruction>> copiedCode(callee.blocks.size());
+    std::vector<bool> returns(callee.blocks.size(), false);
+    for (size_t i = 0; i < callee.blocks.size(); i++) {
+        std::vector<Instruction> &code = copiedCode[i];
+        for (Instruction instruction : callee.blocks[i]) {
+            std::vector<Instruction> stores;
+            forEachOperand(instruction, [&](Symbol &operand, bool written) {
+                if (operand.empty() || isConstant(operand) || (callee.fields.count(operand) && isDirect(operand))) {
+                    return;
+                } else if (callee.fields.count(operand)) {
+                    Symbol field = callee.className + "." + operand;
+                    operand = fresh();
+                    if (written) {
+                        stores.push_back({receiver, field, tac::STORE_FIELD, operand});
+                    } else {
+                        code.push_back({operand, receiver, tac::LOAD_FIELD, field});
+                    }
+                } else {
+                    auto it = names.find(operand);
+                    operand = it != names.end() ? it->second : (names[operand] = fresh());
+                }
+            });
+            Symbol result = instructions[call].result;
+            if (instruction.op == tac::RETURN) {
+                returns[i] = true;
+                if (!result.empty()) code.push_back({result, instruction.arg1, Symbol(), Symbol()});
+            } else if (instruction.op.empty() && stores.size() == 1) {
+                stores.front().arg2 = instruction.arg1;  // A copy into a field is a store of its source
+            } else {
+                code.push_back(instruction);
+            }
+            code.insert(code.end(), stores.begin(), stores.end());
+        }
+    }
+
+    // A single block goes right in place of the call
+    std::vector<Instruction> rest(instructions.begin() + call + 1, instructions.end());
+    if (callee.blocks.size() == 1) {
+        entry.insert(entry.end(), copiedCode.front().begin(), copiedCode.front().end());
+        resume = entry.size();
+        entry.insert(entry.end(), rest.begin(), rest.end());
+        writeInstructions(block, entry);
+        return block;
+    }
+
+    BasicBlock *continuation = new BasicBlock();
+    continuation->method = block->method;
+    continuation->trueExit = block->trueExit;
+    continuation->falseExit = block->falseExit;
+    writeInstructions(continuation, rest);
+
+    std::vector<BasicBlock *> copies;
+    for (size_t i = 0; i < callee.blocks.size(); i++) {
+        copies.push_back(new BasicBlock());
+        copies.back()->method = block->method;
+    }
+    for (size_t i = 0; i < callee.blocks.size(); i++) {
+        writeInstructions(copies[i], copiedCode[i]);
+        copies[i]->trueExit = returns[i]                  ? continuation
+                              : callee.trueExits[i] >= 0 ? copies[callee.trueExits[i]]
+                                                         : nullptr;
+        copies[i]->falseExit = callee.falseExits[i] >= 0 ? copies[callee.falseExits[i]] : nullptr;
+    }
+
+    writeInstructions(block, entry);
+    block->trueExit = copies.front();
+    block->falseExit = nullptr;
+    layout.insert(layout.end(), copies.begin(), copies.end());
+    resume = 0;
+    return continuation;
+}
+
+}  // namespace
+
+int Inliner::run(ControlFlowGraph &cfg, const SymbolTable &symbolTable) {
+    std::vector<BasicBlock *> &blocks = cfg.getBlocks();
+    std::vector<std::pair<size_t, size_t>> ranges = getMethodRanges(blocks);
+    TypeTracker typeTracker(symbolTable);
+
+    // Resolve every call by the type of its receiver, tracking types in layout order like the generators do
+    std::string currentMethod;
+    for (BasicBlock *block : blocks) {
+        if (block->method != currentMethod) {
+            currentMethod = block->method;
+            typeTracker.enterMethod(currentMethod);
+        }
+        std::vector<Instruction> instructions = readInstructions(block);
+        std::vector<Symbol> pendingParams;
+        for (auto &instruction : instructions) {
+            if (instruction.op == tac::PARAM) {
+                pendingParams.push_back(instruction.arg1);
+            } else if (instruction.op == tac::CALL) {
+                std::string className = pendingParams.empty() ? "" : typeTracker.resolveClassName(pendingParams[0]);
+                if (symbolTable.hasClass(className) && symbolTable.getClass(className).hasMethod(instruction.arg1)) {
+                    typeTracker.trackCall(instruction.result, className, instruction.arg1);
+                    instruction.arg1 = className + "." + instruction.arg1;
+                }
+                pendingParams.clear();
+            } else if (instruction.op == tac::NEW) {
+                typeTracker.trackNewObject(instruction.result, instruction.arg1);
+            } else if (instruction.op.empty()) {
+                typeTracker.trackAssignment(instruction.result, instruction.arg1);
+            }
+        }
+        writeInstructions(block, instructions);
+    }
+
+    // Take copies of the methods that are small enough, before any of them changes
+    std::map<std::string, int> definitions;
+    for (const auto &range : ranges) definitions[blocks[range.first]->method]++;
+    std::map<std::string, Callee> callees;
+    for (const auto &range : ranges) {
+        const std::string &name = blocks[range.first]->method;
+        if (definitions[name] > 1 || blocks[range.first]->name != name) continue;
+        typeTracker.enterMethod(name);
+        const Method *method = typeTracker.getMethod();
+        if (!method || typeTracker.inMainMethod()) continue;
+
+        std::vector<const BasicBlock *> methodBlocks(blocks.begin() + range.first, blocks.begin() + range.second);
+        std::unordered_map<const BasicBlock *, int> indices = {{nullptr, -1}};
+        for (size_t i = 0; i < methodBlocks.size(); i++) indices[methodBlocks[i]] = i;
+
+        Callee callee;
+        callee.className = name.substr(0, name.find('.'));
+        for (const auto &parameter : method->getParameters()) callee.parameters.push_back(parameter.getName());
+        int size = 0;
+        bool inlinable = true;
+        std::set<std::string> assigned;
+        for (const BasicBlock *block : methodBlocks) {
+            std::vector<Instruction> instructions = readInstructions(block);
+            size += instructions.size();
+            for (auto &instruction : instructions) {
+                // Calls left unresolved are resolved by the receiver's type, which is lost once it is renamed
+                if (instruction.op == tac::CALL && instruction.arg1.str().find('.') == std::string::npos) {
+                    inlinable = false;
+                }
+                forEachOperand(instruction, [&](Symbol &operand, bool written) {
+                    if (typeTracker.getFieldIndex(operand) >= 0) callee.fields.insert(operand);
+                    if (written) assigned.insert(operand);
+                });
+            }
+            if (!indices.count(block->trueExit) || !indices.count(block->falseExit)) inlinable = false;
+            callee.blocks.push_back(std::move(instructions));
+            callee.trueExits.push_back(indices[block->trueExit]);
+            callee.falseExits.push_back(indices[block->falseExit]);
+        }
+        if (!inlinable || size > budget) continue;
+
+        LivenessAnalysis liveness(methodBlocks, [&](const std::string &operand) {
+            return method->isLocalVariable(operand) &&
+                   !std::count(callee.parameters.begin(), callee.parameters.end(), operand);
+        });
+        for (const auto &local : liveness.getLiveIn(methodBlocks.front())) {
+            callee.uninitializedLocals.emplace_back(local, typeTracker.getDeclaredType(local));
+            inlinable = inlinable && assigned.count(local);  // Never stored, which the interpreter reports
+        }
+        for (const auto &parameter : callee.parameters) {
+            if (assigned.count(parameter)) callee.assignedParameters.insert(parameter);
+        }
+        if (inlinable) callees[name] = std::move(callee);
+    }
+
+    // Inline into every method, continuing after each inlined call with the rest of the calling block
+    int inlined = 0;
+    std::vector<BasicBlock *> layout;
+    for (const auto &range : ranges) {
+        const std::string &methodName = blocks[range.first]->method;
+        typeTracker.enterMethod(methodName);
+        int nextTemporary = 0;
+        for (size_t b = range.first; b < range.second; b++) {
+            for (const auto &instruction : readInstructions(blocks[b])) {
+                for (const Symbol *name : {&instruction.result, &instruction.arg1, &instruction.arg2}) {
+                    if (isTemporary(*name)) nextTemporary = std::max(nextTemporary, std::atoi(name->c_str() + 2) + 1);
+                }
+            }
+        }
+
+        for (size_t b = range.first; b < range.second; b++) {
+            // Inlined code is not scanned again, so a recursive method is only copied once
+            BasicBlock *block = blocks[b];
+            size_t start = 0;
+            layout.push_back(block);
+            while (block) {
+                std::vector<Instruction> instructions = readInstructions(block);
+                BasicBlock *next = nullptr;
+                for (size_t i = start; i < instructions.size() && !next; i++) {
+                    if (instructions[i].op != tac::CALL || instructions[i].arg1 == methodName) continue;
+                    auto it = callees.find(instructions[i].arg1);
+                    if (it == callees.end()) continue;
+
+                    // The receiver and arguments are the params right before the call
+                    size_t params = it->second.parameters.size() + 1;
+                    if (instructions[i].arg2 != std::to_string(params) || i < params) continue;
+                    if (!std::all_of(instructions.begin() + (i - params), instructions.begin() + i,
+                                     [](const Instruction &param) { return param.op == tac::PARAM; })) {
+                        continue;
+                    }
+                    next = inlineCall(block, instructions, i, it->second, typeTracker, nextTemporary, layout, start);
+                    if (next != block) layout.push_back(next);
+                    inlined++;
+                }
+                block = next;
+            }
+        }
+    }
+
+    blocks = layout;
+    return inlined;
+}
+
+int TailCallElimination::run(ControlFlowGraph &cfg, const SymbolTable &symbolTable) {
+    std::vector<BasicBlock *> &blocks = cfg.getBlocks();
+    std::vector<std::pair<size_t, size_t>> ranges = getMethodRanges(blocks);
+    std::map<std::string, int> definitions;
+    for (const auto &range : ranges) definitions[blocks[range.first]->method]++;
+    TypeTracker typeTracker(symbolTable);
+
+    int eliminated = 0;
+    std::vector<BasicBlock *> layout;
+    for (const auto &range : ranges) {
+        std::vector<BasicBlock *> methodBlocks(blocks.begin() + range.first, blocks.begin() + range.second);
+        BasicBlock *entry = methodBlocks.front();
+        const std::string &name = entry->method;
+        typeTracker.enterMethod(name);
+        const Method *method = typeTracker.getMethod();
+        if (definitions[name] > 1 || entry->name != name || !method || typeTracker.inMainMethod()) {
+            layout.insert(layout.end(), methodBlocks.begin(), methodBlocks.end());
+            continue;
+        }
+
+        // A tail call is a call of the method on this, with the params right before it, whose result is returned
+        // as it is. Conditions return through copies, as in return n < 1 || this.m(n - 1).
+        std::vector<std::string> parameters;
+        for (const auto &parameter : method->getParameters()) parameters.push_back(parameter.getName());
+        size_t params = parameters.size() + 1;
+        std::string unqualified = name.substr(name.find('.') + 1);
+        std::vector<std::pair<BasicBlock *, size_t>> tailCalls;  // Blocks and the index of their call
+        int nextTemporary = 0;
+        std::set<std::string> assigned;
+        for (BasicBlock *block : methodBlocks) {
+            std::vector<Instruction> instructions = readInstructions(block);
+            for (auto &instruction : instructions) {
+                forEachOperand(instruction, [&](Symbol &operand, bool written) {
+                    if (isTemporary(operand)) {
+                        nextTemporary = std::max(nextTemporary, std::atoi(operand.c_str() + 2) + 1);
+                    }
+                    if (written) assigned.insert(operand);
+                });
+            }
+
+            // Only the last call of a block can be a tail call
+            size_t call = instructions.size();
+            while (call > 0 && instructions[call - 1].op != tac::CALL) call--;
+            if (call-- <= params) continue;
+            const Instruction &instruction = instructions[call];
+            if ((instruction.arg1 != name && instruction.arg1 != unqualified) ||
+                instruction.arg2 != std::to_string(params) || instructions[call - params].arg1 != tac::THIS ||
+                !isReturned(block, call + 1, instruction.result)) {
+                continue;
+            }
+            if (std::all_of(instructions.begin() + (call - params), instructions.begin() + call,
+                            [](const Instruction &param) { return param.op == tac::PARAM; })) {
+                tailCalls.emplace_back(block, call);
+            }
+        }
+        if (tailCalls.empty()) {
+            layout.insert(layout.end(), methodBlocks.begin(), methodBlocks.end());
+            continue;
+        }
+
+        // Locals start out empty on every call. Those never stored are left alone, as the interpreter reports them.
+        LivenessAnalysis liveness(std::vector<const BasicBlock *>(methodBlocks.begin(), methodBlocks.end()),
+                                  [&](const std::string &operand) {
+                                      return method->isLocalVariable(operand) &&
+                                             !std::count(parameters.begin(), parameters.end(), operand);
+                                  });
+        std::set<std::string> uninitializedLocals;
+        for (const auto &local : liveness.getLiveIn(entry)) {
+            if (assigned.count(local)) uninitializedLocals.insert(local);
+        }
+
+        // The body moves out of the entry, which keeps receiving the arguments of the call
+        BasicBlock *body = new BasicBlock();
+        body->method = name;
+        writeInstructions(body, readInstructions(entry));
+        body->trueExit = entry->trueExit;
+        body->falseExit = entry->falseExit;
+        entry->clearInstructions();
+        entry->trueExit = body;
+        entry->falseExit = nullptr;
+
+        for (const auto &tailCall : tailCalls) {
+            BasicBlock *block = tailCall.first == entry ? body : tailCall.first;
+            std::vector<Instruction> instructions = readInstructions(block);
+            size_t firstParam = tailCall.second - params;
+            std::vector<Symbol> arguments;
+            for (size_t i = 1; i < params; i++) arguments.push_back(instructions[firstParam + i].arg1);
+            instructions.resize(firstParam);
+
+            // Arguments may read parameters that are assigned before them, so variables are copied aside first
+            for (size_t i = 0; i < arguments.size(); i++) {
+                if (arguments[i] == parameters[i] || isTemporary(arguments[i]) || isConstant(arguments[i])) continue;
+                Symbol temporary = "_t" + std::to_string(nextTemporary++);
+                instructions.push_back({temporary, arguments[i], Symbol(), Symbol()});
+                arguments[i] = temporary;
+            }
+            for (size_t i = 0; i < arguments.size(); i++) {
+                if (arguments[i] != parameters[i]) {
+                    instructions.push_back({parameters[i], arguments[i], Symbol(), Symbol()});
+                }
+            }
+            for (const auto &local : uninitializedLocals) {
+                Symbol initial = typeTracker.getDeclaredType(local) == "Bool" ? tac::FALSE_LITERAL : tac::ZERO;
+                instructions.push_back({local, initial, Symbol(), Symbol()});
+            }
+            writeInstructions(block, instructions);
+            block->trueExit = body;
+            block->falseExit = nullptr;
+            eliminated++;
+        }
+
+        layout.push_back(entry);
+        layout.push_back(body);
+        layout.insert(layout.end(), methodBlocks.begin() + 1, methodBlocks.end());
+    }
+
+    blocks = layout;
+    return eliminated;
+}
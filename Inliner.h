@@ -0,0 +1,56 @@
+#ifndef INLINER_H
+#define INLINER_H
+
+#include "IntermediateRepresentation.h"
+#include "SymbolTable.h"
+
+/*
+ * Inlines calls to small methods into their callers.
+ *
+ * Every call is first resolved to the class of its receiver, and names its target as Class.method from then
+ * on. MiniJava has no inheritance, so each call has exactly one target. A call to a method within the size
+ * budget is replaced by a copy of the callee's blocks, spliced in between the two halves of the calling block:
+ * the callee's parameters, locals and temporaries become fresh temporaries of the caller, its fields are read
+ * and written through the receiver, and its return becomes a copy into the result of the call.
+ *
+ * Callees are copied as they were before any inlining, so recursive methods are expanded at most once.
+ */
+class Inliner {
+   public:
+    // Largest callee, in TAC instructions, that is inlined
+    static const int DEFAULT_BUDGET = 12;
+
+    explicit Inliner(int budget = DEFAULT_BUDGET) : budget(budget) {}
+
+    /**
+     * @brief Resolves every call and inlines the calls to small methods.
+     * @param cfg The control flow graph, whose blocks are rewritten.
+     * @param symbolTable The symbol table, used to resolve receivers and to tell fields from locals.
+     * @return The number of calls inlined.
+     */
+    int run(ControlFlowGraph &cfg, const SymbolTable &symbolTable);
+
+   private:
+    int budget;
+};
+
+/*
+ * Turns self-recursive tail calls into jumps.
+ *
+ * A block that returns the result of calling its own method on the same receiver instead assigns the arguments
+ * to the parameters and jumps back to the start of the method, so the recursion runs in a single frame. The
+ * body of such a method moves out of the entry block into a block of its own, which the tail calls jump to:
+ * the entry keeps receiving the arguments of the actual call, and SSA keeps an entry without predecessors.
+ */
+class TailCallElimination {
+   public:
+    /**
+     * @brief Rewrites the self tail calls of every method.
+     * @param cfg The control flow graph, whose blocks are rewritten.
+     * @param symbolTable The symbol table, used to find parameters and locals.
+     * @return The number of tail calls eliminated.
+     */
+    int run(ControlFlowGraph &cfg, const SymbolTable &symbolTable);
+};
+
+#endif  // INLINER_H
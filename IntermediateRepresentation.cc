@@ -1,7 +1,89 @@
 #include "IntermediateRepresentation.h"
 
+#include <cstdint>
+
 int BasicBlock::tempCounter = 0;
 
+/**
+ * @brief Evaluates a binary expression on two literals, wrapping around at 32 bits like the interpreter.
+ * @param kind The expression kind.
+ * @param left The left operand.
+ * @param right The right operand.
+ * @param result Set to the literal the expression evaluates to.
+ * @return True if the expression was folded.
+ */
+static bool foldBinaryExpression(NodeKind kind, const std::string &left, const std::string &right,
+                                 std::string &result) {
+    int32_t a, b;
+    bool p, q;
+    if (parseIntegerLiteral(left, a) && parseIntegerLiteral(right, b)) {
+        uint32_t ua = static_cast<uint32_t>(a), ub = static_cast<uint32_t>(b);
+        if (kind == NodeKind::AddExpression) {
+            result = std::to_string(static_cast<int32_t>(ua + ub));
+        } else if (kind == NodeKind::SubExpression) {
+            result = std::to_string(static_cast<int32_t>(ua - ub));
+        } else if (kind == NodeKind::MultExpression) {
+            result = std::to_string(static_cast<int32_t>(ua * ub));
+        } else if (kind == NodeKind::LTExpression) {
+            result = a < b ? "true" : "false";
+        } else if (kind == NodeKind::GTExpression) {
+            result = a > b ? "true" : "false";
+        } else if (kind == NodeKind::EqualExpression) {
+            result = a == b ? "true" : "false";
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (parseBooleanLiteral(left, p) && parseBooleanLiteral(right, q)) {
+        if (kind == NodeKind::AndExpression) {
+            result = p && q ? "true" : "false";
+        } else if (kind == NodeKind::OrExpression) {
+            result = p || q ? "true" : "false";
+        } else if (kind == NodeKind::EqualExpression) {
+            result = p == q ? "true" : "false";
+        } else {
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Applies the algebraic identities of arithmetic and logical expressions with one literal operand, such
+ * as x * 1 = x, x * 0 = 0, x && true = x and x || true = true. Both operands have already been evaluated, and
+ * logical expressions with a literal left operand are short-circuited before the right one is.
+ * @param kind The expression kind.
+ * @param left The left operand.
+ * @param right The right operand.
+ * @param result Set to the operand or literal the expression equals.
+ * @return True if an identity applies.
+ */
+static bool simplifyBinaryExpression(NodeKind kind, const std::string &left, const std::string &right,
+                                     std::string &result) {
+    int32_t a = 1, b = 1;
+    bool leftIsInteger = parseIntegerLiteral(left, a), rightIsInteger = parseIntegerLiteral(right, b);
+    bool q = false;
+    bool rightIsBoolean = parseBooleanLiteral(right, q);
+
+    if (kind == NodeKind::AddExpression) {
+        if (leftIsInteger && a == 0) result = right;
+        if (rightIsInteger && b == 0) result = left;
+    } else if (kind == NodeKind::SubExpression) {
+        if (rightIsInteger && b == 0) result = left;
+    } else if (kind == NodeKind::MultExpression) {
+        if (leftIsInteger && a == 1) result = right;
+        if (rightIsInteger && b == 1) result = left;
+        if ((leftIsInteger && a == 0) || (rightIsInteger && b == 0)) result = "0";
+    } else if (kind == NodeKind::AndExpression) {
+        if (rightIsBoolean) result = q ? left : "false";
+    } else if (kind == NodeKind::OrExpression) {
+        if (rightIsBoolean) result = q ? "true" : left;
+    }
+    return !result.empty();
+}
+
 void ControlFlowGraph::writeCFG() {
     std::ofstream outFile("cfg.dot");
     if (!outFile) {
@@ -21,19 +103,30 @@ void ControlFlowGraph::writeCFG() {
         // Add instructions to the block
         for (const auto &instruction : block->getTacInstructions()) {
             outFile << "    ";
-            if (instruction.op == "print" || instruction.op == "param" || instruction.op == "if" ||
-                instruction.op == "return") {
+            if (instruction.op == tac::PRINT || instruction.op == tac::PARAM || instruction.op == tac::IF ||
+                instruction.op == tac::RETURN) {
                 outFile << instruction.op << " " << instruction.arg1 << std::endl;
-            } else if (instruction.op == "call" || instruction.op == "new") {
+            } else if (instruction.op == tac::STORE_INDEX ||
+                       instruction.op == tac::STORE_INDEX_UNCHECKED) {  // Array store
+                outFile << instruction.result << "[" << instruction.arg1 << "] := " << instruction.arg2
+                        << (instruction.op == tac::STORE_INDEX ? "" : " (unchecked)") << std::endl;
+            } else if (instruction.op == tac::LOAD_INDEX_UNCHECKED) {  // Array load proven within bounds
+                outFile << instruction.result << " := " << instruction.arg1 << "[" << instruction.arg2
+                        << "] (unchecked)" << std::endl;
+            } else if (instruction.op == tac::STORE_FIELD) {  // Field store
+                outFile << instruction.result << "." << instruction.arg1 << " := " << instruction.arg2 << std::endl;
+            } else if (instruction.op == tac::LOAD_FIELD) {  // Field load
+                outFile << instruction.result << " := " << instruction.arg1 << "." << instruction.arg2 << std::endl;
+            } else if (instruction.op == tac::CALL || instruction.op == tac::NEW) {
                 outFile << instruction.result << " := " << instruction.op << " " << instruction.arg1 << " "
                         << instruction.arg2 << std::endl;
             } else if (instruction.op.empty()) {  // No operation
                 outFile << instruction.result << " := " << instruction.arg1 << std::endl;
             } else if (instruction.arg2.empty()) {  // Unary operation
-                std::string endOp = (instruction.op == "new int[") ? "]" : "";
+                std::string endOp = (instruction.op == tac::NEW_ARRAY) ? "]" : "";
                 outFile << instruction.result << " := " << instruction.op << instruction.arg1 << endOp << std::endl;
             } else {  // Binary operation
-                std::string endOp = (instruction.op == "[") ? "]" : "";
+                std::string endOp = (instruction.op == tac::LOAD_INDEX) ? "]" : "";
                 outFile << instruction.result << " := " << instruction.arg1 << instruction.op << instruction.arg2
                         << endOp << std::endl;
             }
@@ -60,7 +153,7 @@ void ControlFlowGraph::writeCFG() {
 
 void ControlFlowGraph::traverseAST(Node *root) {
     if (!root) return;
-    if (root->type != "Goal") throw std::runtime_error("Invalid root node type: " + root->type);
+    if (root->kind != NodeKind::Goal) throw std::runtime_error("Invalid root node type: " + getKindName(root->kind));
     if (root->children.size() != 2) throw std::runtime_error("Invalid number of children for root node");
 
     Node *mainClassNode = root->children.front();
@@ -73,67 +166,71 @@ void ControlFlowGraph::traverseAST(Node *root) {
 
 void ControlFlowGraph::traverseMainClass(Node *node) {
     if (!node) throw std::runtime_error("Main class node is null");
-    if (node->type != "MainClass") throw std::runtime_error("Invalid node type for main class: " + node->type);
+    if (node->kind != NodeKind::MainClass)
+        throw std::runtime_error("Invalid node type for main class: " + getKindName(node->kind));
 
     currentClassName = node->value;
 
-    Node *statementListNode = findChild(node, "StatementList");
+    Node *statementListNode = findChild(node, NodeKind::StatementList);
     if (!statementListNode) throw std::runtime_error("No statement list found in main class");
 
     std::string entryName = currentClassName + ".main";
     BasicBlock *block = new BasicBlock(entryName);
     BasicBlock *currentBlock = block;
+    size_t firstBlock = blocks.size();
 
     for (auto child : statementListNode->children) {
-        if (endsWith(child->type, "Statement")) {
+        if (isStatement(child->kind)) {
             currentBlock = traverseStatement(child, currentBlock);
         } else {
-            throw std::runtime_error("Unknown child type in main class statement list: " + child->type);
+            throw std::runtime_error("Unknown child type in main class statement list: " + getKindName(child->kind));
         }
     }
 
-    blocks.emplace_back(block);
+    // The entry goes first, so that every block is laid out after the blocks dominating it
+    blocks.insert(blocks.begin() + firstBlock, block);
+    assignMethod(firstBlock, entryName);
 }
 
 void ControlFlowGraph::traverseClassDeclarationList(Node *node) {
     if (!node) throw std::runtime_error("Class declaration list node is null");
-    if (node->type != "ClassDeclarationList")
-        throw std::runtime_error("Invalid node type for class declaration list: " + node->type);
+    if (node->kind != NodeKind::ClassDeclarationList)
+        throw std::runtime_error("Invalid node type for class declaration list: " + getKindName(node->kind));
 
     for (auto child : node->children) {
-        if (child->type == "ClassDeclaration") {
+        if (child->kind == NodeKind::ClassDeclaration) {
             traverseClassDeclaration(child);
         } else {
-            throw std::runtime_error("Unknown child type in class declaration list: " + child->type);
+            throw std::runtime_error("Unknown child type in class declaration list: " + getKindName(child->kind));
         }
     }
 }
 
 void ControlFlowGraph::traverseClassDeclaration(Node *node) {
     if (!node) throw std::runtime_error("Class declaration node is null");
-    if (node->type != "ClassDeclaration")
-        throw std::runtime_error("Invalid node type for class declaration: " + node->type);
+    if (node->kind != NodeKind::ClassDeclaration)
+        throw std::runtime_error("Invalid node type for class declaration: " + getKindName(node->kind));
 
     currentClassName = node->value;
 
-    Node *methodDeclListNode = findChild(node, "MethodDeclarationList");
+    Node *methodDeclListNode = findChild(node, NodeKind::MethodDeclarationList);
     if (!methodDeclListNode) throw std::runtime_error("No method declaration list found in class declaration");
 
     for (auto child : methodDeclListNode->children) {
-        if (child->type == "MethodDeclaration") {
+        if (child->kind == NodeKind::MethodDeclaration) {
             traverseMethodDeclaration(child);
         } else {
-            throw std::runtime_error("Unknown child type in method declaration list: " + child->type);
+            throw std::runtime_error("Unknown child type in method declaration list: " + getKindName(child->kind));
         }
     }
 }
 
 void ControlFlowGraph::traverseMethodDeclaration(Node *node) {
     if (!node) throw std::runtime_error("Method declaration node is null");
-    if (node->type != "MethodDeclaration")
-        throw std::runtime_error("Invalid node type for method declaration: " + node->type);
+    if (node->kind != NodeKind::MethodDeclaration)
+        throw std::runtime_error("Invalid node type for method declaration: " + getKindName(node->kind));
 
-    Node *code = findChild(node, "Code");
+    Node *code = findChild(node, NodeKind::Code);
     if (!code) throw std::runtime_error("No code found in method declaration");
 
     std::string entryName = currentClassName + "." + node->value;
@@ -141,29 +238,42 @@ void ControlFlowGraph::traverseMethodDeclaration(Node *node) {
     blocks.emplace_back(entryBlock);
     size_t nextBlockIndex = blocks.size();
 
+    // Statements that branch link the entry block themselves, otherwise it falls through to the first new block
     BasicBlock *lastBlock = traverseCode(code, entryBlock);
-    if (lastBlock != entryBlock) entryBlock->trueExit = blocks[nextBlockIndex];
+    if (lastBlock != entryBlock && !entryBlock->trueExit && !entryBlock->falseExit) {
+        entryBlock->trueExit = blocks[nextBlockIndex];
+    }
 
     // Add a return instruction to the last block
-    Node *returnNode = findChild(node, "Return");
+    Node *returnNode = findChild(node, NodeKind::Return);
     if (!returnNode) throw std::runtime_error("No return found in method declaration");
     if (returnNode->children.size() != 1) throw std::runtime_error("Invalid number of children for return");
     std::string returnValue = traverseExpression(returnNode->children.front(), lastBlock);
-    lastBlock->addInstruction("return", returnValue);
+    lastBlock->addInstruction(tac::RETURN, returnValue);
+
+    assignMethod(nextBlockIndex - 1, entryName);
+}
+
+void ControlFlowGraph::assignMethod(size_t firstBlock, const std::string &methodName) {
+    // A method's blocks are created together, so they form one contiguous range
+    for (size_t i = firstBlock; i < blocks.size(); i++) {
+        blocks[i]->method = methodName;
+    }
 }
 
 BasicBlock *ControlFlowGraph::traverseCode(Node *node, BasicBlock *block) {
     if (!node) throw std::runtime_error("Code node is null");
-    if (node->type != "Code") throw std::runtime_error("Invalid node type for code: " + node->type);
+    if (node->kind != NodeKind::Code)
+        throw std::runtime_error("Invalid node type for code: " + getKindName(node->kind));
 
     BasicBlock *currentBlock = block;
     for (auto child : node->children) {
-        if (child->type == "Variable") {
+        if (child->kind == NodeKind::Variable) {
             continue;  // Skip variable declarations
-        } else if (endsWith(child->type, "Statement")) {
+        } else if (isStatement(child->kind)) {
             currentBlock = traverseStatement(child, currentBlock);
         } else {
-            throw std::runtime_error("Unknown child type in code: " + child->type);
+            throw std::runtime_error("Unknown child type in code: " + getKindName(child->kind));
         }
     }
 
@@ -173,33 +283,44 @@ BasicBlock *ControlFlowGraph::traverseCode(Node *node, BasicBlock *block) {
 BasicBlock *ControlFlowGraph::traverseStatement(Node *node, BasicBlock *block) {
     if (!node) throw std::runtime_error("Statement node is null");
 
-    std::string statementType = node->type;
     BasicBlock *resultBlock = block;
 
-    if (statementType == "PrintStatement") {
-        resultBlock = traversePrintStatement(node, block);
-    } else if (statementType == "WhileStatement") {
-        resultBlock = traverseWhileStatement(node, block);
-    } else if (statementType == "IfStatement") {
-        resultBlock = traverseIfStatement(node, block);
-    } else if (statementType == "IfElseStatement") {
-        resultBlock = traverseIfElseStatement(node, block);
-    } else if (statementType == "ArrayInitStatement") {
-        std::string varName = node->children.front()->value;
-        if (node->children.size() != 3) throw std::runtime_error("Invalid number of children for array init statement");
-        auto it = node->children.begin();
-        Node *sizeNode = (*(++it));
-        std::string size = traverseExpression(sizeNode, block);
-        std::string newVarName = varName + "[" + size + "]";
-
-        std::string expression = traverseExpression(node->children.back(), block);
-        block->addInstruction(newVarName, "", expression);
-    } else if (statementType == "VarInitStatement") {
-        std::string varName = node->children.front()->value;
-        std::string value = traverseExpression(node->children.back(), block);
-        block->addInstruction(varName, "", value);
-    } else {
-        throw std::runtime_error("Unknown statement type: " + statementType);
+    switch (node->kind) {
+        case NodeKind::PrintStatement:
+            resultBlock = traversePrintStatement(node, block);
+            break;
+        case NodeKind::WhileStatement:
+            resultBlock = traverseWhileStatement(node, block);
+            break;
+        case NodeKind::IfStatement:
+            resultBlock = traverseIfStatement(node, block);
+            break;
+        case NodeKind::IfElseStatement:
+            resultBlock = traverseIfElseStatement(node, block);
+            break;
+        case NodeKind::ArrayInitStatement: {
+            std::string varName = node->children.front()->value;
+            if (node->children.size() != 3) {
+                throw std::runtime_error("Invalid number of children for array init statement");
+            }
+            auto it = node->children.begin();
+            Node *indexNode = (*(++it));
+            std::string index = traverseExpression(indexNode, block);
+
+            std::string expression = traverseExpression(node->children.back(), block);
+            block->addInstruction(varName, index, tac::STORE_INDEX, expression);
+            resultBlock = block;
+            break;
+        }
+        case NodeKind::VarInitStatement: {
+            std::string varName = node->children.front()->value;
+            std::string value = traverseExpression(node->children.back(), block);
+            block->addInstruction(varName, "", value);
+            resultBlock = block;
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown statement type: " + getKindName(node->kind));
     }
 
     tempCounter = 0;
@@ -208,23 +329,23 @@ BasicBlock *ControlFlowGraph::traverseStatement(Node *node, BasicBlock *block) {
 
 BasicBlock *ControlFlowGraph::traversePrintStatement(Node *node, BasicBlock *block) {
     if (!node) throw std::runtime_error("Print statement node is null");
-    if (node->type != "PrintStatement")
-        throw std::runtime_error("Invalid node type for print statement: " + node->type);
+    if (node->kind != NodeKind::PrintStatement)
+        throw std::runtime_error("Invalid node type for print statement: " + getKindName(node->kind));
     if (node->children.size() != 1) throw std::runtime_error("Invalid number of children for print statement");
 
     Node *expressionNode = node->children.front();
     if (!expressionNode) throw std::runtime_error("No expression found in print statement");
 
     std::string varName = traverseExpression(expressionNode, block);
-    block->addInstruction("print", varName);
+    block->addInstruction(tac::PRINT, varName);
 
     return block;
 }
 
 BasicBlock *ControlFlowGraph::traverseWhileStatement(Node *node, BasicBlock *block) {
     if (!node) throw std::runtime_error("While statement node is null");
-    if (node->type != "WhileStatement")
-        throw std::runtime_error("Invalid node type for while statement: " + node->type);
+    if (node->kind != NodeKind::WhileStatement)
+        throw std::runtime_error("Invalid node type for while statement: " + getKindName(node->kind));
     if (node->children.size() != 2) throw std::runtime_error("Invalid number of children for while statement");
 
     Node *conditionNode = node->children.front();
@@ -236,18 +357,15 @@ BasicBlock *ControlFlowGraph::traverseWhileStatement(Node *node, BasicBlock *blo
     BasicBlock *bodyBlock = new BasicBlock();
     BasicBlock *exitBlock = new BasicBlock();
 
-    // Process condition
-    std::string conditionVar = traverseExpression(conditionNode, conditionBlock);
-    conditionBlock->addInstruction("if", conditionVar);
-
+    // Process condition, which branches to the body or the exit
     blocks.emplace_back(conditionBlock);
+    traverseCondition(conditionNode, conditionBlock, bodyBlock, exitBlock);
+
     blocks.emplace_back(bodyBlock);
     blocks.emplace_back(exitBlock);
 
     // Connect blocks
     block->trueExit = conditionBlock;
-    conditionBlock->trueExit = bodyBlock;
-    conditionBlock->falseExit = exitBlock;
 
     // Process body
     BasicBlock *currentBlock = bodyBlock;
@@ -264,11 +382,12 @@ BasicBlock *ControlFlowGraph::traverseWhileStatement(Node *node, BasicBlock *blo
 
 BasicBlock *ControlFlowGraph::traverseIfStatement(Node *node, BasicBlock *block) {
     if (!node) throw std::runtime_error("If statement node is null");
-    if (node->type != "IfStatement") throw std::runtime_error("Invalid node type for if statement: " + node->type);
+    if (node->kind != NodeKind::IfStatement)
+        throw std::runtime_error("Invalid node type for if statement: " + getKindName(node->kind));
     if (node->children.size() != 2) throw std::runtime_error("Invalid number of children for if statement");
 
     Node *conditionNode = node->children.front();
-    Node *ifBodyNode = findChild(node, "StatementList");
+    Node *ifBodyNode = findChild(node, NodeKind::StatementList);
     if (!conditionNode || !ifBodyNode) throw std::runtime_error("Invalid children for if statement");
 
     // Create blocks for the if statement
@@ -279,26 +398,21 @@ BasicBlock *ControlFlowGraph::traverseIfStatement(Node *node, BasicBlock *block)
     // Connect the current block to the condition block
     block->trueExit = conditionBlock;
 
-    // Process condition
-    std::string conditionVar = traverseExpression(conditionNode->children.front(), conditionBlock);
-    conditionBlock->addInstruction("if", conditionVar);
+    // Process condition, which branches to the if body or the exit
+    blocks.emplace_back(conditionBlock);
+    traverseCondition(conditionNode->children.front(), conditionBlock, ifBodyBlock, exitBlock);
 
     // Add all blocks to the blocks vector BEFORE processing body
-    blocks.emplace_back(conditionBlock);
     blocks.emplace_back(ifBodyBlock);
     blocks.emplace_back(exitBlock);
 
-    // Connect condition block to if body or exit
-    conditionBlock->trueExit = ifBodyBlock;
-    conditionBlock->falseExit = exitBlock;
-
     // Process if body
     BasicBlock *ifCurrentBlock = ifBodyBlock;
     for (auto child : ifBodyNode->children) {
-        if (endsWith(child->type, "Statement")) {
+        if (isStatement(child->kind)) {
             ifCurrentBlock = traverseStatement(child, ifCurrentBlock);
         } else {
-            throw std::runtime_error("Unknown child type in if body: " + child->type);
+            throw std::runtime_error("Unknown child type in if body: " + getKindName(child->kind));
         }
     }
 
@@ -312,13 +426,13 @@ BasicBlock *ControlFlowGraph::traverseIfStatement(Node *node, BasicBlock *block)
 
 BasicBlock *ControlFlowGraph::traverseIfElseStatement(Node *node, BasicBlock *block) {
     if (!node) throw std::runtime_error("If else statement node is null");
-    if (node->type != "IfElseStatement")
-        throw std::runtime_error("Invalid node type for if else statement: " + node->type);
+    if (node->kind != NodeKind::IfElseStatement)
+        throw std::runtime_error("Invalid node type for if else statement: " + getKindName(node->kind));
     if (node->children.size() != 3) throw std::runtime_error("Invalid number of children for if else statement");
 
     Node *conditionNode = node->children.front();
-    Node *ifBodyNode = findChild(node, "StatementList");
-    Node *elseBodyNode = findChild(node, "StatementList", 2);
+    Node *ifBodyNode = findChild(node, NodeKind::StatementList);
+    Node *elseBodyNode = findChild(node, NodeKind::StatementList, 2);
     if (!conditionNode || !ifBodyNode || !elseBodyNode)
         throw std::runtime_error("Invalid children for if else statement");
 
@@ -330,12 +444,11 @@ BasicBlock *ControlFlowGraph::traverseIfElseStatement(Node *node, BasicBlock *bl
 
     block->trueExit = conditionBlock;
 
-    // Process condition
-    std::string conditionVar = traverseExpression(conditionNode->children.front(), conditionBlock);
-    conditionBlock->addInstruction("if", conditionVar);
+    // Process condition, which branches to the if body or the else body
+    blocks.emplace_back(conditionBlock);
+    traverseCondition(conditionNode->children.front(), conditionBlock, ifBodyBlock, elseBodyBlock);
 
     // Add all blocks to the blocks vector
-    blocks.emplace_back(conditionBlock);
     blocks.emplace_back(ifBodyBlock);
     blocks.emplace_back(elseBodyBlock);
     blocks.emplace_back(exitBlock);
@@ -343,63 +456,96 @@ BasicBlock *ControlFlowGraph::traverseIfElseStatement(Node *node, BasicBlock *bl
     // Process if body
     BasicBlock *ifCurrentBlock = ifBodyBlock;
     for (auto child : ifBodyNode->children) {
-        if (endsWith(child->type, "Statement")) {
+        if (isStatement(child->kind)) {
             ifCurrentBlock = traverseStatement(child, ifCurrentBlock);
         } else {
-            throw std::runtime_error("Unknown child type in if body: " + child->type);
+            throw std::runtime_error("Unknown child type in if body: " + getKindName(child->kind));
         }
     }
 
     // Process else body
     BasicBlock *elseCurrentBlock = elseBodyBlock;
     for (auto child : elseBodyNode->children) {
-        if (endsWith(child->type, "Statement")) {
+        if (isStatement(child->kind)) {
             elseCurrentBlock = traverseStatement(child, elseCurrentBlock);
         } else {
-            throw std::runtime_error("Unknown child type in else body: " + child->type);
+            throw std::runtime_error("Unknown child type in else body: " + getKindName(child->kind));
         }
     }
 
     // Connect blocks
     ifCurrentBlock->trueExit = exitBlock;
     elseCurrentBlock->trueExit = exitBlock;
-    conditionBlock->trueExit = ifBodyBlock;
-    conditionBlock->falseExit = elseBodyBlock;
 
     return exitBlock;
 }
 
-std::string ControlFlowGraph::traverseExpression(Node *node, BasicBlock *block) {
-    if (!node) throw std::runtime_error("Expression node is null");
+void ControlFlowGraph::traverseCondition(Node *node, BasicBlock *block, BasicBlock *trueBlock,
+                                         BasicBlock *falseBlock) {
+    if (!node) throw std::runtime_error("Condition node is null");
 
-    std::string expressionType = node->type;
-
-    if (isBinaryExpression(expressionType)) {
-        return traverseBinaryExpression(node, block);
-    } else if (isUnaryExpression(expressionType)) {
-        return traverseUnaryExpression(node, block);
-    } else if (isLiteral(expressionType)) {
-        return node->value;
-    } else if (expressionType == "MethodCallExpression") {
-        return traverseMethodCall(node, block);
-    } else if (expressionType == "NewObjectExpression") {
-        std::string varName = generateName();
-        block->addInstruction(varName, "new", traverseExpression(node->children.front(), block));
-        block->addInstruction("param", varName);
-        return varName;
-    } else if (expressionType == "Identifier") {
-        return node->value;
-    } else if (expressionType == "ThisExpression") {
-        std::string varName = generateName();
-        block->addInstruction(varName, "", currentClassName);
-        block->addInstruction("param", varName);
-        return varName;
+    if (isLogicalExpression(node->kind)) {
+        if (node->children.size() != 2) throw std::runtime_error("Invalid number of children for logical expression");
+
+        // The right operand is only reached when the left one doesn't decide the condition. Its block is laid out
+        // after the blocks of the left operand, which dominate it.
+        BasicBlock *rightBlock = new BasicBlock();
+        if (node->kind == NodeKind::AndExpression) {
+            traverseCondition(node->children.front(), block, rightBlock, falseBlock);
+        } else {
+            traverseCondition(node->children.front(), block, trueBlock, rightBlock);
+        }
+        blocks.emplace_back(rightBlock);
+        traverseCondition(node->children.back(), rightBlock, trueBlock, falseBlock);
+    } else if (node->kind == NodeKind::NotExpression) {
+        if (node->children.size() != 1) throw std::runtime_error("Invalid number of children for not expression");
+        traverseCondition(node->children.front(), block, falseBlock, trueBlock);
     } else {
-        throw std::runtime_error("Unknown expression type: " + expressionType);
+        std::string conditionVar = traverseExpression(node, block);
+        block->addInstruction(tac::IF, conditionVar);
+        block->trueExit = trueBlock;
+        block->falseExit = falseBlock;
+    }
+}
+
+std::string ControlFlowGraph::traverseExpression(Node *node, BasicBlock *&block) {
+    if (!node) throw std::runtime_error("Expression node is null");
+
+    switch (node->kind) {
+        case NodeKind::AndExpression:
+        case NodeKind::OrExpression:
+        case NodeKind::LTExpression:
+        case NodeKind::GTExpression:
+        case NodeKind::EqualExpression:
+        case NodeKind::AddExpression:
+        case NodeKind::SubExpression:
+        case NodeKind::MultExpression:
+        case NodeKind::ArrayExpression:
+            return traverseBinaryExpression(node, block);
+        case NodeKind::NotExpression:
+        case NodeKind::LengthExpression:
+        case NodeKind::NewIntArrayExpression:
+            return traverseUnaryExpression(node, block);
+        case NodeKind::IntLiteral:
+        case NodeKind::BoolLiteral:
+        case NodeKind::Identifier:
+            return node->value;
+        case NodeKind::MethodCallExpression:
+            return traverseMethodCall(node, block);
+        case NodeKind::NewObjectExpression: {
+            std::string varName = generateName();
+            std::string className = traverseExpression(node->children.front(), block);
+            block->addInstruction(varName, tac::NEW, className);
+            return varName;
+        }
+        case NodeKind::ThisExpression:
+            return "this";
+        default:
+            throw std::runtime_error("Unknown expression type: " + getKindName(node->kind));
     }
 }
 
-std::string ControlFlowGraph::traverseBinaryExpression(Node *node, BasicBlock *block) {
+std::string ControlFlowGraph::traverseBinaryExpression(Node *node, BasicBlock *&block) {
     if (!node) throw std::runtime_error("Binary expression node is null");
     if (node->children.size() != 2) throw std::runtime_error("Invalid number of children for binary expession");
 
@@ -410,13 +556,63 @@ std::string ControlFlowGraph::traverseBinaryExpression(Node *node, BasicBlock *b
     if (!leftChild || !rightChild) throw std::runtime_error("Invalid children for binary expression");
 
     std::string leftName = traverseExpression(leftChild, block);
+
+    // A constant left operand decides false && e and true || e, which then never evaluate e
+    bool leftValue;
+    if (isLogicalExpression(node->kind) && parseBooleanLiteral(leftName, leftValue)) {
+        if (leftValue == (node->kind == NodeKind::OrExpression)) return leftName;
+        std::string rightName = traverseExpression(rightChild, block);
+        return materialize(varName, rightName, block);
+    }
+
+    // A right operand with effects or work of its own is only evaluated when the left one doesn't decide the result
+    if (isLogicalExpression(node->kind) && !isLiteral(rightChild->kind) && rightChild->kind != NodeKind::Identifier &&
+        rightChild->kind != NodeKind::ThisExpression) {
+        BasicBlock *rightBlock = new BasicBlock();
+        BasicBlock *joinBlock = new BasicBlock();
+        block->addInstruction(varName, "", leftName);
+        block->addInstruction(tac::IF, varName);
+        block->trueExit = node->kind == NodeKind::AndExpression ? rightBlock : joinBlock;
+        block->falseExit = node->kind == NodeKind::AndExpression ? joinBlock : rightBlock;
+
+        blocks.emplace_back(rightBlock);
+        std::string rightName = traverseExpression(rightChild, rightBlock);
+        rightBlock->addInstruction(varName, "", rightName);
+        rightBlock->trueExit = joinBlock;
+
+        blocks.emplace_back(joinBlock);
+        block = joinBlock;
+        return varName;
+    }
+
     std::string rightName = traverseExpression(rightChild, block);
 
-    block->addInstruction(varName, leftName, getOperator(node->type), rightName);
+    std::string folded;
+    if (foldBinaryExpression(node->kind, leftName, rightName, folded)) return folded;
+
+    if (isArithmeticExpression(node->kind) || isLogicalExpression(node->kind)) {
+        std::string simplified;
+        if (simplifyBinaryExpression(node->kind, leftName, rightName, simplified)) {
+            return materialize(varName, simplified, block);
+        }
+
+        // Multiplying by two is an addition
+        int32_t value;
+        if (node->kind == NodeKind::MultExpression && (parseIntegerLiteral(leftName, value) && value == 2)) {
+            block->addInstruction(varName, rightName, getOperator(NodeKind::AddExpression), rightName);
+            return varName;
+        }
+        if (node->kind == NodeKind::MultExpression && (parseIntegerLiteral(rightName, value) && value == 2)) {
+            block->addInstruction(varName, leftName, getOperator(NodeKind::AddExpression), leftName);
+            return varName;
+        }
+    }
+
+    block->addInstruction(varName, leftName, getOperator(node->kind), rightName);
     return varName;
 }
 
-std::string ControlFlowGraph::traverseUnaryExpression(Node *node, BasicBlock *block) {
+std::string ControlFlowGraph::traverseUnaryExpression(Node *node, BasicBlock *&block) {
     if (!node) throw std::runtime_error("Unary expression node is null");
     if (node->children.size() != 1) throw std::runtime_error("Invalid number of children for unary expression");
 
@@ -426,28 +622,47 @@ std::string ControlFlowGraph::traverseUnaryExpression(Node *node, BasicBlock *bl
     if (!childNode) throw std::runtime_error("No child found for unary expression");
 
     std::string childName = traverseExpression(childNode, block);
-    block->addInstruction(varName, getOperator(node->type), childName);
+
+    bool value;
+    if (node->kind == NodeKind::NotExpression && parseBooleanLiteral(childName, value)) return value ? "false" : "true";
+
+    block->addInstruction(varName, getOperator(node->kind), childName);
+    return varName;
+}
+
+std::string ControlFlowGraph::materialize(const std::string &varName, const std::string &name, BasicBlock *block) {
+    // Literals and temporaries are never written again within the statement, but variables may be
+    int32_t value;
+    bool booleanValue;
+    if (parseIntegerLiteral(name, value) || parseBooleanLiteral(name, booleanValue) || isTemporary(name)) {
+        return name;
+    }
+    block->addInstruction(varName, "", name);
     return varName;
 }
 
-std::string ControlFlowGraph::traverseMethodCall(Node *node, BasicBlock *block) {
+std::string ControlFlowGraph::traverseMethodCall(Node *node, BasicBlock *&block) {
     if (!node) throw std::runtime_error("Method call node is null");
     if (node->children.size() != 2) throw std::runtime_error("Invalid number of children for method call");
 
     std::string varName = generateName();
 
-    std::string className = traverseExpression(node->children.front(), block);
-
     Node *callOnNode = node->children.front();
     Node *argsNode = node->children.back();
     if (!callOnNode || !argsNode) throw std::runtime_error("Invalid children for method call");
 
-    std::string methodName = node->value;
+    // Evaluate the receiver and all arguments before passing any of them, so that the
+    // params of nested calls never interleave with the params of this call
+    std::vector<std::string> params = {traverseExpression(callOnNode, block)};
     for (auto arg : argsNode->children) {
-        std::string argName = traverseExpression(arg, block);
-        block->addInstruction("param", argName);
+        params.push_back(traverseExpression(arg, block));
+    }
+
+    std::string methodName = node->value;
+    for (const auto &param : params) {
+        block->addInstruction(tac::PARAM, param);
     }
 
-    block->addInstruction(varName, methodName, "call", std::to_string(argsNode->children.size() + 1));
+    block->addInstruction(varName, methodName, tac::CALL, std::to_string(params.size()));
     return varName;
 }
@@ -11,43 +11,43 @@
 #include "HelperFunctions.h"
 #include "Node.h"
 #include "SymbolTable.h"
+#include "TacSymbols.h"
 
 class BasicBlock {
    private:
     struct ThreeAdressCode {
-        std::string result;
-        std::string arg1;
-        std::string op;
-        std::string arg2;
+        Symbol result;
+        Symbol arg1;
+        Symbol op;
+        Symbol arg2;
 
-        ThreeAdressCode(const std::string &result, const std::string &arg1, const std::string &op,
-                        const std::string &arg2)
+        ThreeAdressCode(Symbol result, Symbol arg1, Symbol op, Symbol arg2)
             : result(result), arg1(arg1), op(op), arg2(arg2) {}
     };
 
    public:
     std::string name;
+    std::string method;  // Qualified name of the method the block belongs to
     BasicBlock *trueExit;
     BasicBlock *falseExit;
 
     BasicBlock(const std::string &name) : name(name), trueExit(nullptr), falseExit(nullptr) {}
     BasicBlock() : name(generateBlockName()), trueExit(nullptr), falseExit(nullptr) {}
 
-    inline void addInstruction(const std::string &op, const std::string &arg1) {
-        tacInstructions.emplace_back("", arg1, op, "");
-    }
+    inline void addInstruction(Symbol op, Symbol arg1) { tacInstructions.emplace_back(Symbol(), arg1, op, Symbol()); }
 
-    inline void addInstruction(const std::string &result, const std::string &op, const std::string &arg1) {
-        tacInstructions.emplace_back(result, arg1, op, "");
+    inline void addInstruction(Symbol result, Symbol op, Symbol arg1) {
+        tacInstructions.emplace_back(result, arg1, op, Symbol());
     }
 
-    inline void addInstruction(const std::string &result, const std::string &arg1, const std::string &op,
-                               const std::string &arg2) {
+    inline void addInstruction(Symbol result, Symbol arg1, Symbol op, Symbol arg2) {
         tacInstructions.emplace_back(result, arg1, op, arg2);
     }
 
     std::vector<ThreeAdressCode> getTacInstructions() const { return tacInstructions; }
 
+    inline void clearInstructions() { tacInstructions.clear(); }
+
    private:
     static int tempCounter;
     std::vector<ThreeAdressCode> tacInstructions;
@@ -78,16 +78,19 @@ class ControlFlowGraph {
     void traverseClassDeclarationList(Node *node);
     void traverseClassDeclaration(Node *node);
     void traverseMethodDeclaration(Node *node);
+    void assignMethod(size_t firstBlock, const std::string &methodName);
     BasicBlock *traverseCode(Node *node, BasicBlock *block);
     BasicBlock *traverseStatement(Node *node, BasicBlock *block);
     BasicBlock *traversePrintStatement(Node *node, BasicBlock *block);
     BasicBlock *traverseWhileStatement(Node *node, BasicBlock *block);
     BasicBlock *traverseIfStatement(Node *node, BasicBlock *block);
     BasicBlock *traverseIfElseStatement(Node *node, BasicBlock *block);
-    std::string traverseExpression(Node *node, BasicBlock *block);
-    std::string traverseUnaryExpression(Node *node, BasicBlock *block);
-    std::string traverseBinaryExpression(Node *node, BasicBlock *block);
-    std::string traverseMethodCall(Node *node, BasicBlock *block);
+    void traverseCondition(Node *node, BasicBlock *block, BasicBlock *trueBlock, BasicBlock *falseBlock);
+    std::string traverseExpression(Node *node, BasicBlock *&block);
+    std::string traverseUnaryExpression(Node *node, BasicBlock *&block);
+    std::string traverseBinaryExpression(Node *node, BasicBlock *&block);
+    std::string traverseMethodCall(Node *node, BasicBlock *&block);
+    std::string materialize(const std::string &varName, const std::string &name, BasicBlock *block);
 
    public:
     /**
@@ -95,6 +98,7 @@ class ControlFlowGraph {
      * @return The blocks of the control flow graph.
      */
     const std::vector<BasicBlock *> &getBlocks() const { return blocks; }
+    std::vector<BasicBlock *> &getBlocks() { return blocks; }
 };
 
 #endif  // INTERMEDIATE_REPRESENTATION_H
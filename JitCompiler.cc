@@ -0,0 +1,477 @@
+#include "JitCompiler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "StackMachineInterpreter.h"
+
+#if defined(__x86_64__) && defined(__unix__) && !defined(NO_JIT)
+#define JIT_AVAILABLE 1
+#include <sys/mman.h>
+#else
+#define JIT_AVAILABLE 0
+#endif
+
+const int JitCompiler::MAX_STACK_DEPTH;
+
+#if JIT_AVAILABLE
+
+// Compiled code reads and writes whole StackValues as 8-byte words
+static_assert(sizeof(StackValue) == 8, "StackValue must be one machine word");
+static_assert(offsetof(StackValue, value) == 0, "StackValue::value must come first");
+static_assert(offsetof(StackValue, isBoolean) == 4, "StackValue::isBoolean must follow the value");
+
+namespace {
+
+// Register numbers in x86-64 encodings
+enum Register : uint8_t { RAX = 0, RCX = 1, RSI = 6, RDI = 7 };
+
+// Condition codes, the low nibble of setcc, jcc and cmovcc
+enum Condition : uint8_t { CC_E = 0x4, CC_NE = 0x5, CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF };
+
+const Register FRAME = RDI;  // First argument: the current frame
+const Register STACK = RSI;  // Second argument: the operand stack buffer
+
+// An operand stack entry during compilation. Constants and loads are only emitted when they are used,
+// every other value lives in the stack buffer at the position of the entry.
+struct StackEntry {
+    enum Kind { CONSTANT, LOCAL, BUFFERED } kind;
+    int32_t number;  // The constant or the slot of the local
+    bool isBoolean;
+};
+
+class Assembler {
+   public:
+    std::vector<uint8_t> bytes;
+
+    void byte(uint8_t b) { bytes.push_back(b); }
+
+    void imm32(int32_t value) {
+        uint8_t raw[4];
+        std::memcpy(raw, &value, sizeof(raw));
+        bytes.insert(bytes.end(), raw, raw + sizeof(raw));
+    }
+
+    // [base + disp32] with the given register or opcode extension in the reg field
+    void memory(uint8_t reg, Register base, int32_t disp) {
+        byte(0x80 | (reg << 3) | base);
+        imm32(disp);
+    }
+
+    // mov eax, imm32 / mov ecx, imm32
+    void moveImmediate(Register reg, int32_t value) {
+        byte(0xB8 + reg);
+        imm32(value);
+    }
+
+    // mov reg32, [base + disp]
+    void load32(Register reg, Register base, int32_t disp) {
+        byte(0x8B);
+        memory(reg, base, disp);
+    }
+
+    // mov [base + disp], eax
+    void store32(Register base, int32_t disp) {
+        byte(0x89);
+        memory(RAX, base, disp);
+    }
+
+    // mov dword [base + disp], imm32
+    void storeImmediate(Register base, int32_t disp, int32_t value) {
+        byte(0xC7);
+        memory(0, base, disp);
+        imm32(value);
+    }
+
+    // mov rax, [from + fromDisp]; mov [to + toDisp], rax
+    void copyWord(Register from, int32_t fromDisp, Register to, int32_t toDisp) {
+        byte(0x48);
+        byte(0x8B);
+        memory(RAX, from, fromDisp);
+        byte(0x48);
+        byte(0x89);
+        memory(RAX, to, toDisp);
+    }
+
+    // setcc al; movzx eax, al
+    void setCondition(Condition cc) {
+        byte(0x0F);
+        byte(0x90 | cc);
+        byte(0xC0);
+        byte(0x0F);
+        byte(0xB6);
+        byte(0xC0);
+    }
+
+    // test eax, eax
+    void testEax() {
+        byte(0x85);
+        byte(0xC0);
+    }
+
+    // Returns target when cc holds and next otherwise: mov eax, next; mov ecx, target; cmovcc eax, ecx; ret
+    void branchReturn(Condition cc, int32_t target, int32_t next) {
+        moveImmediate(RAX, next);
+        moveImmediate(RCX, target);
+        byte(0x0F);
+        byte(0x40 | cc);
+        byte(0xC1);
+        byte(0xC3);
+    }
+
+    // mov eax, address; ret
+    void returnAddress(int32_t address) {
+        moveImmediate(RAX, address);
+        byte(0xC3);
+    }
+};
+
+int32_t frameOffset(int slot) { return slot * static_cast<int32_t>(sizeof(StackValue)); }
+
+// Emits code for one block, tracking the operand stack symbolically
+class BlockCompiler {
+   public:
+    BlockCompiler(const std::vector<Instruction> &code, size_t start, size_t end)
+        : code(code), start(start), end(end) {}
+
+    /**
+     * @brief Generates the code of the block
+     * @param exitDepth Receives the number of values the block leaves on the operand stack
+     * @return False if the first instruction could not be compiled
+     */
+    bool run(int &exitDepth);
+
+    const std::vector<uint8_t> &getBytes() const { return as.bytes; }
+
+   private:
+    const std::vector<Instruction> &code;
+    size_t start;
+    size_t end;
+    Assembler as;
+    std::vector<StackEntry> stack;
+
+    int32_t bufferOffset(size_t index) const { return static_cast<int32_t>(index * sizeof(StackValue)); }
+
+    // Writes an entry into its place in the stack buffer
+    void materialize(size_t index);
+    void materializeAll();
+
+    // mov eax, <entry>
+    void loadEax(size_t index);
+
+    // <op> eax, <entry> for the ALU instructions add, sub and cmp, or imul
+    void operateEax(uint8_t memoryOpcode, uint8_t immediateOpcode, size_t index);
+    void multiplyEax(size_t index);
+
+    // Stores eax as the result at the position of an entry, with the given boolean flag
+    void storeResult(size_t index, bool isBoolean);
+
+    // Compares the top two entries and returns target when cc holds between them, and next otherwise
+    void compareAndBranch(Condition cc, int32_t target, int32_t next);
+
+    bool compileInstruction(size_t address, bool &blockEnded);
+};
+
+void BlockCompiler::materialize(size_t index) {
+    StackEntry &entry = stack[index];
+    if (entry.kind == StackEntry::CONSTANT) {
+        as.storeImmediate(STACK, bufferOffset(index), entry.number);
+        as.storeImmediate(STACK, bufferOffset(index) + 4, entry.isBoolean ? 1 : 0);
+    } else if (entry.kind == StackEntry::LOCAL) {
+        as.copyWord(FRAME, frameOffset(entry.number), STACK, bufferOffset(index));
+    }
+    entry.kind = StackEntry::BUFFERED;
+}
+
+void BlockCompiler::materializeAll() {
+    for (size_t i = 0; i < stack.size(); i++) materialize(i);
+}
+
+void BlockCompiler::loadEax(size_t index) {
+    const StackEntry &entry = stack[index];
+    if (entry.kind == StackEntry::CONSTANT) {
+        as.moveImmediate(RAX, entry.number);
+    } else if (entry.kind == StackEntry::LOCAL) {
+        as.load32(RAX, FRAME, frameOffset(entry.number));
+    } else {
+        as.load32(RAX, STACK, bufferOffset(index));
+    }
+}
+
+void BlockCompiler::operateEax(uint8_t memoryOpcode, uint8_t immediateOpcode, size_t index) {
+    const StackEntry &entry = stack[index];
+    if (entry.kind == StackEntry::CONSTANT) {
+        as.byte(immediateOpcode);
+        as.imm32(entry.number);
+        return;
+    }
+    as.byte(memoryOpcode);
+    if (entry.kind == StackEntry::LOCAL) {
+        as.memory(RAX, FRAME, frameOffset(entry.number));
+    } else {
+        as.memory(RAX, STACK, bufferOffset(index));
+    }
+}
+
+void BlockCompiler::multiplyEax(size_t index) {
+    const StackEntry &entry = stack[index];
+    if (entry.kind == StackEntry::CONSTANT) {
+        // imul eax, eax, imm32
+        as.byte(0x69);
+        as.byte(0xC0);
+        as.imm32(entry.number);
+        return;
+    }
+    // imul eax, [mem]
+    as.byte(0x0F);
+    as.byte(0xAF);
+    if (entry.kind == StackEntry::LOCAL) {
+        as.memory(RAX, FRAME, frameOffset(entry.number));
+    } else {
+        as.memory(RAX, STACK, bufferOffset(index));
+    }
+}
+
+void BlockCompiler::storeResult(size_t index, bool isBoolean) {
+    as.store32(STACK, bufferOffset(index));
+    as.storeImmediate(STACK, bufferOffset(index) + 4, isBoolean ? 1 : 0);
+}
+
+void BlockCompiler::compareAndBranch(Condition cc, int32_t target, int32_t next) {
+    size_t depth = stack.size();
+    StackEntry right = stack.back();
+    stack.pop_back();
+    StackEntry left = stack.back();
+    stack.pop_back();
+    materializeAll();
+    stack.push_back(left);
+    stack.push_back(right);
+
+    loadEax(depth - 2);
+    operateEax(0x3B, 0x3D, depth - 1);
+    stack.resize(depth - 2);
+    as.branchReturn(cc, target, next);
+}
+
+bool BlockCompiler::run(int &exitDepth) {
+    size_t address = start;
+    bool blockEnded = false;
+    while (address < end && !blockEnded) {
+        if (!compileInstruction(address, blockEnded)) break;
+        address = blockEnded ? address : address + 1;
+    }
+    if (address == start && !blockEnded) return false;
+
+    // Leave the rest of the block to the interpreter
+    if (!blockEnded) {
+        materializeAll();
+        as.returnAddress(static_cast<int32_t>(address));
+    }
+    exitDepth = static_cast<int>(stack.size());
+    return true;
+}
+
+bool BlockCompiler::compileInstruction(size_t address, bool &blockEnded) {
+    const Instruction &instruction = code[address];
+    size_t depth = stack.size();
+
+    switch (instruction.opcode) {
+        case OpCode::ILOAD:
+        case OpCode::ICONST: {
+            if (depth >= static_cast<size_t>(JitCompiler::MAX_STACK_DEPTH)) return false;
+            if (instruction.opcode == OpCode::ILOAD) {
+                stack.push_back({StackEntry::LOCAL, instruction.operand, false});
+            } else {
+                stack.push_back({StackEntry::CONSTANT, instruction.operand, instruction.isBoolean});
+            }
+            return true;
+        }
+        case OpCode::ISTORE: {
+            if (depth < 1) return false;
+
+            // Pending loads of the overwritten local have to read the old value
+            for (size_t i = 0; i + 1 < depth; i++) {
+                if (stack[i].kind == StackEntry::LOCAL && stack[i].number == instruction.operand) materialize(i);
+            }
+            const StackEntry &value = stack.back();
+            int32_t target = frameOffset(instruction.operand);
+            if (value.kind == StackEntry::CONSTANT) {
+                as.storeImmediate(FRAME, target, value.number);
+                as.storeImmediate(FRAME, target + 4, value.isBoolean ? 1 : 0);
+            } else if (value.kind == StackEntry::LOCAL) {
+                if (value.number != instruction.operand) as.copyWord(FRAME, frameOffset(value.number), FRAME, target);
+            } else {
+                as.copyWord(STACK, bufferOffset(depth - 1), FRAME, target);
+            }
+            stack.pop_back();
+            return true;
+        }
+        case OpCode::IADD:
+        case OpCode::ISUB:
+        case OpCode::IMUL: {
+            if (depth < 2) return false;
+            loadEax(depth - 2);
+            if (instruction.opcode == OpCode::IADD) {
+                operateEax(0x03, 0x05, depth - 1);
+            } else if (instruction.opcode == OpCode::ISUB) {
+                operateEax(0x2B, 0x2D, depth - 1);
+            } else {
+                multiplyEax(depth - 1);
+            }
+            storeResult(depth - 2, false);
+            stack.pop_back();
+            stack.back() = {StackEntry::BUFFERED, 0, false};
+            return true;
+        }
+        case OpCode::ILT:
+        case OpCode::IGT:
+        case OpCode::IEQ: {
+            if (depth < 2) return false;
+            Condition cc = instruction.opcode == OpCode::ILT ? CC_L : instruction.opcode == OpCode::IGT ? CC_G : CC_E;
+
+            // A comparison that only feeds the branch ending the block never becomes a value
+            if (address + 1 < end && code[address + 1].opcode == OpCode::IFFALSEGOTO) {
+                Condition isFalse = cc == CC_L ? CC_GE : cc == CC_G ? CC_LE : CC_NE;
+                compareAndBranch(isFalse, code[address + 1].operand, static_cast<int32_t>(address + 2));
+                blockEnded = true;
+                return true;
+            }
+
+            loadEax(depth - 2);
+            operateEax(0x3B, 0x3D, depth - 1);
+            as.setCondition(cc);
+            storeResult(depth - 2, true);
+            stack.pop_back();
+            stack.back() = {StackEntry::BUFFERED, 0, true};
+            return true;
+        }
+        case OpCode::IAND:
+        case OpCode::IOR: {
+            if (depth < 2) return false;
+            // test eax, eax; setne cl
+            loadEax(depth - 2);
+            as.testEax();
+            as.byte(0x0F);
+            as.byte(0x95);
+            as.byte(0xC1);
+            // test eax, eax; setne al; and/or al, cl; movzx eax, al
+            loadEax(depth - 1);
+            as.testEax();
+            as.byte(0x0F);
+            as.byte(0x95);
+            as.byte(0xC0);
+            as.byte(instruction.opcode == OpCode::IAND ? 0x20 : 0x08);
+            as.byte(0xC8);
+            as.byte(0x0F);
+            as.byte(0xB6);
+            as.byte(0xC0);
+            storeResult(depth - 2, true);
+            stack.pop_back();
+            stack.back() = {StackEntry::BUFFERED, 0, true};
+            return true;
+        }
+        case OpCode::INOT: {
+            if (depth < 1) return false;
+            loadEax(depth - 1);
+            as.testEax();
+            as.setCondition(CC_E);
+            storeResult(depth - 1, true);
+            stack.back() = {StackEntry::BUFFERED, 0, true};
+            return true;
+        }
+        case OpCode::GOTO: {
+            materializeAll();
+            as.returnAddress(instruction.operand);
+            blockEnded = true;
+            return true;
+        }
+        case OpCode::IFFALSEGOTO:
+        case OpCode::IFNE: {
+            if (depth < 1) return false;
+            StackEntry condition = stack.back();
+            stack.pop_back();
+            materializeAll();
+            stack.push_back(condition);
+            loadEax(depth - 1);
+            stack.pop_back();
+            as.testEax();
+            as.branchReturn(instruction.opcode == OpCode::IFNE ? CC_NE : CC_E, instruction.operand,
+                            static_cast<int32_t>(address + 1));
+            blockEnded = true;
+            return true;
+        }
+        case OpCode::IF_ICMPLT:
+        case OpCode::IF_ICMPGE:
+        case OpCode::IF_ICMPGT:
+        case OpCode::IF_ICMPLE:
+        case OpCode::IF_ICMPEQ:
+        case OpCode::IF_ICMPNE: {
+            if (depth < 2) return false;
+            static const Condition conditions[] = {CC_L, CC_GE, CC_G, CC_LE, CC_E, CC_NE};
+            Condition cc = conditions[static_cast<int>(instruction.opcode) - static_cast<int>(OpCode::IF_ICMPLT)];
+            compareAndBranch(cc, instruction.operand, static_cast<int32_t>(address + 1));
+            blockEnded = true;
+            return true;
+        }
+        default:
+            // Calls, returns, output, division and heap access stay in the interpreter
+            return false;
+    }
+}
+
+}  // namespace
+
+bool JitCompiler::isAvailable() { return true; }
+
+JitCompiler::~JitCompiler() {
+    for (const CodeRegion &region : regions) munmap(region.base, region.size);
+}
+
+void *JitCompiler::install(const std::vector<uint8_t> &bytes) {
+    if (regions.empty() || regions.back().used + bytes.size() > regions.back().size) {
+        const size_t regionSize = 1 << 20;
+        size_t size = std::max(regionSize, bytes.size());
+        void *base = mmap(nullptr, size, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) return nullptr;
+        regions.push_back({static_cast<uint8_t *>(base), size, 0});
+    }
+
+    // Regions are only writable while code is copied into them
+    CodeRegion &region = regions.back();
+    if (mprotect(region.base, region.size, PROT_READ | PROT_WRITE) != 0) return nullptr;
+    uint8_t *target = region.base + region.used;
+    std::memcpy(target, bytes.data(), bytes.size());
+    region.used += bytes.size();
+    if (mprotect(region.base, region.size, PROT_READ | PROT_EXEC) != 0) return nullptr;
+    return target;
+}
+
+bool JitCompiler::compile(const std::vector<Instruction> &code, size_t start, size_t end, CompiledBlock &compiled) {
+    BlockCompiler compiler(code, start, end);
+    int exitDepth = 0;
+    if (!compiler.run(exitDepth)) return false;
+
+    void *entry = install(compiler.getBytes());
+    if (!entry) return false;
+
+    compiled.entry = reinterpret_cast<CompiledBlock::Entry>(entry);
+    compiled.exitDepth = exitDepth;
+    compiledBlocks++;
+    codeSize += compiler.getBytes().size();
+    return true;
+}
+
+#else
+
+bool JitCompiler::isAvailable() { return false; }
+
+JitCompiler::~JitCompiler() {}
+
+void *JitCompiler::install(const std::vector<uint8_t> &bytes) { return nullptr; }
+
+bool JitCompiler::compile(const std::vector<Instruction> &code, size_t start, size_t end, CompiledBlock &compiled) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef JITCOMPILER_H
+#define JITCOMPILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Heap.h"
+
+struct Instruction;
+
+// Native code for a linked block. The function receives the current frame and a buffer for the operand
+// stack, and returns the address where interpretation continues. The values the block leaves on the
+// operand stack are in the first exitDepth entries of the buffer.
+struct CompiledBlock {
+    typedef size_t (*Entry)(StackValue *frame, StackValue *stack);
+
+    Entry entry = nullptr;
+    int exitDepth = 0;
+};
+
+/*
+ * Baseline compiler from linked bytecode to x86-64 machine code.
+ *
+ * Compiles the straight-line integer part of a block: loads, stores, constants, arithmetic, comparisons,
+ * boolean operators and the jump ending the block. Code generation stops at the first other instruction,
+ * which is then left to the interpreter. Loads and constants are kept symbolic until an instruction needs
+ * them, and a comparison followed by iffalsegoto becomes a single compare and conditional move.
+ *
+ * Only available on x86-64 with mmap, and disabled by building with NO_JIT.
+ */
+class JitCompiler {
+   public:
+    // Size of the operand stack buffer passed to compiled code
+    static const int MAX_STACK_DEPTH = 64;
+
+    JitCompiler() = default;
+    JitCompiler(const JitCompiler &) = delete;
+    JitCompiler &operator=(const JitCompiler &) = delete;
+    ~JitCompiler();
+
+    /**
+     * @brief Checks whether native code can be generated and run on this platform
+     * @return True if compile can succeed
+     */
+    static bool isAvailable();
+
+    /**
+     * @brief Compiles the start of a block to native code
+     * @param code The linked program
+     * @param start The address of the first instruction of the block
+     * @param end The address one past the last instruction of the block
+     * @param compiled Receives the entry point and exit depth
+     * @return False if not even the first instruction could be compiled
+     */
+    bool compile(const std::vector<Instruction> &code, size_t start, size_t end, CompiledBlock &compiled);
+
+    size_t getCompiledBlocks() const { return compiledBlocks; }
+    size_t getCodeSize() const { return codeSize; }
+
+   private:
+    // Executable memory, filled from the front and never freed before the compiler is destroyed
+    struct CodeRegion {
+        uint8_t *base;
+        size_t size;
+        size_t used;
+    };
+
+    std::vector<CodeRegion> regions;
+    size_t compiledBlocks = 0;
+    size_t codeSize = 0;
+
+    /**
+     * @brief Copies machine code into executable memory
+     * @param bytes The machine code
+     * @return The address of the copy, or nullptr if no memory could be mapped
+     */
+    void *install(const std::vector<uint8_t> &bytes);
+};
+
+#endif  // JITCOMPILER_H
@@ -4,27 +4,193 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
-#include <list>
+#include <new>
+#include <string>
 #include <vector>
 
+#include "Symbol.h"
+
 using namespace std;
 
+class Node;
+class NodeArena;
+
+// The kinds of nodes the parser builds
+enum class NodeKind : uint8_t {
+    // Declarations
+    Goal,
+    MainClass,
+    StringArgs,
+    ClassDeclarationList,
+    ClassDeclaration,
+    VarDeclarationList,
+    VarDeclaration,
+    MethodDeclarationList,
+    MethodDeclaration,
+    ParameterList,
+    Variable,
+    Type,
+    Code,
+    Return,
+    StatementList,
+    Condition,
+
+    // Statements
+    IfStatement,
+    IfElseStatement,
+    WhileStatement,
+    PrintStatement,
+    VarInitStatement,
+    ArrayInitStatement,
+
+    // Expressions
+    AndExpression,
+    OrExpression,
+    LTExpression,
+    GTExpression,
+    EqualExpression,
+    AddExpression,
+    SubExpression,
+    MultExpression,
+    ArrayExpression,
+    LengthExpression,
+    MethodCallExpression,
+    NotExpression,
+    NewIntArrayExpression,
+    NewObjectExpression,
+    IntLiteral,
+    BoolLiteral,
+    ThisExpression,
+    Identifier,
+    ArgumentList
+};
+
+// Gets the name of a kind of node, as the tree dump and error messages show it
+inline std::string getKindName(NodeKind kind) {
+    switch (kind) {
+        case NodeKind::Goal:
+            return "Goal";
+        case NodeKind::MainClass:
+            return "MainClass";
+        case NodeKind::StringArgs:
+            return "StringArgs";
+        case NodeKind::ClassDeclarationList:
+            return "ClassDeclarationList";
+        case NodeKind::ClassDeclaration:
+            return "ClassDeclaration";
+        case NodeKind::VarDeclarationList:
+            return "VarDeclarationList";
+        case NodeKind::VarDeclaration:
+            return "VarDeclaration";
+        case NodeKind::MethodDeclarationList:
+            return "MethodDeclarationList";
+        case NodeKind::MethodDeclaration:
+            return "MethodDeclaration";
+        case NodeKind::ParameterList:
+            return "ParameterList";
+        case NodeKind::Variable:
+            return "Variable";
+        case NodeKind::Type:
+            return "Type";
+        case NodeKind::Code:
+            return "Code";
+        case NodeKind::Return:
+            return "Return";
+        case NodeKind::StatementList:
+            return "StatementList";
+        case NodeKind::Condition:
+            return "Condition";
+        case NodeKind::IfStatement:
+            return "IfStatement";
+        case NodeKind::IfElseStatement:
+            return "IfElseStatement";
+        case NodeKind::WhileStatement:
+            return "WhileStatement";
+        case NodeKind::PrintStatement:
+            return "PrintStatement";
+        case NodeKind::VarInitStatement:
+            return "VarInitStatement";
+        case NodeKind::ArrayInitStatement:
+            return "ArrayInitStatement";
+        case NodeKind::AndExpression:
+            return "AndExpression";
+        case NodeKind::OrExpression:
+            return "OrExpression";
+        case NodeKind::LTExpression:
+            return "LTExpression";
+        case NodeKind::GTExpression:
+            return "GTExpression";
+        case NodeKind::EqualExpression:
+            return "EqualExpression";
+        case NodeKind::AddExpression:
+            return "AddExpression";
+        case NodeKind::SubExpression:
+            return "SubExpression";
+        case NodeKind::MultExpression:
+            return "MultExpression";
+        case NodeKind::ArrayExpression:
+            return "ArrayExpression";
+        case NodeKind::LengthExpression:
+            return "LengthExpression";
+        case NodeKind::MethodCallExpression:
+            return "MethodCallExpression";
+        case NodeKind::NotExpression:
+            return "NotExpression";
+        case NodeKind::NewIntArrayExpression:
+            return "NewIntArrayExpression";
+        case NodeKind::NewObjectExpression:
+            return "NewObjectExpression";
+        case NodeKind::IntLiteral:
+            return "IntLiteral";
+        case NodeKind::BoolLiteral:
+            return "BoolLiteral";
+        case NodeKind::ThisExpression:
+            return "ThisExpression";
+        case NodeKind::Identifier:
+            return "Identifier";
+        case NodeKind::ArgumentList:
+            return "ArgumentList";
+    }
+    return "Unknown";
+}
+
+// The children of a node, stored contiguously in the arena the node was created in
+class NodeList {
+   public:
+    explicit NodeList(NodeArena *arena) : arena(arena), items(nullptr), count(0), capacity(0) {}
+
+    Node **begin() const { return items; }
+    Node **end() const { return items + count; }
+    Node *front() const { return items[0]; }
+    Node *back() const { return items[count - 1]; }
+    Node *operator[](size_t index) const { return items[index]; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Appends a child, moving the list to twice the space when it is full. The old space stays in the arena.
+    void push_back(Node *child);
+
+   private:
+    NodeArena *arena;
+    Node **items;
+    uint32_t count, capacity;
+};
+
 class Node {
    public:
     int id, lineno;
-    string type, value;
-    list<Node *> children;
-    Node(string t, string v, int l) : type(t), value(v), lineno(l) {}
-    Node() {
-        type = "uninitialised";
-        value = "uninitialised";
-    }  // Bison needs this.
+    NodeKind kind;
+    Symbol value;  // The identifier, literal or type the node carries, if any
+    NodeList children;
+    Node(NodeArena *arena, NodeKind k, Symbol v, int l) : lineno(l), kind(k), value(v), children(arena) {}
 
     void print_tree(int depth = 0) {
         for (int i = 0; i < depth; i++) cout << "  ";
-        cout << type << ":" << value << endl;  //<< " @line: "<< lineno << endl;
+        cout << getKindName(kind) << ":" << value << endl;  //<< " @line: "<< lineno << endl;
         for (auto i = children.begin(); i != children.end(); i++) (*i)->print_tree(depth + 1);
     }
 
@@ -44,7 +210,7 @@ class Node {
 
     void generate_tree_content(int &count, ofstream *outStream) {
         id = count++;
-        *outStream << "n" << id << " [label=\"" << type << ":" << value << "\"];" << endl;
+        *outStream << "n" << id << " [label=\"" << getKindName(kind) << ":" << value << "\"];" << endl;
 
         for (auto i = children.begin(); i != children.end(); i++) {
             (*i)->generate_tree_content(count, outStream);
@@ -53,4 +219,88 @@ class Node {
     }
 };
 
-#endif
\ No newline at end of file
+/*
+ * Owns the nodes of a syntax tree and the arrays of their children.
+ *
+ * Nodes are created in chunks of many nodes each and child arrays are carved out of larger chunks, so building
+ * a tree makes few allocations and keeps nodes created together close in memory. Nothing is freed on its own:
+ * the whole tree goes at once when the arena is released.
+ */
+class NodeArena {
+   public:
+    NodeArena() : nodesLeft(0), childrenNext(nullptr), childrenEnd(nullptr) {}
+    NodeArena(const NodeArena &) = delete;
+    NodeArena &operator=(const NodeArena &) = delete;
+    ~NodeArena() { release(); }
+
+    /**
+     * @brief Creates a node without children.
+     * @param kind The kind of node.
+     * @param value The identifier, literal or type the node carries, if any.
+     * @param lineno The line the node starts on.
+     * @return The node, which lives until the arena is released.
+     */
+    Node *create(NodeKind kind, Symbol value, int lineno) {
+        if (nodesLeft == 0) {
+            nodeChunks.push_back(static_cast<Node *>(::operator new(NODES_PER_CHUNK * sizeof(Node))));
+            nodesLeft = NODES_PER_CHUNK;
+        }
+        Node *node = nodeChunks.back() + (NODES_PER_CHUNK - nodesLeft--);
+        return new (node) Node(this, kind, value, lineno);
+    }
+
+    /**
+     * @brief Allocates space for the children of a node.
+     * @param count The number of children.
+     * @return Uninitialized space for the children.
+     */
+    Node **allocateChildren(size_t count) {
+        if (static_cast<size_t>(childrenEnd - childrenNext) < count) {
+            size_t size = count > CHILDREN_PER_CHUNK ? count : CHILDREN_PER_CHUNK;
+            childrenChunks.push_back(static_cast<Node **>(::operator new(size * sizeof(Node *))));
+            childrenNext = childrenChunks.back();
+            childrenEnd = childrenNext + size;
+        }
+        Node **children = childrenNext;
+        childrenNext += count;
+        return children;
+    }
+
+    /**
+     * @brief Destroys every node created so far and frees the memory of the arena.
+     */
+    void release() {
+        for (size_t chunk = 0; chunk < nodeChunks.size(); chunk++) {
+            size_t used = chunk + 1 < nodeChunks.size() ? NODES_PER_CHUNK : NODES_PER_CHUNK - nodesLeft;
+            for (size_t i = 0; i < used; i++) nodeChunks[chunk][i].~Node();
+            ::operator delete(nodeChunks[chunk]);
+        }
+        for (Node **chunk : childrenChunks) ::operator delete(chunk);
+        nodeChunks.clear();
+        childrenChunks.clear();
+        nodesLeft = 0;
+        childrenNext = childrenEnd = nullptr;
+    }
+
+   private:
+    static const size_t NODES_PER_CHUNK = 1024;
+    static const size_t CHILDREN_PER_CHUNK = 4096;
+
+    std::vector<Node *> nodeChunks;
+    size_t nodesLeft;  // Free nodes in the last chunk
+    std::vector<Node **> childrenChunks;
+    Node **childrenNext;
+    Node **childrenEnd;
+};
+
+inline void NodeList::push_back(Node *child) {
+    if (count == capacity) {
+        capacity = capacity ? capacity * 2 : 2;
+        Node **grown = arena->allocateChildren(capacity);
+        if (count) std::memcpy(grown, items, count * sizeof(Node *));
+        items = grown;
+    }
+    items[count++] = child;
+}
+
+#endif
@@ -0,0 +1,952 @@
+#include "OptimizationPasses.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+// Gets the value of an integer or boolean literal, failing for integers the interpreter would reject
+bool parseLiteral(Symbol name, int32_t &value) {
+    if (name == tac::TRUE_LITERAL || name == tac::FALSE_LITERAL) {
+        value = name == tac::TRUE_LITERAL ? 1 : 0;
+        return true;
+    }
+    return parseIntegerLiteral(name, value);
+}
+
+Symbol booleanLiteral(bool value) { return value ? tac::TRUE_LITERAL : tac::FALSE_LITERAL; }
+
+bool isCommutative(Symbol op) {
+    return op == tac::ADD || op == tac::MUL || op == tac::EQUAL || op == tac::AND || op == tac::OR;
+}
+
+bool isArithmeticOrLogical(Symbol op) {
+    return op == tac::ADD || op == tac::SUB || op == tac::MUL || op == tac::LESS || op == tac::GREATER ||
+           op == tac::EQUAL || op == tac::AND || op == tac::OR || op == tac::NOT;
+}
+
+// Folds an operation on literals, with the 32-bit wraparound of the interpreter, or returns false
+bool fold(Symbol op, Symbol left, Symbol right, Symbol &result) {
+    int32_t a = 0, b = 0;
+    if (!parseLiteral(left, a) || (!right.empty() && !parseLiteral(right, b))) return false;
+    uint32_t ua = static_cast<uint32_t>(a), ub = static_cast<uint32_t>(b);
+    if (op.empty()) {
+        result = left;
+    } else if (op == tac::NOT) {
+        result = booleanLiteral(a == 0);
+    } else if (op == tac::ADD) {
+        result = Symbol(std::to_string(static_cast<int32_t>(ua + ub)));
+    } else if (op == tac::SUB) {
+        result = Symbol(std::to_string(static_cast<int32_t>(ua - ub)));
+    } else if (op == tac::MUL) {
+        result = Symbol(std::to_string(static_cast<int32_t>(ua * ub)));
+    } else if (op == tac::LESS) {
+        result = booleanLiteral(a < b);
+    } else if (op == tac::GREATER) {
+        result = booleanLiteral(a > b);
+    } else if (op == tac::EQUAL) {
+        result = booleanLiteral(a == b);
+    } else if (op == tac::AND) {
+        result = booleanLiteral(a != 0 && b != 0);
+    } else if (op == tac::OR) {
+        result = booleanLiteral(a != 0 || b != 0);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// A natural loop: its header and the blocks that reach a back edge to it without passing through it
+struct Loop {
+    int header;
+    std::set<int> blocks;
+    std::vector<int> latches;  // The blocks with a back edge to the header
+};
+
+// Finds the natural loops of a function, merging loops that share a header, with inner loops first
+std::vector<Loop> findLoops(const SSAFunction &function) {
+    const DominatorTree &dominators = function.getDominatorTree();
+    std::map<int, Loop> loops;
+    for (size_t b = 0; b < function.blocks.size(); b++) {
+        const SSABlock &block = function.blocks[b];
+        if (block.removed) continue;
+        for (int exit : {block.trueExit, block.falseExit}) {
+            if (exit < 0 || !dominators.dominates(exit, b)) continue;
+            Loop &loop = loops[exit];
+            loop.header = exit;
+            if (std::count(loop.latches.begin(), loop.latches.end(), static_cast<int>(b))) continue;
+            loop.latches.push_back(b);
+            loop.blocks.insert(exit);
+            std::vector<int> worklist = {static_cast<int>(b)};
+            while (!worklist.empty()) {
+                int node = worklist.back();
+                worklist.pop_back();
+                if (!loop.blocks.insert(node).second) continue;
+                for (int predecessor : function.blocks[node].predecessors) worklist.push_back(predecessor);
+            }
+        }
+    }
+
+    std::vector<Loop> ordered;
+    for (auto &loop : loops) ordered.push_back(std::move(loop.second));
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [](const Loop &a, const Loop &b) { return a.blocks.size() < b.blocks.size(); });
+    return ordered;
+}
+
+// Gets the block every entry into a loop comes from, adding one if there is none, or -1 for the method entry
+int getPreheader(SSAFunction &function, const Loop &loop, std::vector<Loop> &loops) {
+    std::vector<int> entering;
+    for (int predecessor : function.blocks[loop.header].predecessors) {
+        if (!loop.blocks.count(predecessor)) entering.push_back(predecessor);
+    }
+    if (entering.empty()) return -1;
+    const SSABlock &single = function.blocks[entering.front()];
+    if (entering.size() == 1 && single.trueExit == loop.header && single.falseExit < 0) return entering.front();
+
+    // The new block is part of every loop around this one
+    int preheader = function.addPreheader(loop.header, entering);
+    for (auto &outer : loops) {
+        if (&outer != &loop && outer.blocks.count(loop.header)) outer.blocks.insert(preheader);
+    }
+    return preheader;
+}
+}  // namespace
+
+void PassManager::run(ControlFlowGraph &cfg, const SymbolTable &symbolTable) {
+    std::vector<BasicBlock *> &blocks = cfg.getBlocks();
+    std::vector<BasicBlock *> optimized;
+
+    // The blocks of a method are contiguous and start with its entry, so methods are optimized one range at a
+    // time. Duplicate methods share a name, but each has an entry block of its own.
+    size_t first = 0;
+    while (first < blocks.size()) {
+        size_t last = first + 1;
+        while (last < blocks.size() && blocks[last]->method == blocks[first]->method &&
+               blocks[last]->name != blocks[last]->method) {
+            last++;
+        }
+        std::vector<BasicBlock *> methodBlocks(blocks.begin() + first, blocks.begin() + last);
+
+        const std::string &methodName = blocks[first]->method;
+        std::string className = methodName.substr(0, methodName.find('.'));
+        std::string name = methodName.substr(methodName.find('.') + 1);
+        const Method *method = nullptr;
+        if (symbolTable.hasClass(className) && symbolTable.getClass(className).hasMethod(name)) {
+            method = &symbolTable.getClass(className).getMethod(name);
+        }
+
+        SSAFunction function(methodBlocks, method);
+        for (const auto &pass : passes) changes[pass->getName()] += pass->run(function);
+        std::vector<BasicBlock *> lowered = function.lower();
+
+        // Blocks the passes found unreachable are gone for good
+        std::unordered_set<BasicBlock *> kept(lowered.begin(), lowered.end());
+        for (BasicBlock *block : methodBlocks) {
+            if (!kept.count(block)) delete block;
+        }
+        optimized.insert(optimized.end(), lowered.begin(), lowered.end());
+        first = last;
+    }
+
+    blocks = optimized;
+}
+
+int SparseConditionalConstantPropagation::run(SSAFunction &function) {
+    // Lattice of every value: unknown yet, a constant, or not constant
+    enum State { UNKNOWN, CONSTANT, VARYING };
+    struct Lattice {
+        State state;
+        Symbol constant;
+    };
+    std::vector<Lattice> lattice(function.values.size(), {UNKNOWN, Symbol()});
+    for (size_t i = 0; i < function.values.size(); i++) {
+        if (function.values[i].isEntry) lattice[i].state = VARYING;
+    }
+
+    std::vector<SSABlock> &blocks = function.blocks;
+    std::vector<std::vector<std::pair<int, int>>> uses(function.values.size());
+    for (size_t b = 0; b < blocks.size(); b++) {
+        for (size_t i = 0; i < blocks[b].instructions.size(); i++) {
+            blocks[b].instructions[i].forEachUse([&](SSAOperand &operand) {
+                if (operand.isValue()) uses[operand.value].push_back({b, i});
+            });
+        }
+    }
+
+    auto operandLattice = [&](const SSAOperand &operand) -> Lattice {
+        if (operand.isValue()) return lattice[operand.value];
+        int32_t value;
+        if (parseLiteral(operand.name, value)) return {CONSTANT, operand.name};
+        return {VARYING, Symbol()};
+    };
+
+    std::vector<std::pair<int, int>> flowWorklist = {{-1, function.entry}};
+    std::vector<std::pair<int, int>> ssaWorklist;
+    std::set<std::pair<int, int>> executableEdges;
+    std::vector<bool> executable(blocks.size(), false);
+
+    // Values only ever move down the lattice, so every instruction is revisited a bounded number of times
+    auto lower = [&](int value, const Lattice &newLattice) {
+        Lattice &old = lattice[value];
+        if (newLattice.state == UNKNOWN || old.state == VARYING) return;
+        if (old.state == CONSTANT && newLattice.state == CONSTANT && old.constant == newLattice.constant) return;
+        old = old.state == CONSTANT ? Lattice{VARYING, Symbol()} : newLattice;
+        ssaWorklist.insert(ssaWorklist.end(), uses[value].begin(), uses[value].end());
+    };
+
+    auto visit = [&](int b, int i) {
+        SSAInstruction &instruction = blocks[b].instructions[i];
+        if (instruction.op == tac::PHI) {
+            Lattice merged = {UNKNOWN, Symbol()};
+            for (const auto &operand : instruction.incoming) {
+                if (!executableEdges.count({operand.first, b})) continue;
+                Lattice incoming = operandLattice(operand.second);
+                if (incoming.state == UNKNOWN) continue;
+                if (merged.state == UNKNOWN) {
+                    merged = incoming;
+                } else if (incoming.state == VARYING || incoming.constant != merged.constant) {
+                    merged = {VARYING, Symbol()};
+                }
+            }
+            lower(instruction.result.value, merged);
+        } else if (instruction.op == tac::IF) {
+            Lattice condition = operandLattice(instruction.arg1);
+            int32_t value = 0;
+            if (condition.state == CONSTANT && parseLiteral(condition.constant, value)) {
+                int target = value != 0 ? blocks[b].trueExit : blocks[b].falseExit;
+                if (target >= 0) flowWorklist.push_back({b, target});
+            } else if (condition.state == VARYING) {
+                if (blocks[b].trueExit >= 0) flowWorklist.push_back({b, blocks[b].trueExit});
+                if (blocks[b].falseExit >= 0) flowWorklist.push_back({b, blocks[b].falseExit});
+            }
+        } else if (instruction.getDefinedValue() >= 0) {
+            Lattice result = {VARYING, Symbol()};
+            if (isArithmeticOrLogical(instruction.op) || instruction.op.empty()) {
+                Lattice left = operandLattice(instruction.arg1);
+                Lattice right = instruction.arg2.isValue() || !instruction.arg2.name.empty()
+                                    ? operandLattice(instruction.arg2)
+                                    : Lattice{CONSTANT, Symbol()};
+                Symbol folded;
+                if (left.state == VARYING || right.state == VARYING) {
+                    result = {VARYING, Symbol()};
+                } else if (left.state == UNKNOWN || right.state == UNKNOWN) {
+                    result = {UNKNOWN, Symbol()};
+                } else if (fold(instruction.op, left.constant, right.constant, folded)) {
+                    result = {CONSTANT, folded};
+                }
+            }
+            lower(instruction.result.value, result);
+        }
+    };
+
+    while (!flowWorklist.empty() || !ssaWorklist.empty()) {
+        while (!flowWorklist.empty()) {
+            std::pair<int, int> edge = flowWorklist.back();
+            flowWorklist.pop_back();
+            if (!executableEdges.insert(edge).second) continue;
+
+            // Phis see every new edge, the other instructions only need the first visit
+            int b = edge.second;
+            bool firstVisit = !executable[b];
+            executable[b] = true;
+            for (size_t i = 0; i < blocks[b].instructions.size(); i++) {
+                if (firstVisit || blocks[b].instructions[i].op == tac::PHI) visit(b, i);
+            }
+            bool branches = !blocks[b].instructions.empty() && blocks[b].instructions.back().op == tac::IF;
+            if (firstVisit && !branches && blocks[b].trueExit >= 0) flowWorklist.push_back({b, blocks[b].trueExit});
+        }
+        while (!ssaWorklist.empty()) {
+            std::pair<int, int> use = ssaWorklist.back();
+            ssaWorklist.pop_back();
+            if (executable[use.first]) visit(use.first, use.second);
+        }
+    }
+
+    // Replace reads of constants, except in phis, whose operands have to stay values until lowering
+    int changed = 0;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        if (!executable[b]) continue;
+        for (auto &instruction : blocks[b].instructions) {
+            if (instruction.op == tac::PHI) continue;
+            instruction.forEachUse([&](SSAOperand &operand) {
+                if (!operand.isValue() || lattice[operand.value].state != CONSTANT) return;
+                operand.name = lattice[operand.value].constant;
+                operand.value = -1;
+                changed++;
+            });
+        }
+
+        // A branch on a constant keeps only the edge it takes
+        SSABlock &block = blocks[b];
+        if (block.instructions.empty() || block.instructions.back().op != tac::IF) continue;
+        int32_t value = 0;
+        if (!parseLiteral(block.instructions.back().arg1.name, value)) continue;
+        if (value == 0) block.trueExit = block.falseExit;
+        block.falseExit = -1;
+        block.instructions.pop_back();
+        changed++;
+    }
+
+    // Blocks that are never executed can only be reached through branches that were just folded
+    return changed + function.removeUnreachableBlocks();
+}
+
+int GlobalValueNumbering::run(SSAFunction &function) {
+    std::vector<int> leaders(function.values.size());
+    for (size_t i = 0; i < leaders.size(); i++) leaders[i] = i;
+
+    // Operations by their operator and operand values, scoped to the dominator tree path being visited
+    std::unordered_map<std::string, int> available;
+    int changed = 0;
+
+    std::function<void(int)> visit = [&](int b) {
+        std::vector<std::string> added;
+        for (auto &instruction : function.blocks[b].instructions) {
+            if (instruction.op == tac::PHI) continue;
+            instruction.forEachUse([&](SSAOperand &operand) {
+                if (operand.isValue() && leaders[operand.value] != operand.value) {
+                    operand.value = leaders[operand.value];
+                }
+            });
+
+            // Fields can change between two reads, so only operations on values, literals and this qualify
+            int value = instruction.getDefinedValue();
+            if (value < 0 || !isArithmeticOrLogical(instruction.op)) continue;
+            std::vector<std::string> keys;
+            bool qualifies = true;
+            instruction.forEachUse([&](SSAOperand &operand) {
+                if (operand.isValue()) {
+                    keys.push_back("%" + std::to_string(operand.value));
+                } else if (SSAFunction::isLiteral(operand.name) || operand.name == tac::THIS) {
+                    keys.push_back(operand.name);
+                } else {
+                    qualifies = false;
+                }
+            });
+            if (!qualifies) continue;
+            if (isCommutative(instruction.op)) std::sort(keys.begin(), keys.end());
+            std::string key = instruction.op;
+            for (const auto &operandKey : keys) key += "|" + operandKey;
+
+            auto it = available.find(key);
+            if (it != available.end()) {
+                leaders[value] = it->second;
+                function.values[it->second].needsName = true;
+                changed++;
+            } else {
+                available[key] = value;
+                added.push_back(key);
+            }
+        }
+
+        for (int child : function.getDominatorTree().getChildren(b)) visit(child);
+        for (const auto &key : added) available.erase(key);
+    };
+    visit(function.entry);
+    return changed;
+}
+
+int LoopInvariantCodeMotion::run(SSAFunction &function) {
+    std::vector<Loop> loops = findLoops(function);
+    std::vector<int> definingBlocks(function.values.size(), -1);  // -1 for values held on entry
+    for (size_t b = 0; b < function.blocks.size(); b++) {
+        for (const auto &instruction : function.blocks[b].instructions) {
+            if (instruction.getDefinedValue() >= 0) definingBlocks[instruction.getDefinedValue()] = b;
+        }
+    }
+
+    int moved = 0;
+    std::set<int> movedValues;
+    for (const auto &loop : loops) {
+        // Fields keep their value unless the loop writes them, or calls a method that might
+        bool fieldsChange = false;
+        std::set<std::string> written;
+        for (int b : loop.blocks) {
+            for (const auto &instruction : function.blocks[b].instructions) {
+                if (instruction.op == tac::CALL || instruction.op == tac::STORE_FIELD) fieldsChange = true;
+                if (instruction.definesResult() && !instruction.result.isValue()) {
+                    written.insert(instruction.result.name);
+                }
+            }
+        }
+        std::set<int> invariantValues;
+        auto isInvariant = [&](const SSAOperand &operand) {
+            if (operand.isValue()) {
+                return !loop.blocks.count(definingBlocks[operand.value]) || invariantValues.count(operand.value) > 0;
+            }
+            return SSAFunction::isLiteral(operand.name) || operand.name == tac::THIS ||
+                   (!fieldsChange && !written.count(operand.name));
+        };
+
+        // Blocks are visited in reverse postorder, so operands are found invariant before what reads them
+        std::vector<std::pair<int, size_t>> sites;
+        for (int b : function.getDominatorTree().getReversePostorder()) {
+            if (!loop.blocks.count(b)) continue;
+            bool effects = false;  // Something before in the block has an effect or can fail
+            for (size_t i = 0; i < function.blocks[b].instructions.size(); i++) {
+                SSAInstruction &instruction = function.blocks[b].instructions[i];
+                int value = instruction.getDefinedValue();
+                bool canFail = instruction.op == tac::LENGTH;
+                bool movable = value >= 0 && isTemporary(function.values[value].variable) &&
+                               (isArithmeticOrLogical(instruction.op) || (canFail && b == loop.header && !effects));
+                if (movable) {
+                    instruction.forEachUse([&](SSAOperand &operand) { movable = movable && isInvariant(operand); });
+                }
+                if (movable) {
+                    invariantValues.insert(value);
+                    sites.emplace_back(b, i);
+                } else {
+                    effects = effects || !instruction.isPure();
+                }
+            }
+        }
+        if (sites.empty()) continue;
+        int preheader = getPreheader(function, loop, loops);
+        if (preheader < 0) continue;
+
+        // Moved values get a name of their own, as their variable may hold other versions in the loop
+        std::map<int, std::set<size_t>> removed;
+        for (const auto &site : sites) {
+            SSAInstruction &instruction = function.blocks[site.first].instructions[site.second];
+            function.values[instruction.getDefinedValue()].needsName = true;
+            function.blocks[preheader].instructions.push_back(instruction);
+            removed[site.first].insert(site.second);
+        }
+        for (const auto &block : removed) {
+            std::vector<SSAInstruction> &instructions = function.blocks[block.first].instructions;
+            std::vector<SSAInstruction> kept;
+            for (size_t i = 0; i < instructions.size(); i++) {
+                if (!block.second.count(i)) kept.push_back(std::move(instructions[i]));
+            }
+            instructions = std::move(kept);
+        }
+        definingBlocks.resize(function.values.size(), preheader);
+        for (int value : invariantValues) definingBlocks[value] = preheader;
+        movedValues.insert(invariantValues.begin(), invariantValues.end());
+        moved += sites.size();
+    }
+
+    // Copies of moved values are read in their place, which leaves the copies in the loops for DCE to remove
+    std::vector<int> sources(function.values.size(), -1);
+    for (const auto &block : function.blocks) {
+        for (const auto &instruction : block.instructions) {
+            int value = instruction.getDefinedValue();
+            if (value >= 0 && instruction.op.empty() && instruction.arg1.isValue() &&
+                movedValues.count(instruction.arg1.value)) {
+                sources[value] = instruction.arg1.value;
+            }
+        }
+    }
+    // Phis keep reading the copies, since operands with another name than the phi would need copies again
+    for (auto &block : function.blocks) {
+        for (auto &instruction : block.instructions) {
+            if (instruction.op == tac::PHI) continue;
+            instruction.forEachUse([&](SSAOperand &operand) {
+                while (operand.isValue() && sources[operand.value] >= 0) operand.value = sources[operand.value];
+            });
+        }
+    }
+    return moved;
+}
+
+int StrengthReduction::run(SSAFunction &function) {
+    std::vector<Loop> loops = findLoops(function);
+    int reduced = 0;
+    for (const auto &loop : loops) {
+        if (loop.latches.size() != 1 || function.blocks[loop.latches.front()].falseExit >= 0) continue;
+        int latch = loop.latches.front();
+        std::vector<std::pair<int, size_t>> definitions(function.values.size(), {-1, 0});
+        for (size_t b = 0; b < function.blocks.size(); b++) {
+            for (size_t i = 0; i < function.blocks[b].instructions.size(); i++) {
+                int value = function.blocks[b].instructions[i].getDefinedValue();
+                if (value >= 0) definitions[value] = {b, i};
+            }
+        }
+        auto definitionOf = [&](int value) -> const SSAInstruction * {
+            if (value < 0 || definitions[value].first < 0) return nullptr;
+            return &function.blocks[definitions[value].first].instructions[definitions[value].second];
+        };
+
+        // Induction variables are header phis whose value on the back edge is their own plus a constant
+        struct Induction {
+            SSAOperand initial;
+            Symbol step;
+        };
+        std::map<int, Induction> inductions;
+        for (const auto &phi : function.blocks[loop.header].instructions) {
+            if (phi.op != tac::PHI) break;
+            if (phi.incoming.size() != 2 || phi.incoming[0].first == phi.incoming[1].first) continue;
+            bool fromLatch = phi.incoming[0].first == latch;
+            const SSAOperand &initial = phi.incoming[fromLatch ? 1 : 0].second;
+            const SSAOperand &next = phi.incoming[fromLatch ? 0 : 1].second;
+            if (!fromLatch && phi.incoming[1].first != latch) continue;
+
+            const SSAInstruction *update = next.isValue() ? definitionOf(next.value) : nullptr;
+            while (update && update->op.empty() && update->arg1.isValue()) update = definitionOf(update->arg1.value);
+            if (!update) continue;
+            int self = phi.result.value;
+            Symbol step;
+            if (update->op == tac::ADD && update->arg1.value == self && SSAFunction::isLiteral(update->arg2.name)) {
+                step = update->arg2.name;
+            } else if (update->op == tac::ADD && update->arg2.value == self &&
+                       SSAFunction::isLiteral(update->arg1.name)) {
+                step = update->arg1.name;
+            } else if (update->op != tac::SUB || update->arg1.value != self ||
+                       !fold(tac::SUB, tac::ZERO, update->arg2.name, step)) {
+                continue;
+            }
+            inductions[self] = {initial, step};
+        }
+        if (inductions.empty()) continue;
+
+        // Products of an induction variable and a factor that is a literal or defined before the loop
+        std::map<std::pair<int, std::string>, std::vector<std::pair<int, size_t>>> products;
+        std::map<std::pair<int, std::string>, SSAOperand> factors;
+        for (int b : loop.blocks) {
+            for (size_t i = 0; i < function.blocks[b].instructions.size(); i++) {
+                const SSAInstruction &instruction = function.blocks[b].instructions[i];
+                if (instruction.op != tac::MUL || instruction.getDefinedValue() < 0) continue;
+                for (int side = 0; side < 2; side++) {
+                    const SSAOperand &variable = side == 0 ? instruction.arg1 : instruction.arg2;
+                    const SSAOperand &factor = side == 0 ? instruction.arg2 : instruction.arg1;
+                    if (!variable.isValue() || !inductions.count(variable.value)) continue;
+                    std::string key;
+                    if (factor.isValue() && !loop.blocks.count(definitions[factor.value].first)) {
+                        key = "%" + std::to_string(factor.value);
+                    } else if (SSAFunction::isLiteral(factor.name)) {
+                        key = factor.name;
+                    } else {
+                        continue;
+                    }
+                    products[{variable.value, key}].emplace_back(b, i);
+                    factors[{variable.value, key}] = factor;
+                    break;
+                }
+            }
+        }
+        if (products.empty()) continue;
+        int preheader = getPreheader(function, loop, loops);
+        if (preheader < 0) continue;
+
+        int phis = 0;
+        for (const auto &product : products) {
+            const Induction &induction = inductions[product.first.first];
+            const SSAOperand &factor = factors[product.first];
+            auto operand = [&](int value) {
+                SSAOperand result;
+                result.value = value;
+                result.name = function.values[value].variable;
+                return result;
+            };
+            auto instruction = [](const SSAOperand &result, const SSAOperand &arg1, Symbol op,
+                                  const SSAOperand &arg2) {
+                SSAInstruction created;
+                created.op = op;
+                created.result = result;
+                created.arg1 = arg1;
+                created.arg2 = arg2;
+                return created;
+            };
+
+            // The product starts out in the preheader and steps by the step times the factor on the back edge
+            std::vector<SSAInstruction> &entry = function.blocks[preheader].instructions;
+            SSAOperand increment = factor;
+            if (induction.step != tac::ONE && !fold(tac::MUL, induction.step, factor.name, increment.name)) {
+                increment = operand(function.newTemporary());
+                SSAOperand step;
+                step.name = induction.step;
+                entry.push_back(instruction(increment, factor, tac::MUL, step));
+            }
+            SSAOperand initial = operand(function.newTemporary());
+            SSAOperand current = operand(function.newValue(initial.name));
+            SSAOperand next = operand(function.newValue(initial.name));
+            SSAOperand folded;
+            if (fold(tac::MUL, induction.initial.name, factor.name, folded.name)) {
+                entry.push_back(instruction(initial, folded, Symbol(), SSAOperand()));
+            } else {
+                entry.push_back(instruction(initial, induction.initial, tac::MUL, factor));
+            }
+            SSAInstruction phi;
+            phi.op = tac::PHI;
+            phi.result = current;
+            phi.incoming = {{preheader, initial}, {latch, next}};
+            function.blocks[loop.header].instructions.insert(function.blocks[loop.header].instructions.begin(), phi);
+            function.blocks[latch].instructions.push_back(instruction(next, current, tac::ADD, increment));
+            phis++;
+
+            // The phis went in front of the header, which moves the products there down
+            for (const auto &site : product.second) {
+                size_t index = site.second + (site.first == loop.header ? phis : 0);
+                SSAInstruction &multiplication = function.blocks[site.first].instructions[index];
+                multiplication.op = Symbol();
+                multiplication.arg1 = current;
+                multiplication.arg2 = SSAOperand();
+                reduced++;
+            }
+        }
+    }
+    return reduced;
+}
+
+int BoundsCheckElimination::run(SSAFunction &function) {
+    std::vector<SSABlock> &blocks = function.blocks;
+    const DominatorTree &dominators = function.getDominatorTree();
+    std::vector<std::pair<int, const SSAInstruction *>> definitions(function.values.size(), {-1, nullptr});
+    for (size_t b = 0; b < blocks.size(); b++) {
+        for (const auto &instruction : blocks[b].instructions) {
+            if (instruction.getDefinedValue() >= 0) definitions[instruction.getDefinedValue()] = {b, &instruction};
+        }
+    }
+
+    // Copies are looked through, so a value and its copies compare equal
+    auto source = [&](SSAOperand operand) {
+        while (operand.isValue() && definitions[operand.value].second &&
+               definitions[operand.value].second->op.empty()) {
+            operand = definitions[operand.value].second->arg1;
+        }
+        return operand;
+    };
+    auto same = [](const SSAOperand &a, const SSAOperand &b) {
+        return a.isValue() ? a.value == b.value : !b.isValue() && a.name == b.name;
+    };
+
+    // The comparisons a < b known to hold in a block, from the branches on the way to it in the dominator tree
+    auto getBounds = [&](int block) {
+        std::vector<std::pair<SSAOperand, SSAOperand>> bounds;
+        for (int node = block; node >= 0; node = dominators.getImmediateDominator(node)) {
+            if (blocks[node].predecessors.size() != 1) continue;
+            const SSABlock &branch = blocks[blocks[node].predecessors.front()];
+            if (branch.instructions.empty() || branch.instructions.back().op != tac::IF ||
+                branch.trueExit == branch.falseExit) {
+                continue;
+            }
+            SSAOperand condition = source(branch.instructions.back().arg1);
+            bool holds = branch.trueExit == node;
+            while (condition.isValue() && definitions[condition.value].second &&
+                   definitions[condition.value].second->op == tac::NOT) {
+                condition = source(definitions[condition.value].second->arg1);
+                holds = !holds;
+            }
+            const SSAInstruction *comparison = condition.isValue() ? definitions[condition.value].second : nullptr;
+            if (!holds || !comparison) continue;
+            if (comparison->op == tac::LESS) bounds.emplace_back(source(comparison->arg1), source(comparison->arg2));
+            if (comparison->op == tac::GREATER) bounds.emplace_back(source(comparison->arg2), source(comparison->arg1));
+        }
+        return bounds;
+    };
+
+    // Values that are never negative, assumed of every value at first and disproved until nothing changes
+    std::vector<bool> nonNegative(function.values.size(), true);
+    auto isNonNegative = [&](const SSAOperand &operand) {
+        int32_t literal = 0;
+        if (operand.isValue()) return static_cast<bool>(nonNegative[operand.value]);
+        return operand.name != tac::TRUE_LITERAL && operand.name != tac::FALSE_LITERAL &&
+               parseLiteral(operand.name, literal) && literal >= 0;
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t value = 0; value < function.values.size(); value++) {
+            if (!nonNegative[value]) continue;
+            const SSAInstruction *definition = definitions[value].second;
+            bool holds = false;
+            if (!definition) {
+                holds = false;  // Parameters can be anything
+            } else if (definition->op.empty()) {
+                holds = isNonNegative(definition->arg1);
+            } else if (definition->op == tac::PHI) {
+                holds = std::all_of(definition->incoming.begin(), definition->incoming.end(),
+                                    [&](const std::pair<int, SSAOperand> &operand) {
+                                        return isNonNegative(operand.second);
+                                    });
+            } else if (definition->op == tac::LENGTH) {
+                holds = true;
+            } else if (definition->op == tac::ADD && isNonNegative(definition->arg1) &&
+                       isNonNegative(definition->arg2)) {
+                // Adding at most one to a value below some bound cannot overflow
+                for (const SSAOperand *increment : {&definition->arg1, &definition->arg2}) {
+                    const SSAOperand &other = increment == &definition->arg1 ? definition->arg2 : definition->arg1;
+                    if (increment->isValue() || (increment->name != tac::ZERO && increment->name != tac::ONE)) continue;
+                    for (const auto &bound : getBounds(definitions[value].first)) {
+                        if (same(bound.first, source(other))) holds = true;
+                    }
+                }
+            }
+            if (!holds) {
+                nonNegative[value] = false;
+                changed = true;
+            }
+        }
+    }
+
+    // A field holding the array is only the same array if nothing between the length and the access can
+    // assign it: no store to it, no call and no store through another reference
+    auto clobbers = [&](const SSAInstruction &instruction, const std::string &field) {
+        return instruction.op == tac::CALL || instruction.op == tac::STORE_FIELD ||
+               (instruction.definesResult() && !instruction.result.isValue() && instruction.result.name == field);
+    };
+    auto isStable = [&](const std::string &field, int from, const SSAInstruction *length, int to,
+                        const SSAInstruction *access) {
+        // Blocks on a path from after the length to before the access, which may include both ends again
+        std::vector<bool> reached(blocks.size(), false), reaches(blocks.size(), false);
+        std::vector<int> worklist;
+        for (int exit : {blocks[from].trueExit, blocks[from].falseExit}) {
+            if (exit >= 0) worklist.push_back(exit);
+        }
+        while (!worklist.empty()) {
+            int block = worklist.back();
+            worklist.pop_back();
+            if (reached[block]) continue;
+            reached[block] = true;
+            for (int exit : {blocks[block].trueExit, blocks[block].falseExit}) {
+                if (exit >= 0) worklist.push_back(exit);
+            }
+        }
+        worklist = blocks[to].predecessors;
+        while (!worklist.empty()) {
+            int block = worklist.back();
+            worklist.pop_back();
+            if (reaches[block]) continue;
+            reaches[block] = true;
+            for (int predecessor : blocks[block].predecessors) worklist.push_back(predecessor);
+        }
+        for (size_t b = 0; b < blocks.size(); b++) {
+            if (!reached[b] || !reaches[b]) continue;
+            for (const auto &instruction : blocks[b].instructions) {
+                if (clobbers(instruction, field)) return false;
+            }
+        }
+
+        // The rest of the block with the length, and the start of the block with the access
+        const std::vector<SSAInstruction> &rest = blocks[from].instructions;
+        auto it = std::find_if(rest.begin(), rest.end(), [&](const SSAInstruction &other) { return &other == length; });
+        for (it = it == rest.end() ? it : it + 1; it != rest.end() && &*it != access; it++) {
+            if (clobbers(*it, field)) return false;
+        }
+        if (from == to) return true;
+        for (const auto &instruction : blocks[to].instructions) {
+            if (&instruction == access) break;
+            if (clobbers(instruction, field)) return false;
+        }
+        return true;
+    };
+
+    int unchecked = 0;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        std::vector<std::pair<SSAOperand, SSAOperand>> bounds;
+        bool boundsKnown = false;
+        for (auto &instruction : blocks[b].instructions) {
+            bool isLoad = instruction.op == tac::LOAD_INDEX;
+            if (!isLoad && instruction.op != tac::STORE_INDEX) continue;
+            SSAOperand array = source(isLoad ? instruction.arg1 : instruction.result);
+            SSAOperand index = source(isLoad ? instruction.arg2 : instruction.arg1);
+            if (!index.isValue() || !isNonNegative(index)) continue;
+            if (!boundsKnown) {
+                bounds = getBounds(b);
+                boundsKnown = true;
+            }
+
+            for (const auto &bound : bounds) {
+                const SSAOperand &limit = bound.second;
+                if (!same(bound.first, index) || !limit.isValue()) continue;
+                const SSAInstruction *length = definitions[limit.value].second;
+                if (!length || length->op != tac::LENGTH || !same(source(length->arg1), array)) continue;
+                int from = definitions[limit.value].first;
+                if (!array.isValue() && !isStable(array.name, from, length, b, &instruction)) continue;
+                instruction.op = isLoad ? tac::LOAD_INDEX_UNCHECKED : tac::STORE_INDEX_UNCHECKED;
+                unchecked++;
+                break;
+            }
+        }
+    }
+    return unchecked;
+}
+
+int DeadCodeElimination::run(SSAFunction &function) {
+    std::vector<SSABlock> &blocks = function.blocks;
+    std::vector<std::pair<int, int>> definitions(function.values.size(), {-1, -1});
+    for (size_t b = 0; b < blocks.size(); b++) {
+        for (size_t i = 0; i < blocks[b].instructions.size(); i++) {
+            SSAInstruction &instruction = blocks[b].instructions[i];
+            if (instruction.getDefinedValue() >= 0) definitions[instruction.getDefinedValue()] = {b, i};
+        }
+    }
+
+    // Writes to a variable that is also read before any write keep it stored, as the interpreter expects. Only
+    // reads that stay count, so marking repeats until the variables read on entry are known.
+    std::set<std::string> readOnEntry;
+    std::vector<std::vector<bool>> live(blocks.size());
+    for (size_t b = 0; b < blocks.size(); b++) live[b].assign(blocks[b].instructions.size(), false);
+    std::vector<std::pair<int, int>> worklist;
+    size_t known;
+    do {
+        known = readOnEntry.size();
+        for (size_t b = 0; b < blocks.size(); b++) {
+            for (size_t i = 0; i < blocks[b].instructions.size(); i++) {
+                const SSAInstruction &instruction = blocks[b].instructions[i];
+                int value = instruction.getDefinedValue();
+                if (live[b][i]) continue;
+                if (!instruction.isPure() || (value >= 0 && readOnEntry.count(function.values[value].variable))) {
+                    live[b][i] = true;
+                    worklist.push_back({b, i});
+                }
+            }
+        }
+        while (!worklist.empty()) {
+            std::pair<int, int> site = worklist.back();
+            worklist.pop_back();
+            blocks[site.first].instructions[site.second].forEachUse([&](SSAOperand &operand) {
+                if (!operand.isValue()) return;
+                if (function.values[operand.value].isEntry) {
+                    readOnEntry.insert(function.values[operand.value].variable);
+                }
+                std::pair<int, int> definition = definitions[operand.value];
+                if (definition.first < 0 || live[definition.first][definition.second]) return;
+                live[definition.first][definition.second] = true;
+                worklist.push_back(definition);
+            });
+        }
+    } while (readOnEntry.size() != known);
+
+    int removed = 0;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        std::vector<SSAInstruction> kept;
+        for (size_t i = 0; i < blocks[b].instructions.size(); i++) {
+            if (live[b][i]) {
+                kept.push_back(std::move(blocks[b].instructions[i]));
+            } else {
+                removed++;
+            }
+        }
+        blocks[b].instructions = std::move(kept);
+    }
+    return removed;
+}
+
+int ControlFlowSimplification::run(ControlFlowGraph &cfg) {
+    std::vector<BasicBlock *> &blocks = cfg.getBlocks();
+    std::vector<BasicBlock *> simplified;
+    int removed = 0;
+
+    auto isEntry = [](const BasicBlock *block) { return block->name == block->method; };
+
+    // Follows a jump through empty blocks to the first block with instructions, or with no jump out of it
+    auto thread = [&](BasicBlock *target) {
+        std::unordered_set<BasicBlock *> visited;
+        while (target && !isEntry(target) && target->trueExit && !target->falseExit &&
+               target->getTacInstructions().empty() && visited.insert(target).second) {
+            target = target->trueExit;
+        }
+        return target;
+    };
+
+    size_t first = 0;
+    while (first < blocks.size()) {
+        size_t last = first + 1;
+        while (last < blocks.size() && blocks[last]->method == blocks[first]->method &&
+               blocks[last]->name != blocks[last]->method) {
+            last++;
+        }
+
+        for (size_t b = first; b < last; b++) {
+            BasicBlock *block = blocks[b];
+            block->trueExit = thread(block->trueExit);
+            block->falseExit = thread(block->falseExit);
+
+            // A branch whose exits meet only evaluates a condition, which has no effects
+            if (!block->falseExit || block->falseExit != block->trueExit) continue;
+            auto instructions = block->getTacInstructions();
+            if (!instructions.empty() && instructions.back().op == tac::IF) {
+                block->clearInstructions();
+                for (size_t i = 0; i + 1 < instructions.size(); i++) {
+                    block->addInstruction(instructions[i].result, instructions[i].arg1, instructions[i].op,
+                                          instructions[i].arg2);
+                }
+                block->falseExit = nullptr;
+            }
+        }
+
+        // Blocks no longer reached from the entry are dropped, once their predecessors are counted
+        std::unordered_set<BasicBlock *> reachable = {blocks[first]};
+        std::unordered_map<BasicBlock *, int> predecessors;
+        std::vector<BasicBlock *> worklist = {blocks[first]};
+        while (!worklist.empty()) {
+            BasicBlock *block = worklist.back();
+            worklist.pop_back();
+            for (BasicBlock *exit : {block->trueExit, block->falseExit}) {
+                if (!exit) continue;
+                predecessors[exit]++;
+                if (reachable.insert(exit).second) worklist.push_back(exit);
+            }
+        }
+
+        // A block jumping to a block with no other predecessor takes over its instructions and exits. The merged
+        // block goes where the generated code falls through to it or from it to one of its exits, preferring the
+        // position of the first block. When both positions are fallen through, merging would trade one jump for
+        // another, which is only worth it for the join of && and ||: the temporary it branches on becomes local
+        // to the block, and the comparison computing it is fused with the branch. The entry stays first.
+        std::vector<BasicBlock *> layout;
+        for (size_t b = first; b < last; b++) {
+            if (reachable.count(blocks[b])) {
+                layout.push_back(blocks[b]);
+            } else {
+                delete blocks[b];
+                removed++;
+            }
+        }
+        std::unordered_map<BasicBlock *, size_t> positions;
+        for (size_t i = 0; i < layout.size(); i++) positions[layout[i]] = i;
+        auto neighbour = [&](size_t i, int direction) -> BasicBlock * {
+            for (i += direction; i < layout.size(); i += direction) {
+                if (layout[i]) return layout[i];
+            }
+            return nullptr;
+        };
+        auto isExit = [](const BasicBlock *block, const BasicBlock *exit) {
+            return exit && (block->trueExit == exit || block->falseExit == exit);
+        };
+
+        for (size_t i = 0; i < layout.size(); i++) {
+            BasicBlock *block = layout[i];
+            while (block && block->trueExit && !block->falseExit) {
+                BasicBlock *next = block->trueExit;
+                if (next == block || isEntry(next) || predecessors[next] != 1) break;
+                auto instructions = block->getTacInstructions();
+                if (!instructions.empty() && instructions.back().op == tac::RETURN) break;
+
+                size_t from = positions[block], to = positions[next];
+                bool entered = isEntry(block) || isExit(neighbour(from, -1), block);
+                bool left = isExit(next, neighbour(to, 1));
+                auto taken = next->getTacInstructions();
+                bool branchesOnTemporary = taken.size() == 1 && taken[0].op == tac::IF && isTemporary(taken[0].arg1);
+                if (entered && left && neighbour(from, 1) != next && !branchesOnTemporary) break;
+                for (const auto &instruction : taken) {
+                    block->addInstruction(instruction.result, instruction.arg1, instruction.op, instruction.arg2);
+                }
+                block->trueExit = next->trueExit;
+                block->falseExit = next->falseExit;
+                delete next;
+                removed++;
+                if (left && !entered) {
+                    layout[from] = nullptr;
+                    layout[to] = block;
+                    positions[block] = to;
+                } else {
+                    layout[to] = nullptr;
+                }
+            }
+        }
+        for (BasicBlock *block : layout) {
+            if (block) simplified.push_back(block);
+        }
+        first = last;
+    }
+
+    blocks = simplified;
+    return removed;
+}
@@ -0,0 +1,163 @@
+#ifndef OPTIMIZATIONPASSES_H
+#define OPTIMIZATIONPASSES_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "IntermediateRepresentation.h"
+#include "StaticSingleAssignment.h"
+#include "SymbolTable.h"
+
+// An optimization over one method in SSA form
+class SSAPass {
+   public:
+    virtual ~SSAPass() {}
+
+    /**
+     * @brief Gets the name the pass is reported under.
+     * @return The name of the pass.
+     */
+    virtual const char *getName() const = 0;
+
+    /**
+     * @brief Optimizes a method.
+     * @param function The method in SSA form.
+     * @return The number of changes made.
+     */
+    virtual int run(SSAFunction &function) = 0;
+};
+
+/*
+ * Runs a pipeline of SSA passes over every method of a control flow graph.
+ *
+ * Each method is converted to SSA form, optimized by the passes in the order they were added, and lowered
+ * back to TAC in place, so the bytecode and assembly generators see an ordinary control flow graph.
+ */
+class PassManager {
+   public:
+    /**
+     * @brief Appends a pass to the pipeline.
+     * @param pass The pass to run.
+     */
+    void addPass(std::unique_ptr<SSAPass> pass) { passes.push_back(std::move(pass)); }
+
+    /**
+     * @brief Optimizes every method of a control flow graph.
+     * @param cfg The control flow graph, whose blocks are rewritten.
+     * @param symbolTable The symbol table, used to tell parameters and locals from fields.
+     */
+    void run(ControlFlowGraph &cfg, const SymbolTable &symbolTable);
+
+    /**
+     * @brief Gets the number of changes each pass made, by pass name.
+     * @return The changes per pass.
+     */
+    const std::map<std::string, int> &getStats() const { return changes; }
+
+   private:
+    std::vector<std::unique_ptr<SSAPass>> passes;
+    std::map<std::string, int> changes;
+};
+
+/*
+ * Sparse conditional constant propagation (Wegman and Zadeck).
+ *
+ * Propagates constants along SSA edges and only through control flow edges that can be taken, so constants
+ * flowing around loops and branches decided by constants are found too. Reads of constant values are
+ * replaced by literals, branches on constants become jumps and blocks that are never reached are removed.
+ */
+class SparseConditionalConstantPropagation : public SSAPass {
+   public:
+    const char *getName() const override { return "sccp"; }
+    int run(SSAFunction &function) override;
+};
+
+/*
+ * Global value numbering over the dominator tree.
+ *
+ * An arithmetic or logical operation computing the same operation on the same values as one in a dominating
+ * block is redundant, and its reads are redirected to the earlier result.
+ */
+class GlobalValueNumbering : public SSAPass {
+   public:
+    const char *getName() const override { return "gvn"; }
+    int run(SSAFunction &function) override;
+};
+
+/*
+ * Loop-invariant code motion.
+ *
+ * Natural loops are found from their back edges, innermost first. An operation whose operands do not change
+ * inside a loop is moved to the loop's preheader, a block added before the header where the loop is entered,
+ * so it is computed once instead of on every iteration. Arithmetic and logic are moved from anywhere in the
+ * loop, as they cannot fail. An array length can fail, so it is only moved from the header when nothing with
+ * an effect comes before it there: the header runs whenever the preheader does.
+ */
+class LoopInvariantCodeMotion : public SSAPass {
+   public:
+    const char *getName() const override { return "licm"; }
+    int run(SSAFunction &function) override;
+};
+
+/*
+ * Strength reduction of induction variables.
+ *
+ * A variable that a loop steps by a constant on every iteration is an induction variable. A product of one
+ * with a loop invariant factor then steps by a constant too, so it gets a variable of its own that starts out
+ * as the product in the preheader and is increased at the end of every iteration, and the multiplication
+ * becomes a copy of it.
+ */
+class StrengthReduction : public SSAPass {
+   public:
+    const char *getName() const override { return "sr"; }
+    int run(SSAFunction &function) override;
+};
+
+/*
+ * Bounds-check elimination.
+ *
+ * An array access is within bounds when the index is known not to be negative, and the access is dominated by
+ * a branch that found the index below the length of the same array, as in while (i < a.length). An index is
+ * known not to be negative when it is built from literals, lengths and increments that cannot overflow, which
+ * covers a loop counter that starts at zero and counts up below a bound. Such accesses become the unchecked[
+ * and unchecked[]= operations, which are generated without the bounds check.
+ */
+class BoundsCheckElimination : public SSAPass {
+   public:
+    const char *getName() const override { return "bce"; }
+    int run(SSAFunction &function) override;
+};
+
+/*
+ * Dead code elimination.
+ *
+ * Marks instructions with effects and everything they transitively read, and removes the rest.
+ */
+class DeadCodeElimination : public SSAPass {
+   public:
+    const char *getName() const override { return "dce"; }
+    int run(SSAFunction &function) override;
+};
+
+/*
+ * Control flow graph simplification.
+ *
+ * Statements always get blocks of their own, and inlining and SSA lowering add more, so the graph ends up with
+ * empty blocks and chains of blocks joined by unconditional jumps. Jumps to empty blocks are threaded through to
+ * where they lead, a branch whose exits meet becomes a jump, a block is merged into the block it only ever comes
+ * from, and blocks that can no longer be reached are removed. Method entries are kept, as the generators store
+ * the receiver and parameters there.
+ */
+class ControlFlowSimplification {
+   public:
+    /**
+     * @brief Simplifies the blocks of every method.
+     * @param cfg The control flow graph, whose blocks are rewritten.
+     * @return The number of blocks removed.
+     */
+    int run(ControlFlowGraph &cfg);
+};
+
+#endif  // OPTIMIZATIONPASSES_H
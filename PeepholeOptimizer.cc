@@ -0,0 +1,348 @@
+#include "PeepholeOptimizer.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <iterator>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Instructions = std::vector<std::unique_ptr<BCInstruction>>;
+
+// One position of a pattern: a specific opcode, a constant pushed by iconst or a boolean literal, or anything
+struct PatternElement {
+    enum Kind { OPCODE, CONSTANT, ANY } kind;
+    OpCode opcode;
+};
+
+PatternElement op(OpCode opcode) { return {PatternElement::OPCODE, opcode}; }
+const PatternElement CONSTANT = {PatternElement::CONSTANT, OpCode::ICONST};
+const PatternElement ANY = {PatternElement::ANY, OpCode::ICONST};
+
+// The surroundings of a match that guards may look at
+struct PeepholeContext {
+    const Instructions &code;
+    const std::string *nextBlock;          // Name of the block laid out after this one, or null
+    const std::set<std::string> &liveOut;  // Temporaries read after the block exits
+};
+
+/*
+ * A rule rewrites the instructions matched by its pattern, starting at position. The rewrite returns false
+ * when its guard does not hold, and otherwise fills replacement with the instructions that take their place.
+ */
+struct PeepholeRule {
+    const char *name;
+    std::vector<PatternElement> pattern;
+    bool (*rewrite)(const PeepholeContext &context, size_t position, Instructions &replacement);
+};
+
+bool getConstant(const BCInstruction &instruction, int32_t &value, bool &isBoolean) {
+    Symbol argument = instruction.getArgument();
+    if (instruction.getOpcode() == OpCode::ILOAD && (argument == tac::TRUE_LITERAL || argument == tac::FALSE_LITERAL)) {
+        value = argument == tac::TRUE_LITERAL ? 1 : 0;
+        isBoolean = true;
+        return true;
+    }
+    if (instruction.getOpcode() != OpCode::ICONST) return false;
+
+    // Constants the interpreter would reject are left for it to report
+    errno = 0;
+    char *end = nullptr;
+    long long parsed = std::strtoll(argument.c_str(), &end, 10);
+    if (argument.empty() || *end != '\0' || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX) return false;
+    value = static_cast<int32_t>(parsed);
+    isBoolean = false;
+    return true;
+}
+
+std::unique_ptr<BCInstruction> makeConstant(int32_t value, bool isBoolean) {
+    // The text format has no boolean constants, the interpreter turns boolean literals into them
+    if (isBoolean) return std::make_unique<BCInstruction>(OpCode::ILOAD, value ? tac::TRUE_LITERAL : tac::FALSE_LITERAL);
+    return std::make_unique<BCInstruction>(OpCode::ICONST, std::to_string(value));
+}
+
+// Replaces two constants and the operation combining them by its result, computed as the interpreter would
+bool foldBinary(const PeepholeContext &context, size_t position, Instructions &replacement) {
+    int32_t a, b;
+    bool aIsBoolean, bIsBoolean;
+    getConstant(*context.code[position], a, aIsBoolean);
+    getConstant(*context.code[position + 1], b, bIsBoolean);
+
+    // Arithmetic wraps around like the 32-bit integers of the interpreter
+    uint32_t ua = static_cast<uint32_t>(a), ub = static_cast<uint32_t>(b);
+    switch (context.code[position + 2]->getOpcode()) {
+        case OpCode::IADD:
+            replacement.push_back(makeConstant(static_cast<int32_t>(ua + ub), false));
+            return true;
+        case OpCode::ISUB:
+            replacement.push_back(makeConstant(static_cast<int32_t>(ua - ub), false));
+            return true;
+        case OpCode::IMUL:
+            replacement.push_back(makeConstant(static_cast<int32_t>(ua * ub), false));
+            return true;
+        case OpCode::ILT:
+            replacement.push_back(makeConstant(a < b, true));
+            return true;
+        case OpCode::IGT:
+            replacement.push_back(makeConstant(a > b, true));
+            return true;
+        case OpCode::IEQ:
+            replacement.push_back(makeConstant(a == b, true));
+            return true;
+        case OpCode::IAND:
+            replacement.push_back(makeConstant(a != 0 && b != 0, true));
+            return true;
+        case OpCode::IOR:
+            replacement.push_back(makeConstant(a != 0 || b != 0, true));
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool foldNot(const PeepholeContext &context, size_t position, Instructions &replacement) {
+    int32_t value;
+    bool isBoolean;
+    getConstant(*context.code[position], value, isBoolean);
+    replacement.push_back(makeConstant(value == 0, true));
+    return true;
+}
+
+// A conditional jump on a constant either always falls through to the true exit or always jumps
+bool foldBranch(const PeepholeContext &context, size_t position, Instructions &replacement) {
+    int32_t value;
+    bool isBoolean;
+    getConstant(*context.code[position], value, isBoolean);
+    const BCInstruction &jump = *context.code[position + 1];
+    if ((value != 0) == (jump.getOpcode() == OpCode::IFNE)) {
+        replacement.push_back(std::make_unique<BCInstruction>(OpCode::GOTO, jump.getArgument()));
+    }
+    return true;
+}
+
+// A comparison of two constants jumps always or never
+bool foldCompareBranch(const PeepholeContext &context, size_t position, Instructions &replacement) {
+    int32_t a, b;
+    bool aIsBoolean, bIsBoolean;
+    getConstant(*context.code[position], a, aIsBoolean);
+    getConstant(*context.code[position + 1], b, bIsBoolean);
+    const BCInstruction &jump = *context.code[position + 2];
+
+    bool taken = false;
+    switch (jump.getOpcode()) {
+        case OpCode::IF_ICMPLT:
+            taken = a < b;
+            break;
+        case OpCode::IF_ICMPGE:
+            taken = a >= b;
+            break;
+        case OpCode::IF_ICMPGT:
+            taken = a > b;
+            break;
+        case OpCode::IF_ICMPLE:
+            taken = a <= b;
+            break;
+        case OpCode::IF_ICMPEQ:
+            taken = a == b;
+            break;
+        case OpCode::IF_ICMPNE:
+            taken = a != b;
+            break;
+        default:
+            return false;
+    }
+    if (taken) replacement.push_back(std::make_unique<BCInstruction>(OpCode::GOTO, jump.getArgument()));
+    return true;
+}
+
+// A conditional jump to the next block followed by a jump elsewhere becomes the inverted jump, falling through
+bool invertBranch(const PeepholeContext &context, size_t position, Instructions &replacement) {
+    const BCInstruction &branch = *context.code[position];
+    if (position + 2 != context.code.size() || !context.nextBlock || branch.getArgument() != *context.nextBlock) {
+        return false;
+    }
+    replacement.push_back(
+        std::make_unique<BCInstruction>(invertJump(branch.getOpcode()), context.code[position + 1]->getArgument()));
+    return true;
+}
+
+// A temporary stored and immediately loaded again can stay on the stack if nothing reads it later
+bool removeTemporary(const PeepholeContext &context, size_t position, Instructions &) {
+    Symbol name = context.code[position]->getArgument();
+    if (!isTemporary(name) || context.code[position + 1]->getArgument() != name) return false;
+
+    for (size_t i = position + 2; i < context.code.size(); i++) {
+        const BCInstruction &instruction = *context.code[i];
+        if (instruction.getArgument() != name) continue;
+        if (instruction.getOpcode() == OpCode::ILOAD) return false;
+        if (instruction.getOpcode() == OpCode::ISTORE) return true;
+    }
+    return !context.liveOut.count(name);
+}
+
+bool removeJumpToNext(const PeepholeContext &context, size_t position, Instructions &) {
+    return position + 1 == context.code.size() && context.nextBlock &&
+           context.code[position]->getArgument() == *context.nextBlock;
+}
+
+// Nothing after an unconditional jump, return or stop in the same block can be reached
+bool removeUnreachable(const PeepholeContext &context, size_t position, Instructions &replacement) {
+    replacement.push_back(std::make_unique<BCInstruction>(*context.code[position]));
+    return true;
+}
+
+const std::vector<PeepholeRule> &getRules() {
+    static const std::vector<PeepholeRule> rules = {
+        {"fold constant add", {CONSTANT, CONSTANT, op(OpCode::IADD)}, foldBinary},
+        {"fold constant sub", {CONSTANT, CONSTANT, op(OpCode::ISUB)}, foldBinary},
+        {"fold constant mul", {CONSTANT, CONSTANT, op(OpCode::IMUL)}, foldBinary},
+        {"fold constant lt", {CONSTANT, CONSTANT, op(OpCode::ILT)}, foldBinary},
+        {"fold constant gt", {CONSTANT, CONSTANT, op(OpCode::IGT)}, foldBinary},
+        {"fold constant eq", {CONSTANT, CONSTANT, op(OpCode::IEQ)}, foldBinary},
+        {"fold constant and", {CONSTANT, CONSTANT, op(OpCode::IAND)}, foldBinary},
+        {"fold constant or", {CONSTANT, CONSTANT, op(OpCode::IOR)}, foldBinary},
+        {"fold constant not", {CONSTANT, op(OpCode::INOT)}, foldNot},
+        {"fold constant branch", {CONSTANT, op(OpCode::IFFALSEGOTO)}, foldBranch},
+        {"fold constant branch", {CONSTANT, op(OpCode::IFNE)}, foldBranch},
+        {"fold constant branch", {CONSTANT, CONSTANT, op(OpCode::IF_ICMPLT)}, foldCompareBranch},
+        {"fold constant branch", {CONSTANT, CONSTANT, op(OpCode::IF_ICMPGE)}, foldCompareBranch},
+        {"fold constant branch", {CONSTANT, CONSTANT, op(OpCode::IF_ICMPGT)}, foldCompareBranch},
+        {"fold constant branch", {CONSTANT, CONSTANT, op(OpCode::IF_ICMPLE)}, foldCompareBranch},
+        {"fold constant branch", {CONSTANT, CONSTANT, op(OpCode::IF_ICMPEQ)}, foldCompareBranch},
+        {"fold constant branch", {CONSTANT, CONSTANT, op(OpCode::IF_ICMPNE)}, foldCompareBranch},
+        {"remove dead temporary", {op(OpCode::ISTORE), op(OpCode::ILOAD)}, removeTemporary},
+        {"remove jump to next block", {op(OpCode::GOTO)}, removeJumpToNext},
+        {"invert branch over jump", {op(OpCode::IFFALSEGOTO), op(OpCode::GOTO)}, invertBranch},
+        {"invert branch over jump", {op(OpCode::IFNE), op(OpCode::GOTO)}, invertBranch},
+        {"invert branch over jump", {op(OpCode::IF_ICMPLT), op(OpCode::GOTO)}, invertBranch},
+        {"invert branch over jump", {op(OpCode::IF_ICMPGE), op(OpCode::GOTO)}, invertBranch},
+        {"invert branch over jump", {op(OpCode::IF_ICMPGT), op(OpCode::GOTO)}, invertBranch},
+        {"invert branch over jump", {op(OpCode::IF_ICMPLE), op(OpCode::GOTO)}, invertBranch},
+        {"invert branch over jump", {op(OpCode::IF_ICMPEQ), op(OpCode::GOTO)}, invertBranch},
+        {"invert branch over jump", {op(OpCode::IF_ICMPNE), op(OpCode::GOTO)}, invertBranch},
+        {"remove unreachable code", {op(OpCode::GOTO), ANY}, removeUnreachable},
+        {"remove unreachable code", {op(OpCode::IRETURN), ANY}, removeUnreachable},
+        {"remove unreachable code", {op(OpCode::STOP), ANY}, removeUnreachable},
+    };
+    return rules;
+}
+
+bool matches(const PeepholeRule &rule, const Instructions &code, size_t position) {
+    if (position + rule.pattern.size() > code.size()) return false;
+    for (size_t i = 0; i < rule.pattern.size(); i++) {
+        const PatternElement &element = rule.pattern[i];
+        const BCInstruction &instruction = *code[position + i];
+        int32_t value;
+        bool isBoolean;
+        if (element.kind == PatternElement::OPCODE && instruction.getOpcode() != element.opcode) return false;
+        if (element.kind == PatternElement::CONSTANT && !getConstant(instruction, value, isBoolean)) return false;
+    }
+    return true;
+}
+
+bool isTerminator(OpCode opcode) {
+    return opcode == OpCode::GOTO || opcode == OpCode::IRETURN || opcode == OpCode::STOP;
+}
+
+// Computes the temporaries live at the exit of every block, following jumps and fall-through between blocks
+std::vector<std::set<std::string>> getLiveOut(const std::vector<std::unique_ptr<BCBlock>> &blocks) {
+    std::unordered_map<std::string, size_t> blockIndices;
+    for (size_t i = 0; i < blocks.size(); i++) blockIndices[blocks[i]->getName()] = i;
+
+    std::vector<std::set<std::string>> uses(blocks.size()), defs(blocks.size());
+    std::vector<std::vector<size_t>> successors(blocks.size());
+    for (size_t i = 0; i < blocks.size(); i++) {
+        const Instructions &code = blocks[i]->getInstructions();
+        for (const auto &instruction : code) {
+            Symbol argument = instruction->getArgument();
+            OpCode opcode = instruction->getOpcode();
+            if (opcode == OpCode::ILOAD && isTemporary(argument) && !defs[i].count(argument)) {
+                uses[i].insert(argument);
+            } else if (opcode == OpCode::ISTORE && isTemporary(argument)) {
+                defs[i].insert(argument);
+            } else if (isJump(opcode)) {
+                auto it = blockIndices.find(argument);
+                if (it != blockIndices.end()) successors[i].push_back(it->second);
+            }
+        }
+        if ((code.empty() || !isTerminator(code.back()->getOpcode())) && i + 1 < blocks.size()) {
+            successors[i].push_back(i + 1);
+        }
+    }
+
+    std::vector<std::set<std::string>> liveIn(blocks.size()), liveOut(blocks.size());
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = blocks.size(); i-- > 0;) {
+            std::set<std::string> out;
+            for (size_t successor : successors[i]) out.insert(liveIn[successor].begin(), liveIn[successor].end());
+            std::set<std::string> in = uses[i];
+            for (const auto &name : out) {
+                if (!defs[i].count(name)) in.insert(name);
+            }
+            if (in != liveIn[i] || out != liveOut[i]) {
+                liveIn[i] = std::move(in);
+                liveOut[i] = std::move(out);
+                changed = true;
+            }
+        }
+    }
+    return liveOut;
+}
+
+size_t countInstructions(const std::vector<std::unique_ptr<BCBlock>> &blocks) {
+    size_t count = 0;
+    for (const auto &block : blocks) count += block->getInstructions().size();
+    return count;
+}
+
+}  // namespace
+
+PeepholeStats PeepholeOptimizer::optimize(BCProgram &program) const {
+    auto &blocks = program.getBlocks();
+    PeepholeStats stats;
+    stats.instructionsBefore = countInstructions(blocks);
+
+    // Liveness only shrinks as rules fire, so it is recomputed once per round rather than after every rewrite
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::vector<std::set<std::string>> liveOut = getLiveOut(blocks);
+
+        for (size_t i = 0; i < blocks.size(); i++) {
+            Instructions &code = blocks[i]->getInstructions();
+            const std::string *nextBlock = i + 1 < blocks.size() ? &blocks[i + 1]->getName() : nullptr;
+            PeepholeContext context = {code, nextBlock, liveOut[i]};
+
+            size_t position = 0;
+            while (position < code.size()) {
+                bool rewritten = false;
+                for (const auto &rule : getRules()) {
+                    Instructions replacement;
+                    if (!matches(rule, code, position) || !rule.rewrite(context, position, replacement)) continue;
+
+                    code.erase(code.begin() + position, code.begin() + position + rule.pattern.size());
+                    code.insert(code.begin() + position, std::make_move_iterator(replacement.begin()),
+                                std::make_move_iterator(replacement.end()));
+                    stats.rewrites[rule.name]++;
+                    rewritten = changed = true;
+                    break;
+                }
+
+                // Step back so that windows ending in the rewritten code are matched again
+                if (rewritten) {
+                    position = position >= 2 ? position - 2 : 0;
+                } else {
+                    position++;
+                }
+            }
+        }
+    }
+
+    stats.instructionsAfter = countInstructions(blocks);
+    return stats;
+}
@@ -0,0 +1,34 @@
+#ifndef PEEPHOLEOPTIMIZER_H
+#define PEEPHOLEOPTIMIZER_H
+
+#include <map>
+#include <string>
+
+#include "BytecodeGenerator.h"
+
+// Effect of the peephole optimizer on a program
+struct PeepholeStats {
+    size_t instructionsBefore = 0;
+    size_t instructionsAfter = 0;
+    std::map<std::string, int> rewrites;  // Number of times each rule fired, by rule name
+};
+
+/*
+ * Table-driven peephole optimizer over the bytecode of a BCProgram.
+ *
+ * Each rule matches a short window of instructions by opcode and rewrites it when its guard holds. Rules are
+ * applied to every block until none fires any more, since one rewrite often exposes another, for example a
+ * folded comparison feeding a conditional jump. Temporaries are only removed when a liveness analysis over
+ * the jumps between blocks shows that they are not read again.
+ */
+class PeepholeOptimizer {
+   public:
+    /**
+     * @brief Optimizes every block of a program in place.
+     * @param program The program to optimize.
+     * @return The size of the program before and after, and how often each rule fired.
+     */
+    PeepholeStats optimize(BCProgram &program) const;
+};
+
+#endif  // PEEPHOLEOPTIMIZER_H
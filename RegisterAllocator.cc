@@ -0,0 +1,132 @@
+#include "RegisterAllocator.h"
+
+#include <algorithm>
+
+const int LinearScanAllocator::SPILLED;
+
+LivenessAnalysis::LivenessAnalysis(const std::vector<const BasicBlock *> &blocks,
+                                   const std::function<bool(const std::string &)> &isCandidate) {
+    // Local use and def sets: a use only counts if the block has not written the variable before
+    std::map<const BasicBlock *, std::set<std::string>> uses;
+    std::map<const BasicBlock *, std::set<std::string>> defs;
+    for (const auto &block : blocks) {
+        auto &blockUses = uses[block];
+        auto &blockDefs = defs[block];
+        for (const auto &tacInst : block->getTacInstructions()) {
+            std::vector<std::string> instUses, instDefs;
+            getUsesAndDefs(tacInst, instUses, instDefs);
+            for (const auto &name : instUses) {
+                if (isCandidate(name) && !blockDefs.count(name)) blockUses.insert(name);
+            }
+            for (const auto &name : instDefs) {
+                if (isCandidate(name)) blockDefs.insert(name);
+            }
+        }
+        liveIn[block];
+        liveOut[block];
+    }
+
+    // Iterate to a fixed point, visiting blocks backwards since liveness flows against control flow
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+            const BasicBlock *block = *it;
+            std::set<std::string> out;
+            for (const BasicBlock *successor : {block->trueExit, block->falseExit}) {
+                if (successor && liveIn.count(successor)) {
+                    out.insert(liveIn[successor].begin(), liveIn[successor].end());
+                }
+            }
+            std::set<std::string> in = uses[block];
+            for (const auto &name : out) {
+                if (!defs[block].count(name)) in.insert(name);
+            }
+            if (in != liveIn[block] || out != liveOut[block]) {
+                liveIn[block] = std::move(in);
+                liveOut[block] = std::move(out);
+                changed = true;
+            }
+        }
+    }
+
+    // Number the instructions in layout order and stretch intervals over every live position
+    int position = 0;
+    for (const auto &block : blocks) {
+        int blockStart = position;
+        for (const auto &name : liveIn[block]) extend(name, blockStart);
+        for (const auto &tacInst : block->getTacInstructions()) {
+            std::vector<std::string> instUses, instDefs;
+            getUsesAndDefs(tacInst, instUses, instDefs);
+            for (const auto &name : instUses) {
+                if (isCandidate(name)) extend(name, position);
+            }
+            for (const auto &name : instDefs) {
+                if (isCandidate(name)) extend(name, position);
+            }
+            position++;
+        }
+        // The block exit is a position of its own, where live-out values must still be intact
+        for (const auto &name : liveOut[block]) extend(name, position);
+        position++;
+    }
+}
+
+void LivenessAnalysis::extend(const std::string &name, int position) {
+    auto it = intervals.find(name);
+    if (it == intervals.end()) {
+        intervals.emplace(name, LiveInterval{name, position, position});
+    } else {
+        it->second.start = std::min(it->second.start, position);
+        it->second.end = std::max(it->second.end, position);
+    }
+}
+
+std::vector<LiveInterval> LivenessAnalysis::getIntervals() const {
+    std::vector<LiveInterval> result;
+    for (const auto &entry : intervals) result.push_back(entry.second);
+    std::sort(result.begin(), result.end(), [](const LiveInterval &a, const LiveInterval &b) {
+        return a.start != b.start ? a.start < b.start : a.name < b.name;
+    });
+    return result;
+}
+
+std::unordered_map<std::string, int> LinearScanAllocator::allocate(std::vector<LiveInterval> intervals) const {
+    std::sort(intervals.begin(), intervals.end(), [](const LiveInterval &a, const LiveInterval &b) {
+        return a.start != b.start ? a.start < b.start : a.name < b.name;
+    });
+
+    std::unordered_map<std::string, int> assignment;
+    std::vector<int> freeRegisters;
+    for (int reg = registerCount - 1; reg >= 0; reg--) freeRegisters.push_back(reg);
+    std::vector<LiveInterval> active;  // Sorted by end position
+
+    for (const auto &interval : intervals) {
+        // Release the registers of intervals that ended before this one starts
+        while (!active.empty() && active.front().end < interval.start) {
+            freeRegisters.push_back(assignment[active.front().name]);
+            active.erase(active.begin());
+        }
+
+        if (freeRegisters.empty()) {
+            // Spill whichever of the current and the active intervals lives longest
+            if (!active.empty() && active.back().end > interval.end) {
+                LiveInterval spilled = active.back();
+                active.pop_back();
+                assignment[interval.name] = assignment[spilled.name];
+                assignment[spilled.name] = SPILLED;
+            } else {
+                assignment[interval.name] = SPILLED;
+                continue;
+            }
+        } else {
+            assignment[interval.name] = freeRegisters.back();
+            freeRegisters.pop_back();
+        }
+
+        auto position = std::upper_bound(active.begin(), active.end(), interval,
+                                         [](const LiveInterval &a, const LiveInterval &b) { return a.end < b.end; });
+        active.insert(position, interval);
+    }
+    return assignment;
+}
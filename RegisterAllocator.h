@@ -0,0 +1,125 @@
+#ifndef REGISTERALLOCATOR_H
+#define REGISTERALLOCATOR_H
+
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IntermediateRepresentation.h"
+
+// Range of instruction positions over which a variable may hold a live value.
+struct LiveInterval {
+    std::string name;
+    int start;
+    int end;
+};
+
+/*
+ * Liveness analysis over the TAC of one method.
+ *
+ * Computes live-in and live-out sets per block with the usual backward dataflow equations, and live
+ * intervals over the instructions numbered in block order. Intervals cover every position from the
+ * first to the last point a variable is live, so holes between uses are not exploited.
+ */
+class LivenessAnalysis {
+   public:
+    /**
+     * @brief Analyzes the blocks of a method.
+     * @param blocks The blocks of the method, in the order they are laid out.
+     * @param isCandidate Decides which names are tracked, for example to exclude fields and parameters.
+     */
+    LivenessAnalysis(const std::vector<const BasicBlock *> &blocks,
+                     const std::function<bool(const std::string &)> &isCandidate);
+
+    /**
+     * @brief Gets the variables live at the start of a block.
+     * @param block A block of the method.
+     * @return The live variables.
+     */
+    const std::set<std::string> &getLiveIn(const BasicBlock *block) const { return liveIn.at(block); }
+
+    /**
+     * @brief Gets the variables live at the end of a block.
+     * @param block A block of the method.
+     * @return The live variables.
+     */
+    const std::set<std::string> &getLiveOut(const BasicBlock *block) const { return liveOut.at(block); }
+
+    /**
+     * @brief Gets the live interval of every tracked variable, ordered by start position.
+     * @return The intervals.
+     */
+    std::vector<LiveInterval> getIntervals() const;
+
+    /**
+     * @brief Gets the variables a TAC instruction reads and writes.
+     * @param tacInst The instruction.
+     * @param uses Receives the names read by the instruction, including literals.
+     * @param defs Receives the names written by the instruction.
+     */
+    template <typename Tac>
+    static void getUsesAndDefs(const Tac &tacInst, std::vector<std::string> &uses, std::vector<std::string> &defs);
+
+   private:
+    std::map<const BasicBlock *, std::set<std::string>> liveIn;
+    std::map<const BasicBlock *, std::set<std::string>> liveOut;
+    std::map<std::string, LiveInterval> intervals;
+
+    void extend(const std::string &name, int position);
+};
+
+/*
+ * Linear-scan register allocation (Poletto and Sarkar).
+ *
+ * Intervals are visited by start position. Registers are freed when the intervals holding them end, and
+ * when none is free the interval that ends last is spilled. The allocator only deals in register indices,
+ * so any backend with a fixed register file can map them to its own registers.
+ */
+class LinearScanAllocator {
+   public:
+    static const int SPILLED = -1;
+
+    explicit LinearScanAllocator(int registerCount) : registerCount(registerCount) {}
+
+    /**
+     * @brief Assigns registers to live intervals.
+     * @param intervals The intervals, in any order.
+     * @return The register index of every variable, or SPILLED.
+     */
+    std::unordered_map<std::string, int> allocate(std::vector<LiveInterval> intervals) const;
+
+   private:
+    int registerCount;
+};
+
+template <typename Tac>
+void LivenessAnalysis::getUsesAndDefs(const Tac &tacInst, std::vector<std::string> &uses,
+                                      std::vector<std::string> &defs) {
+    Symbol op = tacInst.op;
+    if (op == tac::PARAM || op == tac::PRINT || op == tac::IF || op == tac::RETURN) {
+        uses.push_back(tacInst.arg1);
+    } else if (op == tac::STORE_INDEX || op == tac::STORE_INDEX_UNCHECKED) {
+        uses.push_back(tacInst.result);
+        uses.push_back(tacInst.arg1);
+        uses.push_back(tacInst.arg2);
+    } else if (op == tac::STORE_FIELD) {
+        // Field store: the object and the value, the field is named by arg1
+        uses.push_back(tacInst.result);
+        uses.push_back(tacInst.arg2);
+    } else if (op == tac::LOAD_FIELD) {
+        uses.push_back(tacInst.arg1);
+        defs.push_back(tacInst.result);
+    } else if (op == tac::NEW || op == tac::CALL) {
+        // Arguments of a call are read by its param instructions
+        if (!tacInst.result.empty()) defs.push_back(tacInst.result);
+    } else {
+        uses.push_back(tacInst.arg1);
+        if (!tacInst.arg2.empty()) uses.push_back(tacInst.arg2);
+        defs.push_back(tacInst.result);
+    }
+}
+
+#endif  // REGISTERALLOCATOR_H
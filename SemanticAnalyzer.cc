@@ -1,18 +1,23 @@
 #include "SemanticAnalyzer.h"
 
+#include <exception>
+#include <sstream>
+
+#include "ThreadPool.h"
+
 // Main analysis functions
 
 void SemanticAnalyzer::analyze(Node *root) {
     if (!root) throw std::runtime_error("Root node is null.");
-    std::vector<std::string> classNames;
+    std::unordered_map<std::string, int> classNames;  // Number of classes declared with each name so far
 
     // Check main class
-    Node *mainClassNode = findChild(root, "MainClass");
+    Node *mainClassNode = findChild(root, NodeKind::MainClass);
     if (mainClassNode) {
-        classNames.push_back(mainClassNode->value);
-        Node *statementList = findChild(mainClassNode, "StatementList");
+        classNames[mainClassNode->value]++;
+        Node *statementList = findChild(mainClassNode, NodeKind::StatementList);
         if (!statementList) throw std::runtime_error("No statement list found in main class.");
-        Class mainClass = symbolTable.getClass(mainClassNode->value);
+        const Class &mainClass = symbolTable.getClass(mainClassNode->value);
         for (auto child : statementList->children) {
             checkStatement(child, Method("main", "void"), mainClass);
         }
@@ -21,25 +26,60 @@ void SemanticAnalyzer::analyze(Node *root) {
     }
 
     // Check class declarations
-    Node *classDeclList = findChild(root, "ClassDeclarationList");
-    if (classDeclList) {
-        for (auto child : classDeclList->children) {
-            if (child->type == "ClassDeclaration") {
-                // Check for duplicate class names
-                if (std::find(classNames.begin(), classNames.end(), child->value) != classNames.end()) {
-                    reportError("Class " + child->value + " is declared multiple times.", child->lineno, PURPLE);
-                }
-                classNames.push_back(child->value);
+    Node *classDeclList = findChild(root, NodeKind::ClassDeclarationList);
+    if (!classDeclList) throw std::runtime_error("No class declaration list found in the AST.");
+
+    // Classes with the same name are told apart by their order, so they are numbered before any is checked
+    std::vector<Node *> classes;
+    std::vector<int> occurences;
+    for (auto child : classDeclList->children) {
+        if (child->kind == NodeKind::ClassDeclaration) {
+            classes.push_back(child);
+            occurences.push_back(++classNames[child->value]);
+        }
+    }
 
-                checkClass(child, classNames);
+    // Checking a class only reads the tree and the symbol table, so every class gets a task of its own
+    struct ClassReport {
+        std::ostringstream diagnostics;
+        int errors = 0;
+        std::exception_ptr failure;
+    };
+    std::vector<ClassReport> reports(classes.size());
+    auto check = [&](size_t i) {
+        SemanticAnalyzer worker(symbolTable);
+        worker.diagnostics = &reports[i].diagnostics;
+        try {
+            // Check for duplicate class names
+            if (occurences[i] > 1) {
+                worker.reportError("Class " + classes[i]->value + " is declared multiple times.", classes[i]->lineno,
+                                   PURPLE);
             }
+            worker.checkClass(classes[i], occurences[i]);
+        } catch (...) {
+            reports[i].failure = std::current_exception();
         }
+        reports[i].errors = worker.semanticErrors;
+    };
+
+    // No more threads than classes, and none at all when a single thread would do the work
+    size_t threads = std::min<size_t>(jobs, classes.size());
+    if (threads <= 1) {
+        for (size_t i = 0; i < classes.size(); i++) check(i);
     } else {
-        throw std::runtime_error("No class declaration list found in the AST.");
+        ThreadPool pool(threads);
+        pool.run(classes.size(), check);
+    }
+
+    // Reported as if the classes had been checked one after another, which stops at the first class that fails
+    for (auto &report : reports) {
+        std::cerr << report.diagnostics.str();
+        semanticErrors += report.errors;
+        if (report.failure) std::rethrow_exception(report.failure);
     }
 }
 
-void SemanticAnalyzer::checkClass(Node *node, std::vector<std::string> &clsNames) {
+void SemanticAnalyzer::checkClass(Node *node, int occurence) {
     std::string className = node->value;
 
     if (!symbolTable.hasClass(className)) {
@@ -48,8 +88,8 @@ void SemanticAnalyzer::checkClass(Node *node, std::vector<std::string> &clsNames
     }
 
     // Check that class variables are of existing types
-    Node *varDeclList = findChild(node, "VarDeclarationList");
-    std::vector<std::string> classVars;
+    Node *varDeclList = findChild(node, NodeKind::VarDeclarationList);
+    std::unordered_set<std::string> classVars;
     if (varDeclList) {
         for (auto varNode : varDeclList->children) {
             auto it = varNode->children.begin();
@@ -64,30 +104,26 @@ void SemanticAnalyzer::checkClass(Node *node, std::vector<std::string> &clsNames
             }
 
             // Check for duplicate variable names
-            if (std::find(classVars.begin(), classVars.end(), varName) != classVars.end()) {
+            if (!classVars.insert(varName).second) {
                 reportError("Class variable " + varName + " is declared multiple times in class " + className,
                             varLineno, PURPLE);
             }
-            classVars.push_back(varName);
         }
     }
 
-    int occurence = std::count(clsNames.begin(), clsNames.end(), className);
-    if (occurence == 0) reportError("Class " + className + " is not declared.", node->lineno, RESET);
-    Class cls = symbolTable.getOccurenceOfClass(className, occurence);
+    const Class &cls = symbolTable.getOccurenceOfClass(className, occurence);
 
-    Node *methodDeclList = findChild(node, "MethodDeclarationList");
+    Node *methodDeclList = findChild(node, NodeKind::MethodDeclarationList);
 
     if (!methodDeclList) throw std::runtime_error("No method declaration list found in class " + className);
-    std::vector<std::string> methodNames;
+    std::unordered_set<std::string> methodNames;
 
     for (auto child : methodDeclList->children) {
-        if (child->type == "MethodDeclaration") {
-            if (std::find(methodNames.begin(), methodNames.end(), child->value) != methodNames.end()) {
+        if (child->kind == NodeKind::MethodDeclaration) {
+            if (!methodNames.insert(child->value).second) {
                 reportError("Method " + child->value + " is declared multiple times in class " + className,
                             child->lineno, PURPLE);
             }
-            methodNames.push_back(child->value);
 
             checkMethod(child, cls);
         }
@@ -105,46 +141,44 @@ void SemanticAnalyzer::checkMethod(Node *node, const Class &cls) {
     const Method &method = cls.getMethod(methodName);
 
     // Check method parameters for duplicate names
-    std::vector<std::string> paramNames;
+    std::unordered_set<std::string> paramNames;
     for (const auto &param : method.getParameters()) {
-        if (std::find(paramNames.begin(), paramNames.end(), param.getName()) != paramNames.end()) {
+        if (!paramNames.insert(param.getName()).second) {
             reportError("Method parameter " + param.getName() + " is declared multiple times in method " + methodName,
                         node->lineno, PURPLE);
         }
-        paramNames.push_back(param.getName());
     }
 
     // Check local variables for duplicate names
-    std::vector<std::string> localVars;
-    auto localVariables = method.getLocalVariables();
-    for (const auto &localVar : localVariables) {
-        if (std::find(localVars.begin(), localVars.end(), localVar.first.getName()) != localVars.end()) {
+    std::unordered_set<std::string> localVars;
+    for (const auto &localVar : method.getLocalVariables()) {
+        if (!localVars.insert(localVar.first.getName()).second) {
             reportError(
                 "Local variable " + localVar.first.getName() + " is declared multiple times in method " + methodName,
                 localVar.second, PURPLE);
         }
-        if (std::find(paramNames.begin(), paramNames.end(), localVar.first.getName()) != paramNames.end()) {
+        if (paramNames.count(localVar.first.getName())) {
             reportError("Local variable " + localVar.first.getName() + " has the same name as a parameter in method " +
                             methodName,
                         localVar.second, PURPLE);
         }
-        localVars.push_back(localVar.first.getName());
     }
 
     // Check method code
-    Node *code = findChild(node, "Code");
+    Node *code = findChild(node, NodeKind::Code);
     if (!code) throw std::runtime_error("No code block found in method " + methodName);
 
     for (auto child : code->children) {
-        if (endsWith(child->type, "Statement")) {
+        if (isStatement(child->kind)) {
             checkStatement(child, method, cls);
-        } else if (child->type != "Variable") {
-            throw std::runtime_error("Method code must contain statements. Unexpected node type: " + child->type);
+        } else if (child->kind != NodeKind::Variable) {
+            throw std::runtime_error(std::string("Method code must contain statements. Unexpected node type: ") +
+                                     getKindName(child->kind));
         }
     }
 
     // Check return statement
-    Node *returnStatement = findChild(node, "Return");
+    Node *returnStatement = findChild(node, NodeKind::Return);
     if (!returnStatement) throw std::runtime_error("No return statement found in method " + methodName);
 
     Node *returnExpression = returnStatement->children.front();
@@ -159,23 +193,28 @@ void SemanticAnalyzer::checkMethod(Node *node, const Class &cls) {
 }
 
 void SemanticAnalyzer::checkStatement(Node *node, const Method &method, const Class &cls) {
-    std::string statementType = node->type.substr(0, node->type.size() - 9);
-
-    if (statementType == "VarInit") {
-        checkVarInitStatement(node, method, cls);
-    } else if (statementType == "ArrayInit") {
-        checkArrayInitStatement(node, method, cls);
-    } else if (statementType == "If") {
-        checkIfStatement(node, method, cls);
-    } else if (statementType == "IfElse") {
-        checkIfElseStatement(node, method, cls);
-    } else if (statementType == "While") {
-        checkWhileStatement(node, method, cls);
-    } else if (statementType == "Print") {
-        checkPrintStatement(node, method, cls);
-    } else {
-        throw std::runtime_error("Unknown statement type: " + statementType + " on line " +
-                                 std::to_string(node->lineno));
+    switch (node->kind) {
+        case NodeKind::VarInitStatement:
+            checkVarInitStatement(node, method, cls);
+            break;
+        case NodeKind::ArrayInitStatement:
+            checkArrayInitStatement(node, method, cls);
+            break;
+        case NodeKind::IfStatement:
+            checkIfStatement(node, method, cls);
+            break;
+        case NodeKind::IfElseStatement:
+            checkIfElseStatement(node, method, cls);
+            break;
+        case NodeKind::WhileStatement:
+            checkWhileStatement(node, method, cls);
+            break;
+        case NodeKind::PrintStatement:
+            checkPrintStatement(node, method, cls);
+            break;
+        default:
+            throw std::runtime_error("Unknown statement type: " + getKindName(node->kind) + " on line " +
+                                     std::to_string(node->lineno));
     }
 }
 
@@ -234,7 +273,7 @@ void SemanticAnalyzer::checkArrayInitStatement(Node *node, const Method &method,
 }
 
 void SemanticAnalyzer::checkIfStatement(Node *node, const Method &method, const Class &cls) {
-    Node *condition = findChild(node, "Condition");
+    Node *condition = findChild(node, NodeKind::Condition);
     if (!condition) throw std::runtime_error("No condition found in if statement");
 
     if (condition->children.size() != 1) throw std::runtime_error("If condition must have exactly one expression");
@@ -249,7 +288,7 @@ void SemanticAnalyzer::checkIfStatement(Node *node, const Method &method, const
         reportError("Condition must be of type Bool, but got " + conditionType, node->lineno, RED);
     }
 
-    Node *statementList = findChild(node, "StatementList");
+    Node *statementList = findChild(node, NodeKind::StatementList);
     if (!statementList) throw std::runtime_error("No statement list found in if statement");
 
     for (auto child : statementList->children) {
@@ -258,7 +297,7 @@ void SemanticAnalyzer::checkIfStatement(Node *node, const Method &method, const
 }
 
 void SemanticAnalyzer::checkIfElseStatement(Node *node, const Method &method, const Class &cls) {
-    Node *condition = findChild(node, "Condition");
+    Node *condition = findChild(node, NodeKind::Condition);
     if (!condition) throw std::runtime_error("No condition found in if-else statement");
 
     if (condition->children.size() != 1) throw std::runtime_error("If condition must have exactly one expression");
@@ -273,14 +312,14 @@ void SemanticAnalyzer::checkIfElseStatement(Node *node, const Method &method, co
         reportError("Condition must be of type Bool, but got " + conditionType, node->lineno, RED);
     }
 
-    Node *statementList = findChild(node, "StatementList");
+    Node *statementList = findChild(node, NodeKind::StatementList);
     if (!statementList) throw std::runtime_error("No statement list found in if-else statement");
 
     for (auto child : statementList->children) {
         checkStatement(child, method, cls);
     }
 
-    Node *elseStatementList = findChild(node, "StatementList", 2);
+    Node *elseStatementList = findChild(node, NodeKind::StatementList, 2);
     if (!elseStatementList) throw std::runtime_error("No else statement list found in if-else statement");
     for (auto child : elseStatementList->children) {
         checkStatement(child, method, cls);
@@ -311,33 +350,52 @@ void SemanticAnalyzer::checkPrintStatement(Node *node, const Method &method, con
 }
 
 void SemanticAnalyzer::checkExpression(Node *node, const Method &method, const Class &cls) {
-    std::string expressionType = node->type;
-
-    if (isBinaryExpression(expressionType)) {
-        checkBinaryExpression(node, method, cls, expressionType);
-    } else if (isUnaryExpression(expressionType)) {
-        checkUnaryExpression(node, method, cls, expressionType);
-    } else if (expressionType == "MethodCallExpression") {
-        checkMethodCallArguments(node, method, cls);
-        for (auto child : node->children) {
-            checkExpression(child, method, cls);
-        }
-    } else if (expressionType == "NewObjectExpression") {
-        if (node->children.size() != 1) throw std::runtime_error("NewObjectExpression must have exactly one child");
-        std::string className = node->children.front()->value;
-        if (!symbolTable.hasClass(className)) {
-            reportError("Class " + className + " is not declared.", node->lineno, RED);
+    switch (node->kind) {
+        case NodeKind::AndExpression:
+        case NodeKind::OrExpression:
+        case NodeKind::LTExpression:
+        case NodeKind::GTExpression:
+        case NodeKind::EqualExpression:
+        case NodeKind::AddExpression:
+        case NodeKind::SubExpression:
+        case NodeKind::MultExpression:
+        case NodeKind::ArrayExpression:
+            checkBinaryExpression(node, method, cls, node->kind);
+            break;
+        case NodeKind::NotExpression:
+        case NodeKind::LengthExpression:
+        case NodeKind::NewIntArrayExpression:
+            checkUnaryExpression(node, method, cls, node->kind);
+            break;
+        case NodeKind::MethodCallExpression:
+            checkMethodCallArguments(node, method, cls);
+            for (auto child : node->children) {
+                checkExpression(child, method, cls);
+            }
+            break;
+        case NodeKind::NewObjectExpression: {
+            if (node->children.size() != 1) throw std::runtime_error("NewObjectExpression must have exactly one child");
+            std::string className = node->children.front()->value;
+            if (!symbolTable.hasClass(className)) {
+                reportError("Class " + className + " is not declared.", node->lineno, RED);
+            }
+            break;
         }
-    } else if (expressionType != "ArgumentList" && expressionType != "IntLiteral" && expressionType != "BoolLiteral" &&
-               expressionType != "Identifier" && expressionType != "ThisExpression") {
-        throw std::runtime_error("Unknown expression type: " + expressionType);
+        case NodeKind::ArgumentList:
+        case NodeKind::IntLiteral:
+        case NodeKind::BoolLiteral:
+        case NodeKind::Identifier:
+        case NodeKind::ThisExpression:
+            break;
+        default:
+            throw std::runtime_error("Unknown expression type: " + getKindName(node->kind));
     }
 }
 
 // Helper functions
 
 void SemanticAnalyzer::checkBinaryExpression(Node *node, const Method &method, const Class &cls,
-                                             const std::string &expressionType) {
+                                             NodeKind expressionType) {
     if (isArithmeticExpression(expressionType)) {
         checkBinaryExpression(node, method, cls, expressionType, "Int", "Int",
                               "arithmetic operations require integer operands");
@@ -347,10 +405,10 @@ void SemanticAnalyzer::checkBinaryExpression(Node *node, const Method &method, c
     } else if (isComparisonExpression(expressionType)) {
         checkBinaryExpression(node, method, cls, expressionType, "Int", "Int",
                               "comparison operations require integer operands");
-    } else if (expressionType == "ArrayExpression") {
+    } else if (expressionType == NodeKind::ArrayExpression) {
         checkBinaryExpression(node, method, cls, expressionType, "IntArray", "Int",
                               "array access requires an integer index");
-    } else if (expressionType == "EqualExpression") {
+    } else if (expressionType == NodeKind::EqualExpression) {
         auto [leftType, rightType] = getTypes(node, method, cls);
         if (leftType != rightType || !isValidEqualityType(leftType)) {
             reportError("Type mismatch: equality operations require operands of the same type. (" + leftType +
@@ -358,17 +416,17 @@ void SemanticAnalyzer::checkBinaryExpression(Node *node, const Method &method, c
                         node->lineno, RED);
         }
     } else {
-        throw std::runtime_error("Unknown binary expression type: " + expressionType + " on line " +
-                                 std::to_string(node->lineno));
+        throw std::runtime_error("Unknown binary expression type: " + getKindName(expressionType) +
+                                 " on line " + std::to_string(node->lineno));
     }
 }
 
 void SemanticAnalyzer::checkBinaryExpression(Node *node, const Method &method, const Class &cls,
-                                             const std::string &expressionType, const std::string &expectedLeftType,
+                                             NodeKind expressionType, const std::string &expectedLeftType,
                                              const std::string &expectedRightType, const std::string &errorMessage) {
     auto [leftType, rightType] = getTypes(node, method, cls);
     if (leftType != expectedLeftType || rightType != expectedRightType) {
-        std::string suffix = expressionType == "ArrayExpression" ? "]" : "";
+        std::string suffix = expressionType == NodeKind::ArrayExpression ? "]" : "";
         reportError("Type mismatch: " + errorMessage + ". (" + leftType + getOperator(expressionType) + rightType +
                         suffix + ")",
                     node->lineno, getColor(expressionType));
@@ -376,16 +434,20 @@ void SemanticAnalyzer::checkBinaryExpression(Node *node, const Method &method, c
 }
 
 void SemanticAnalyzer::checkUnaryExpression(Node *node, const Method &method, const Class &cls,
-                                            const std::string &expressionType) {
-    if (expressionType == "NotExpression") {
-        checkUnaryExpression(node, method, cls, "Bool", "logical negation requires a boolean operand");
-    } else if (expressionType == "LengthExpression") {
-        checkUnaryExpression(node, method, cls, "IntArray", "length operation requires an integer array operand");
-    } else if (expressionType == "NewIntArrayExpression") {
-        checkUnaryExpression(node, method, cls, "Int", "new int array requires an integer size");
-    } else {
-        throw std::runtime_error("Unknown unary expression type: " + expressionType + " on line " +
-                                 std::to_string(node->lineno));
+                                            NodeKind expressionType) {
+    switch (expressionType) {
+        case NodeKind::NotExpression:
+            checkUnaryExpression(node, method, cls, "Bool", "logical negation requires a boolean operand");
+            break;
+        case NodeKind::LengthExpression:
+            checkUnaryExpression(node, method, cls, "IntArray", "length operation requires an integer array operand");
+            break;
+        case NodeKind::NewIntArrayExpression:
+            checkUnaryExpression(node, method, cls, "Int", "new int array requires an integer size");
+            break;
+        default:
+            throw std::runtime_error("Unknown unary expression type: " + getKindName(expressionType) +
+                                     " on line " + std::to_string(node->lineno));
     }
 }
 
@@ -420,7 +482,7 @@ void SemanticAnalyzer::checkMethodCallArguments(Node *node, const Method &method
 
     const Method &calledMethod = objectClass.getMethod(methodName);
 
-    Node *argumentsNode = findChild(node, "ArgumentList");
+    Node *argumentsNode = findChild(node, NodeKind::ArgumentList);
     const auto &parameters = calledMethod.getParameters();
 
     if (!argumentsNode) {
@@ -464,39 +526,47 @@ std::pair<std::string, std::string> SemanticAnalyzer::getTypes(Node *node, const
 }
 
 std::string SemanticAnalyzer::inferType(Node *expression, const Method &method, const Class &cls) {
-    const std::string &type = expression->type;
-
-    static const std::unordered_map<std::string, std::string> typeMap = {
-        {"IntLiteral", "Int"},       {"AddExpression", "Int"},   {"SubExpression", "Int"},
-        {"MultExpression", "Int"},   {"ArrayExpression", "Int"}, {"LengthExpression", "Int"},
-        {"BoolLiteral", "Bool"},     {"AndExpression", "Bool"},  {"OrExpression", "Bool"},
-        {"EqualExpression", "Bool"}, {"LTExpression", "Bool"},   {"GTExpression", "Bool"},
-        {"NotExpression", "Bool"},   {"IntArray", "IntArray"},   {"NewIntArrayExpression", "IntArray"}};
-
-    auto it = typeMap.find(type);
-    if (it != typeMap.end()) {
-        return it->second;
-    } else if (type == "Identifier") {
-        return inferIdentifierType(expression, method, cls);
-    } else if (type == "MethodCallExpression") {
-        Node *objectNode = expression->children.front();
-        std::string objectType = inferType(objectNode, method, cls);
-        if (objectType == "Int" || objectType == "Bool" || objectType == "IntArray") {
-            reportError("Cannot call method on primitive type: " + objectType, expression->lineno, RED);
-            return "";
-        }
+    switch (expression->kind) {
+        case NodeKind::IntLiteral:
+        case NodeKind::AddExpression:
+        case NodeKind::SubExpression:
+        case NodeKind::MultExpression:
+        case NodeKind::ArrayExpression:
+        case NodeKind::LengthExpression:
+            return "Int";
+        case NodeKind::BoolLiteral:
+        case NodeKind::AndExpression:
+        case NodeKind::OrExpression:
+        case NodeKind::EqualExpression:
+        case NodeKind::LTExpression:
+        case NodeKind::GTExpression:
+        case NodeKind::NotExpression:
+            return "Bool";
+        case NodeKind::NewIntArrayExpression:
+            return "IntArray";
+        case NodeKind::Identifier:
+            return inferIdentifierType(expression, method, cls);
+        case NodeKind::MethodCallExpression: {
+            Node *objectNode = expression->children.front();
+            std::string objectType = inferType(objectNode, method, cls);
+            if (objectType == "Int" || objectType == "Bool" || objectType == "IntArray") {
+                reportError("Cannot call method on primitive type: " + objectType, expression->lineno, RED);
+                return "";
+            }
 
-        if (!symbolTable.hasClass(objectType)) return "";
-        const Class &objectClass = symbolTable.getClass(objectType);
+            if (!symbolTable.hasClass(objectType)) return "";
+            const Class &objectClass = symbolTable.getClass(objectType);
 
-        const Method &calledMethod = objectClass.getMethod(expression->value);
-        return calledMethod.getReturnType();
-    } else if (type == "NewObjectExpression") {
-        return expression->children.front()->value;
-    } else if (type == "ThisExpression") {
-        return cls.getName();
-    } else {
-        throw std::runtime_error("Can't infer type of: " + type);
+            // Calls to undeclared methods are reported by checkMethodCallArguments
+            const Method *calledMethod = objectClass.findMethod(expression->value);
+            return calledMethod ? calledMethod->getReturnType() : "";
+        }
+        case NodeKind::NewObjectExpression:
+            return expression->children.front()->value;
+        case NodeKind::ThisExpression:
+            return cls.getName();
+        default:
+            throw std::runtime_error("Can't infer type of: " + getKindName(expression->kind));
     }
 }
 
@@ -513,6 +583,6 @@ std::string SemanticAnalyzer::inferIdentifierType(Node *expression, const Method
 }
 
 void SemanticAnalyzer::reportError(const std::string &message, int lineno, const std::string &color) {
-    std::cerr << color << "\@error at line " << lineno << ": " << message << RESET << std::endl;
+    *diagnostics << color << "\@error at line " << lineno << ": " << message << RESET << std::endl;
     semanticErrors++;
 }
\ No newline at end of file
@@ -3,9 +3,11 @@
 
 #include <algorithm>
 #include <iostream>
+#include <ostream>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "HelperFunctions.h"
@@ -14,10 +16,20 @@
 
 class SemanticAnalyzer {
    public:
-    SemanticAnalyzer(SymbolTable &symbolTable) : symbolTable(symbolTable), semanticErrors(0) {}
+    /**
+     * @brief Constructs a SemanticAnalyzer for a program.
+     * @param symbolTable The symbol table of the program.
+     * @param jobs The number of threads to check classes on.
+     */
+    SemanticAnalyzer(SymbolTable &symbolTable, unsigned jobs = 1)
+        : symbolTable(symbolTable), semanticErrors(0), jobs(jobs), diagnostics(&std::cerr) {}
 
     /**
      * @brief Starts the semantic analysis by traversing the AST from the root node.
+     *
+     * The classes are checked concurrently when there are several jobs. The errors of each class are held back
+     * and reported in source order, so the output does not depend on the number of jobs.
+     *
      * @param root The root node of the AST.
      */
     void analyze(Node *root);
@@ -31,15 +43,17 @@ class SemanticAnalyzer {
    private:
     SymbolTable &symbolTable;
     int semanticErrors;
+    unsigned jobs;
+    std::ostream *diagnostics;  // Where errors are reported
 
     // Main analysis functions
 
     /**
      * @brief Checks a class node for semantic correctness.
      * @param node The class node to check.
-     * @param clsNames The names of the classes to check against to verify no duplicate identifiers.
+     * @param occurence Which of the classes declared with its name the class is, counting from 1.
      */
-    void checkClass(Node *node, std::vector<std::string> &clsNames);
+    void checkClass(Node *node, int occurence);
 
     /**
      * @brief Checks a method node for semantic correctness within a given class.
@@ -122,21 +136,21 @@ class SemanticAnalyzer {
      * @param node The binary expression node to check.
      * @param method The method containing the expression.
      * @param cls The class containing the method.
-     * @param expressionType The type of the binary expression.
+     * @param expressionType The kind of the binary expression.
      */
-    void checkBinaryExpression(Node *node, const Method &method, const Class &cls, const std::string &expressionType);
+    void checkBinaryExpression(Node *node, const Method &method, const Class &cls, NodeKind expressionType);
 
     /**
      * @brief Checks a binary expression node for semantic correctness with expected types.
      * @param node The binary expression node to check.
      * @param method The method containing the expression.
      * @param cls The class containing the method.
-     * @param expressionType The type of the binary expression.
+     * @param expressionType The kind of the binary expression.
      * @param expectedLeftType The expected type of the left operand.
      * @param expectedRightType The expected type of the right operand.
      * @param errorMessage The error message to report if the types do not match.
      */
-    void checkBinaryExpression(Node *node, const Method &method, const Class &cls, const std::string &expressionType,
+    void checkBinaryExpression(Node *node, const Method &method, const Class &cls, NodeKind expressionType,
                                const std::string &expectedLeftType, const std::string &expectedRightType,
                                const std::string &errorMessage);
 
@@ -145,9 +159,9 @@ class SemanticAnalyzer {
      * @param node The unary expression node to check.
      * @param method The method containing the expression.
      * @param cls The class containing the method.
-     * @param expressionType The type of the unary expression.
+     * @param expressionType The kind of the unary expression.
      */
-    void checkUnaryExpression(Node *node, const Method &method, const Class &cls, const std::string &expressionType);
+    void checkUnaryExpression(Node *node, const Method &method, const Class &cls, NodeKind expressionType);
 
     /**
      * @brief Checks a unary expression node for semantic correctness with expected type.
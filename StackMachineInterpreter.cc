@@ -1,16 +1,48 @@
 #include "StackMachineInterpreter.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <unordered_set>
 
 int main(int argc, char **argv) {
     StackMachineInterpreter interpreter;
 
     // Default to output.bc, but allow override via command line
     std::string bytecodeFile = "output.bc";
-    if (argc > 1) {
-        bytecodeFile = argv[1];
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--dispatch=switch") {
+            interpreter.setThreadedDispatch(false);
+        } else if (arg == "--dispatch=threaded") {
+            interpreter.setThreadedDispatch(true);
+        } else if (arg == "--dispatch=jit" || arg.rfind("--jit-threshold=", 0) == 0) {
+            int threshold = StackMachineInterpreter::DEFAULT_JIT_THRESHOLD;
+            if (arg != "--dispatch=jit") threshold = std::max(1, std::atoi(arg.c_str() + strlen("--jit-threshold=")));
+            if (!interpreter.setJit(true, threshold)) {
+                std::cerr << "JIT is not supported on this platform, using the interpreter" << std::endl;
+            }
+        } else if (arg == "--stats") {
+            interpreter.setPrintStats(true);
+        } else if (arg == "--no-superinstructions") {
+            interpreter.setSuperinstructions(false);
+        } else if (arg == "--profile") {
+            interpreter.setProfiling(true);
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        } else {
+            bytecodeFile = arg;
+        }
     }
 
     // Load bytecode from the specified file
@@ -24,15 +56,24 @@ int main(int argc, char **argv) {
 }
 
 bool StackMachineInterpreter::loadBytecode(const std::string &filename) {
-    std::ifstream file(filename);
+    std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         std::cerr << "Failed to open bytecode file: " << filename << std::endl;
         return false;
     }
 
+    // Binary files are recognized by their magic number, everything else is parsed as text
+    char magic[sizeof(BYTECODE_MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+    if (file.gcount() == sizeof(magic) && std::equal(magic, magic + sizeof(magic), BYTECODE_MAGIC)) {
+        file.close();
+        return loadBinaryBytecode(filename);
+    }
+    file.clear();
+    file.seekg(0);
+
     std::string line;
-    std::string currentBlock;
-    std::vector<std::pair<OpCode, std::string>> instructions;
+    std::vector<BytecodeBlock> parsedBlocks;
 
     while (std::getline(file, line)) {
         // Skip empty lines
@@ -40,14 +81,7 @@ bool StackMachineInterpreter::loadBytecode(const std::string &filename) {
 
         // Check if this is a block (ends with :)
         if (line.back() == ':') {
-            // Save previous block if it exists
-            if (!currentBlock.empty()) {
-                blocks[currentBlock] = instructions;
-                instructions.clear();
-            }
-
-            // Set new current block
-            currentBlock = line.substr(0, line.size() - 1);
+            parsedBlocks.push_back({line.substr(0, line.size() - 1), {}});
             continue;
         }
 
@@ -112,84 +146,668 @@ bool StackMachineInterpreter::loadBytecode(const std::string &filename) {
                 opcode = OpCode::PRINT;
             else if (opcodeName == "stop")
                 opcode = OpCode::STOP;
+            else if (opcodeName == "newarray")
+                opcode = OpCode::NEWARRAY;
+            else if (opcodeName == "iaload")
+                opcode = OpCode::IALOAD;
+            else if (opcodeName == "iastore")
+                opcode = OpCode::IASTORE;
+            else if (opcodeName == "iaload_unchecked")
+                opcode = OpCode::IALOAD_UNCHECKED;
+            else if (opcodeName == "iastore_unchecked")
+                opcode = OpCode::IASTORE_UNCHECKED;
+            else if (opcodeName == "arraylength")
+                opcode = OpCode::ARRAYLENGTH;
+            else if (opcodeName == "new")
+                opcode = OpCode::NEW;
+            else if (opcodeName == "getfield")
+                opcode = OpCode::GETFIELD;
+            else if (opcodeName == "putfield")
+                opcode = OpCode::PUTFIELD;
+            else if (opcodeName == "ifne")
+                opcode = OpCode::IFNE;
+            else if (opcodeName == "if_icmplt")
+                opcode = OpCode::IF_ICMPLT;
+            else if (opcodeName == "if_icmpge")
+                opcode = OpCode::IF_ICMPGE;
+            else if (opcodeName == "if_icmpgt")
+                opcode = OpCode::IF_ICMPGT;
+            else if (opcodeName == "if_icmple")
+                opcode = OpCode::IF_ICMPLE;
+            else if (opcodeName == "if_icmpeq")
+                opcode = OpCode::IF_ICMPEQ;
+            else if (opcodeName == "if_icmpne")
+                opcode = OpCode::IF_ICMPNE;
             else {
                 std::cerr << "Unknown opcode: " << opcodeName << std::endl;
                 continue;
             }
 
-            instructions.push_back({opcode, argument});
+            if (parsedBlocks.empty()) {
+                std::cerr << "Instruction outside of a block: " << line << std::endl;
+                return false;
+            }
+            parsedBlocks.back().instructions.push_back({opcode, argument});
         }
     }
 
-    // Save the last method
-    if (!currentBlock.empty()) {
-        blocks[currentBlock] = instructions;
+    file.close();
+    return link(parsedBlocks);
+}
+
+bool StackMachineInterpreter::link(const std::vector<BytecodeBlock> &parsedBlocks) {
+    code.clear();
+    blocks.clear();
+    variableIds.clear();
+    variableNames.clear();
+    layoutIds.clear();
+    layouts.clear();
+
+    // Lay the blocks out back to back and remember where each one starts
+    std::unordered_map<std::string, size_t> blockAddresses;
+    size_t address = 0;
+    for (const auto &block : parsedBlocks) {
+        if (blockAddresses.count(block.name)) {
+            std::cerr << "Duplicate block: " << block.name << std::endl;
+            return false;
+        }
+        blockAddresses[block.name] = address;
+        blocks.push_back({block.name, address});
+        address += block.instructions.size();
     }
 
-    file.close();
+    // Resolve every argument to an integer operand
+    for (const auto &block : parsedBlocks) {
+        for (const auto &instruction : block.instructions) {
+            OpCode opcode = instruction.first;
+            const std::string &argument = instruction.second;
+
+            switch (opcode) {
+                case OpCode::ILOAD: {
+                    // Boolean literals are loaded as constants
+                    if (argument == "true" || argument == "false") {
+                        code.emplace_back(OpCode::ICONST, argument == "true" ? 1 : 0, true);
+                    } else {
+                        code.emplace_back(OpCode::ILOAD, getVariableId(argument));
+                    }
+                    break;
+                }
+                case OpCode::ISTORE: {
+                    code.emplace_back(OpCode::ISTORE, getVariableId(argument));
+                    break;
+                }
+                case OpCode::NEW: {
+                    int layout = getLayoutId(argument);
+                    if (layout < 0) {
+                        std::cerr << "Invalid object layout: " << argument << std::endl;
+                        return false;
+                    }
+                    code.emplace_back(OpCode::NEW, layout);
+                    break;
+                }
+                case OpCode::ICONST:
+                case OpCode::GETFIELD:
+                case OpCode::PUTFIELD: {
+                    try {
+                        code.emplace_back(opcode, std::stoi(argument));
+                    } catch (const std::exception &e) {
+                        std::cerr << "Invalid constant: " << argument << std::endl;
+                        return false;
+                    }
+                    break;
+                }
+                case OpCode::GOTO:
+                case OpCode::IFFALSEGOTO:
+                case OpCode::IFNE:
+                case OpCode::IF_ICMPLT:
+                case OpCode::IF_ICMPGE:
+                case OpCode::IF_ICMPGT:
+                case OpCode::IF_ICMPLE:
+                case OpCode::IF_ICMPEQ:
+                case OpCode::IF_ICMPNE:
+                case OpCode::INVOKEVIRTUAL: {
+                    auto it = blockAddresses.find(argument);
+                    if (it == blockAddresses.end()) {
+                        std::cerr << "Block not found: " << argument << std::endl;
+                        return false;
+                    }
+                    code.emplace_back(opcode, static_cast<int>(it->second));
+                    break;
+                }
+                default: {
+                    code.emplace_back(opcode);
+                    break;
+                }
+            }
+        }
+    }
+
+    return resolveMethods();
+}
+
+bool StackMachineInterpreter::loadBinaryBytecode(const std::string &filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open bytecode file: " << filename << std::endl;
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+        std::cerr << "Failed to read bytecode file: " << filename << std::endl;
+        close(fd);
+        return false;
+    }
+
+    size_t size = fileStat.st_size;
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "Failed to map bytecode file: " << filename << std::endl;
+        return false;
+    }
+
+    bool success = linkBinary(static_cast<const char *>(data), size);
+    munmap(data, size);
+    return success;
+}
+
+bool StackMachineInterpreter::linkBinary(const char *data, size_t size) {
+    code.clear();
+    blocks.clear();
+    variableIds.clear();
+    variableNames.clear();
+    layoutIds.clear();
+    layouts.clear();
+
+    // Walks the sections in file order, checking that each one fits in the file
+    size_t offset = 0;
+    auto section = [&](size_t bytes) -> const char * {
+        if (bytes > size - offset) return nullptr;
+        const char *start = data + offset;
+        offset += bytes;
+        return start;
+    };
+
+    const char *headerData = section(sizeof(BinaryHeader));
+    if (!headerData) {
+        std::cerr << "Truncated bytecode header" << std::endl;
+        return false;
+    }
+    const BinaryHeader &header = *reinterpret_cast<const BinaryHeader *>(headerData);
+    if (header.version != BYTECODE_VERSION) {
+        std::cerr << "Unsupported bytecode version: " << header.version << std::endl;
+        return false;
+    }
+
+    const uint32_t *stringOffsets =
+        reinterpret_cast<const uint32_t *>(section(size_t(header.stringCount) * sizeof(uint32_t)));
+    const char *stringData = section(header.stringDataSize);
+    const int32_t *constants =
+        reinterpret_cast<const int32_t *>(section(size_t(header.constantCount) * sizeof(int32_t)));
+    const BinaryBlock *binaryBlocks =
+        reinterpret_cast<const BinaryBlock *>(section(size_t(header.blockCount) * sizeof(BinaryBlock)));
+    const BinaryInstruction *instructions = reinterpret_cast<const BinaryInstruction *>(
+        section(size_t(header.instructionCount) * sizeof(BinaryInstruction)));
+    if ((header.stringCount && !stringOffsets) || (header.stringDataSize && !stringData) ||
+        (header.constantCount && !constants) || (header.blockCount && !binaryBlocks) ||
+        (header.instructionCount && !instructions)) {
+        std::cerr << "Truncated bytecode file" << std::endl;
+        return false;
+    }
+    if (header.stringDataSize && stringData[header.stringDataSize - 1] != '\0') {
+        std::cerr << "Unterminated string table" << std::endl;
+        return false;
+    }
+    if (header.stringDataSize % alignof(int32_t) != 0) {
+        std::cerr << "Unaligned constant pool" << std::endl;
+        return false;
+    }
+
+    auto getString = [&](uint32_t index) -> const char * {
+        if (index >= header.stringCount || stringOffsets[index] >= header.stringDataSize) return nullptr;
+        return stringData + stringOffsets[index];
+    };
+
+    // Blocks must tile the instruction array in order, as the compiler lays them out
+    uint32_t expectedStart = 0;
+    std::unordered_set<std::string> blockNames;
+    for (uint32_t i = 0; i < header.blockCount; i++) {
+        const char *name = getString(binaryBlocks[i].name);
+        if (!name || binaryBlocks[i].firstInstruction != expectedStart) {
+            std::cerr << "Malformed block table entry: " << i << std::endl;
+            return false;
+        }
+        if (!blockNames.insert(name).second) {
+            std::cerr << "Duplicate block: " << name << std::endl;
+            return false;
+        }
+        blocks.push_back({name, expectedStart});
+        expectedStart += binaryBlocks[i].instructionCount;
+    }
+    if (expectedStart != header.instructionCount) {
+        std::cerr << "Block table does not cover the instructions" << std::endl;
+        return false;
+    }
+
+    // Variable names are interned once per string rather than once per instruction
+    std::vector<int> stringVariables(header.stringCount, -1);
+    code.reserve(header.instructionCount);
+    for (uint32_t i = 0; i < header.instructionCount; i++) {
+        const BinaryInstruction &instruction = instructions[i];
+        OpCode opcode = static_cast<OpCode>(instruction.opcode);
+        uint32_t operand = instruction.operand;
+
+        switch (opcode) {
+            case OpCode::ILOAD:
+            case OpCode::ISTORE: {
+                const char *name = getString(operand);
+                if (!name) {
+                    std::cerr << "Invalid variable reference at instruction " << i << std::endl;
+                    return false;
+                }
+                bool isLiteral = opcode == OpCode::ILOAD && (!strcmp(name, "true") || !strcmp(name, "false"));
+                if (isLiteral) {
+                    code.emplace_back(OpCode::ICONST, !strcmp(name, "true") ? 1 : 0, true);
+                } else {
+                    if (stringVariables[operand] < 0) stringVariables[operand] = getVariableId(name);
+                    code.emplace_back(opcode, stringVariables[operand]);
+                }
+                break;
+            }
+            case OpCode::ICONST: {
+                if (operand >= header.constantCount) {
+                    std::cerr << "Invalid constant reference at instruction " << i << std::endl;
+                    return false;
+                }
+                code.emplace_back(OpCode::ICONST, constants[operand]);
+                break;
+            }
+            case OpCode::GOTO:
+            case OpCode::IFFALSEGOTO:
+            case OpCode::IFNE:
+            case OpCode::IF_ICMPLT:
+            case OpCode::IF_ICMPGE:
+            case OpCode::IF_ICMPGT:
+            case OpCode::IF_ICMPLE:
+            case OpCode::IF_ICMPEQ:
+            case OpCode::IF_ICMPNE:
+            case OpCode::INVOKEVIRTUAL: {
+                if (operand >= header.blockCount) {
+                    std::cerr << "Invalid block reference at instruction " << i << std::endl;
+                    return false;
+                }
+                code.emplace_back(opcode, static_cast<int>(blocks[operand].start));
+                break;
+            }
+            case OpCode::NEW: {
+                const char *descriptor = getString(operand);
+                int layout = descriptor ? getLayoutId(descriptor) : -1;
+                if (layout < 0) {
+                    std::cerr << "Invalid object layout at instruction " << i << std::endl;
+                    return false;
+                }
+                code.emplace_back(OpCode::NEW, layout);
+                break;
+            }
+            case OpCode::GETFIELD:
+            case OpCode::PUTFIELD: {
+                // Field indices are checked against the object when the instruction runs
+                if (operand > static_cast<uint32_t>(INT_MAX)) {
+                    std::cerr << "Invalid field operand at instruction " << i << std::endl;
+                    return false;
+                }
+                code.emplace_back(opcode, static_cast<int>(operand));
+                break;
+            }
+            default: {
+                if (instruction.opcode >= OPCODE_COUNT) {
+                    std::cerr << "Unknown opcode: " << static_cast<int>(instruction.opcode) << std::endl;
+                    return false;
+                }
+                code.emplace_back(opcode);
+                break;
+            }
+        }
+    }
+
+    return resolveMethods();
+}
+
+bool StackMachineInterpreter::resolveMethods() {
+    methods.clear();
+
+    // The program starts in the main method, wherever the compiler placed it
+    size_t entry = 0;
+    for (const auto &block : blocks) {
+        if (block.name.size() > 5 && block.name.compare(block.name.size() - 5, 5, ".main") == 0) {
+            entry = block.start;
+            break;
+        }
+    }
+
+    // Every call target starts a method, and so does the entry point
+    std::unordered_map<size_t, int> methodIndices;
+    auto addMethod = [&](size_t address) {
+        if (methodIndices.count(address)) return;
+        methodIndices[address] = static_cast<int>(methods.size());
+        methods.push_back({blockAt(address).name, address, 0, {}});
+    };
+    addMethod(entry);
+    for (const auto &instruction : code) {
+        if (instruction.opcode == OpCode::INVOKEVIRTUAL) addMethod(instruction.operand);
+    }
+
+    // Assign each block to the method it is reachable from without calls
+    std::vector<int> blockOwners(blocks.size(), -1);
+    for (size_t method = 0; method < methods.size(); method++) {
+        std::vector<size_t> worklist = {blockIndexAt(methods[method].entry)};
+        while (!worklist.empty()) {
+            size_t block = worklist.back();
+            worklist.pop_back();
+            if (blockOwners[block] == static_cast<int>(method)) continue;
+            if (blockOwners[block] != -1) {
+                std::cerr << "Block " << blocks[block].name << " is shared by methods " << methods[method].name
+                          << " and " << methods[blockOwners[block]].name << std::endl;
+                return false;
+            }
+            blockOwners[block] = static_cast<int>(method);
+
+            size_t end = block + 1 < blocks.size() ? blocks[block + 1].start : code.size();
+            bool fallsThrough = true;
+            for (size_t address = blocks[block].start; address < end; address++) {
+                const Instruction &instruction = code[address];
+                if (isJump(instruction.opcode)) {
+                    worklist.push_back(blockIndexAt(instruction.operand));
+                }
+                fallsThrough = instruction.opcode != OpCode::GOTO && instruction.opcode != OpCode::IRETURN &&
+                               instruction.opcode != OpCode::STOP;
+            }
+            if (fallsThrough && block + 1 < blocks.size()) worklist.push_back(block + 1);
+        }
+    }
+
+    // Number the variables of each method from zero, so a frame only holds what its method uses
+    std::vector<std::vector<bool>> storedSlots(methods.size());
+    for (size_t block = 0; block < blocks.size(); block++) {
+        if (blockOwners[block] == -1) continue;  // Unreachable code keeps its global ids
+        MethodInfo &method = methods[blockOwners[block]];
+        size_t end = block + 1 < blocks.size() ? blocks[block + 1].start : code.size();
+        for (size_t address = blocks[block].start; address < end; address++) {
+            Instruction &instruction = code[address];
+            if (instruction.opcode == OpCode::ILOAD || instruction.opcode == OpCode::ISTORE) {
+                const std::string &name = variableNames[instruction.operand];
+                auto it = method.slots.find(name);
+                if (it == method.slots.end()) {
+                    it = method.slots.emplace(name, method.frameSize++).first;
+                    storedSlots[blockOwners[block]].push_back(false);
+                }
+                instruction.operand = it->second;
+                if (instruction.opcode == OpCode::ISTORE) storedSlots[blockOwners[block]][it->second] = true;
+            } else if (instruction.opcode == OpCode::INVOKEVIRTUAL) {
+                instruction.operand = methodIndices[instruction.operand];
+            }
+        }
+    }
+
+    // A variable that is loaded but never stored in its method can never hold a value
+    for (size_t method = 0; method < methods.size(); method++) {
+        for (const auto &slot : methods[method].slots) {
+            if (!storedSlots[method][slot.second]) {
+                std::cerr << "Variable not found: " << slot.first << " in " << methods[method].name << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // The JIT compiles plain opcodes and the profile counts them, so neither sees superinstructions
+    if (useSuperinstructions && !jitEnabled && !profiling) formSuperinstructions();
     return true;
 }
 
+void StackMachineInterpreter::formSuperinstructions() {
+    // The sequences that ran most often in the benchmarks, by opcode pair and triple profiles, longest first
+    struct Superinstruction {
+        OpCode opcode;
+        std::vector<OpCode> sequence;
+    };
+    static const std::vector<Superinstruction> superinstructions = {
+        {OpCode::ILOAD_ICONST_IADD_ISTORE, {OpCode::ILOAD, OpCode::ICONST, OpCode::IADD, OpCode::ISTORE}},
+        {OpCode::ILOAD_ICONST_ISUB_ISTORE, {OpCode::ILOAD, OpCode::ICONST, OpCode::ISUB, OpCode::ISTORE}},
+        {OpCode::ILOAD_ILOAD_IADD, {OpCode::ILOAD, OpCode::ILOAD, OpCode::IADD}},
+        {OpCode::ILOAD_ILOAD, {OpCode::ILOAD, OpCode::ILOAD}},
+        {OpCode::ILOAD_ICONST, {OpCode::ILOAD, OpCode::ICONST}},
+        {OpCode::ILOAD_GETFIELD, {OpCode::ILOAD, OpCode::GETFIELD}},
+        {OpCode::IADD_ISTORE, {OpCode::IADD, OpCode::ISTORE}},
+        {OpCode::ISUB_ISTORE, {OpCode::ISUB, OpCode::ISTORE}},
+        {OpCode::ISTORE_GOTO, {OpCode::ISTORE, OpCode::GOTO}},
+    };
+
+    superinstructionCount = 0;
+    size_t address = 0;
+    while (address < code.size()) {
+        size_t length = 1;
+        for (const auto &superinstruction : superinstructions) {
+            const std::vector<OpCode> &sequence = superinstruction.sequence;
+            if (address + sequence.size() > code.size()) continue;
+            bool matches = true;
+            for (size_t i = 0; i < sequence.size() && matches; i++) {
+                matches = code[address + i].opcode == sequence[i];
+            }
+            if (matches) {
+                code[address].opcode = superinstruction.opcode;
+                length = sequence.size();
+                superinstructionCount++;
+                break;
+            }
+        }
+        address += length;
+    }
+}
+
+int StackMachineInterpreter::getVariableId(const std::string &name) {
+    auto it = variableIds.find(name);
+    if (it != variableIds.end()) {
+        return it->second;
+    }
+    int id = static_cast<int>(variableNames.size());
+    variableIds[name] = id;
+    variableNames.push_back(name);
+    return id;
+}
+
+int StackMachineInterpreter::getLayoutId(const std::string &descriptor) {
+    auto it = layoutIds.find(descriptor);
+    if (it != layoutIds.end()) return it->second;
+    if (descriptor.size() > static_cast<size_t>(INT_MAX)) return -1;
+    ObjectLayout layout = {static_cast<int>(descriptor.size()), {}};
+    for (size_t i = 0; i < descriptor.size(); i++) {
+        if (descriptor[i] == 'Z') {
+            layout.booleanFields.push_back(i);
+        } else if (descriptor[i] != 'I') {
+            return -1;
+        }
+    }
+    int id = static_cast<int>(layouts.size());
+    layoutIds[descriptor] = id;
+    layouts.push_back(std::move(layout));
+    return id;
+}
+
+size_t StackMachineInterpreter::blockIndexAt(size_t address) const {
+    // Blocks are stored in address order, so the owner is the last block starting at or before the address
+    auto it = std::upper_bound(blocks.begin(), blocks.end(), address,
+                               [](size_t addr, const BlockInfo &block) { return addr < block.start; });
+    return std::distance(blocks.begin(), it) - 1;
+}
+
+const BlockInfo &StackMachineInterpreter::blockAt(size_t address) const { return blocks[blockIndexAt(address)]; }
+
 int StackMachineInterpreter::execute() {
     // Reset state
     reset();
 
     // Check if we have any methods
-    if (blocks.empty()) {
+    if (code.empty()) {
         std::cerr << "No blocks found in bytecode" << std::endl;
         return -1;
     }
 
-    currentBlock = blocks.begin()->first;
-
-    // Start execution from the main method
-    programCounter = 0;
+    // Start execution from the main method, whose frame sits at the bottom of the frame stack
+    currentMethod = 0;
+    framePointer = 0;
+    frameSlots.assign(methods[currentMethod].frameSize, StackValue());
+    programCounter = methods[currentMethod].entry;
     running = true;
 
     // Execute instructions until program terminates
-    while (running) {
-        if (!executeInstruction()) {
-            std::cerr << "Execution error at block: " << currentBlock << ", address: " << programCounter << std::endl;
-            break;
+    bool success = profiling ? runSwitch() : jitEnabled ? runJit() : threadedDispatch ? runThreaded() : runSwitch();
+    if (!success) {
+        const BlockInfo &block = blockAt(programCounter);
+        std::cerr << "Execution error at block: " << block.name << ", address: " << programCounter - block.start
+                  << std::endl;
+    }
+
+    if (profiling) printProfile();
+    if (printStats) {
+        std::cerr << "Dispatch: " << dispatchCount << " dispatches" << std::endl;
+        std::cerr << "Calls: " << maxCallDepth << " frames deep at most" << std::endl;
+        const HeapStats &stats = heap.getStats();
+        std::cerr << "GC: " << stats.minorCollections << " minor, " << stats.majorCollections << " major collections"
+                  << std::endl;
+        std::cerr << "GC: " << stats.allocatedWords << " words allocated, " << stats.promotedWords << " promoted"
+                  << std::endl;
+        std::cerr << "GC: pause total " << stats.totalPauseMs << " ms, max " << stats.maxPauseMs << " ms" << std::endl;
+        if (superinstructionCount > 0) {
+            std::cerr << "Superinstructions: " << superinstructionCount << " formed" << std::endl;
+        }
+        if (jitEnabled && !profiling) {
+            std::cerr << "JIT: " << jit.getCompiledBlocks() << " blocks compiled, " << jit.getCodeSize()
+                      << " bytes of native code" << std::endl;
         }
     }
 
     return 0;
 }
 
+bool StackMachineInterpreter::setJit(bool enabled, int threshold) {
+    jitEnabled = enabled && JitCompiler::isAvailable();
+    jitThreshold = threshold;
+    return jitEnabled || !enabled;
+}
+
+bool StackMachineInterpreter::runJit() {
+    blockStarts.assign(code.size(), -1);
+    for (size_t i = 0; i < blocks.size(); i++) blockStarts[blocks[i].start] = static_cast<int>(i);
+    jitBlocks.assign(blocks.size(), JitBlockState());
+
+    StackValue buffer[JitCompiler::MAX_STACK_DEPTH];
+    while (running) {
+        int block = programCounter < blockStarts.size() ? blockStarts[programCounter] : -1;
+        if (block >= 0) {
+            JitBlockState &state = jitBlocks[block];
+            if (!state.compiled.entry && !state.failed && ++state.entries >= jitThreshold) {
+                size_t end = block + 1 < static_cast<int>(blocks.size()) ? blocks[block + 1].start : code.size();
+                state.failed = !jit.compile(code, programCounter, end, state.compiled);
+            }
+            if (state.compiled.entry) {
+                dispatchCount++;
+                programCounter = state.compiled.entry(frameSlots.data() + framePointer, buffer);
+                operandStack.insert(operandStack.end(), buffer, buffer + state.compiled.exitDepth);
+                continue;
+            }
+        }
+        if (!executeInstruction()) return false;
+    }
+    return true;
+}
+
+bool StackMachineInterpreter::runSwitch() {
+    while (running) {
+        if (!executeInstruction()) return false;
+    }
+    return true;
+}
+
+void StackMachineInterpreter::recordProfile() {
+    if (pairCounts.empty()) {
+        pairCounts.assign(OPCODE_COUNT * OPCODE_COUNT, 0);
+        tripleCounts.assign(OPCODE_COUNT * OPCODE_COUNT * OPCODE_COUNT, 0);
+    }
+
+    // Only instructions at consecutive addresses form a sequence, a jump or call starts a new one
+    if (programCounter != previousAddress + 1) sequenceLength = 0;
+    size_t opcode = static_cast<size_t>(code[programCounter].opcode);
+    size_t first = static_cast<size_t>(previousOpcodes[0]);
+    size_t second = static_cast<size_t>(previousOpcodes[1]);
+    if (sequenceLength >= 1) pairCounts[second * OPCODE_COUNT + opcode]++;
+    if (sequenceLength >= 2) tripleCounts[(first * OPCODE_COUNT + second) * OPCODE_COUNT + opcode]++;
+
+    previousOpcodes[0] = previousOpcodes[1];
+    previousOpcodes[1] = code[programCounter].opcode;
+    sequenceLength = std::min(sequenceLength + 1, 2);
+    previousAddress = programCounter;
+}
+
+void StackMachineInterpreter::printProfile() const {
+    // Profiles only see plain opcodes, named as in text bytecode
+    static const char *const names[OPCODE_COUNT] = {
+        "iload", "iconst", "istore", "iadd", "isub", "imul", "idiv", "ilt", "igt", "ieq", "iand", "ior", "inot", "goto",
+        "iffalsegoto", "invokevirtual", "ireturn", "print", "stop", "newarray", "iaload", "iastore", "arraylength",
+        "new", "getfield", "putfield", "ifne", "if_icmplt", "if_icmpge", "if_icmpgt", "if_icmple", "if_icmpeq",
+        "if_icmpne", "iaload_unchecked", "iastore_unchecked",
+    };
+    const size_t shown = 20;
+
+    // Prints the most frequent sequences of one length, decoding each index back into its opcodes
+    auto print = [&](const std::vector<uint64_t> &counts, int length) {
+        std::vector<size_t> order;
+        for (size_t i = 0; i < counts.size(); i++) {
+            if (counts[i] > 0) order.push_back(i);
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return counts[a] != counts[b] ? counts[a] > counts[b] : a < b;
+        });
+        if (order.size() > shown) order.resize(shown);
+
+        for (size_t index : order) {
+            std::string sequence;
+            for (int i = length - 1, rest = static_cast<int>(index); i >= 0; i--) {
+                int divisor = i == 2 ? OPCODE_COUNT * OPCODE_COUNT : i == 1 ? OPCODE_COUNT : 1;
+                sequence += names[rest / divisor];
+                if (i > 0) sequence += ";";
+                rest %= divisor;
+            }
+            std::cerr << "Profile: " << sequence << " " << counts[index] << std::endl;
+        }
+    };
+    print(pairCounts, 2);
+    print(tripleCounts, 3);
+}
+
 bool StackMachineInterpreter::executeInstruction() {
     // Check if we're out of bounds
-    if (programCounter >= blocks[currentBlock].size()) {
+    if (programCounter >= code.size()) {
         std::cerr << "Program counter out of bounds: " << programCounter << std::endl;
         running = false;
         return false;
     }
 
     // Get the current instruction
-    const auto &instruction = blocks[currentBlock][programCounter];
-    OpCode opcode = instruction.first;
-    const std::string &argument = instruction.second;
+    const Instruction &instruction = code[programCounter];
+    dispatchCount++;
+    if (profiling) recordProfile();
 
     // Execute the instruction
-    switch (opcode) {
+    switch (instruction.opcode) {
         case OpCode::ILOAD: {
-            // Handle boolean literals
-            if (argument == "true") {
-                operandStack.push(StackValue(1, true));
-            } else if (argument == "false") {
-                operandStack.push(StackValue(0, true));
-            } else if (localVariables.find(argument) == localVariables.end()) {
-                std::cerr << "Variable not found: " << argument << std::endl;
-                return false;
-            } else {
-                operandStack.push(localVariables[argument]);
-            }
+            operandStack.push_back(frameSlots[framePointer + instruction.operand]);
             programCounter++;
             break;
         }
         case OpCode::ICONST: {
-            // Load constant onto stack - always an integer
-            operandStack.push(StackValue(std::stoi(argument)));
+            // Load constant onto stack, parsed when the program was linked
+            operandStack.push_back(StackValue(instruction.operand, instruction.isBoolean));
             programCounter++;
             break;
         }
@@ -199,9 +817,8 @@ bool StackMachineInterpreter::executeInstruction() {
                 std::cerr << "Stack underflow on ISTORE" << std::endl;
                 return false;
             }
-            StackValue stackVal = operandStack.top();
-            localVariables[argument] = stackVal;
-            operandStack.pop();
+            frameSlots[framePointer + instruction.operand] = operandStack.back();
+            operandStack.pop_back();
             programCounter++;
             break;
         }
@@ -211,12 +828,12 @@ bool StackMachineInterpreter::executeInstruction() {
                 std::cerr << "Stack underflow on IADD" << std::endl;
                 return false;
             }
-            StackValue b = operandStack.top();
-            operandStack.pop();
-            StackValue a = operandStack.top();
-            operandStack.pop();
+            StackValue b = operandStack.back();
+            operandStack.pop_back();
+            StackValue a = operandStack.back();
+            operandStack.pop_back();
 
-            operandStack.push(StackValue(a.value + b.value, false));
+            operandStack.push_back(StackValue(a.value + b.value, false));
             programCounter++;
             break;
         }
@@ -226,12 +843,12 @@ bool StackMachineInterpreter::executeInstruction() {
                 std::cerr << "Stack underflow on ISUB" << std::endl;
                 return false;
             }
-            StackValue b = operandStack.top();
-            operandStack.pop();
-            StackValue a = operandStack.top();
-            operandStack.pop();
+            StackValue b = operandStack.back();
+            operandStack.pop_back();
+            StackValue a = operandStack.back();
+            operandStack.pop_back();
 
-            operandStack.push(StackValue(a.value - b.value, false));
+            operandStack.push_back(StackValue(a.value - b.value, false));
             programCounter++;
             break;
         }
@@ -241,12 +858,12 @@ bool StackMachineInterpreter::executeInstruction() {
                 std::cerr << "Stack underflow on IMUL" << std::endl;
                 return false;
             }
-            StackValue b = operandStack.top();
-            operandStack.pop();
-            StackValue a = operandStack.top();
-            operandStack.pop();
+            StackValue b = operandStack.back();
+            operandStack.pop_back();
+            StackValue a = operandStack.back();
+            operandStack.pop_back();
 
-            operandStack.push(StackValue(a.value * b.value, false));
+            operandStack.push_back(StackValue(a.value * b.value, false));
             programCounter++;
             break;
         }
@@ -256,16 +873,16 @@ bool StackMachineInterpreter::executeInstruction() {
                 std::cerr << "Stack underflow on IDIV" << std::endl;
                 return false;
             }
-            StackValue b = operandStack.top();
-            operandStack.pop();
+            StackValue b = operandStack.back();
+            operandStack.pop_back();
             if (b.value == 0) {
                 std::cerr << "Division by zero" << std::endl;
                 return false;
             }
-            StackValue a = operandStack.top();
-            operandStack.pop();
+            StackValue a = operandStack.back();
+            operandStack.pop_back();
 
-            operandStack.push(StackValue(a.value / b.value, false));
+            operandStack.push_back(StackValue(a.value / b.value, false));
             programCounter++;
             break;
         }
@@ -275,12 +892,12 @@ bool StackMachineInterpreter::executeInstruction() {
                 std::cerr << "Stack underflow on ILT" << std::endl;
                 return false;
             }
-            StackValue b = operandStack.top();
-            operandStack.pop();
-            StackValue a = operandStack.top();
-            operandStack.pop();
+            StackValue b = operandStack.back();
+            operandStack.pop_back();
+            StackValue a = operandStack.back();
+            operandStack.pop_back();
 
-            operandStack.push(StackValue(a.value < b.value ? 1 : 0, true));
+            operandStack.push_back(StackValue(a.value < b.value ? 1 : 0, true));
             programCounter++;
             break;
         }
@@ -290,12 +907,12 @@ bool StackMachineInterpreter::executeInstruction() {
                 std::cerr << "Stack underflow on IGT" << std::endl;
                 return false;
             }
-            StackValue b = operandStack.top();
-            operandStack.pop();
-            StackValue a = operandStack.top();
-            operandStack.pop();
+            StackValue b = operandStack.back();
+            operandStack.pop_back();
+            StackValue a = operandStack.back();
+            operandStack.pop_back();
 
-            operandStack.push(StackValue(a.value > b.value ? 1 : 0, true));
+            operandStack.push_back(StackValue(a.value > b.value ? 1 : 0, true));
             programCounter++;
             break;
         }
@@ -305,12 +922,12 @@ bool StackMachineInterpreter::executeInstruction() {
                 std::cerr << "Stack underflow on IEQ" << std::endl;
                 return false;
             }
-            StackValue b = operandStack.top();
-            operandStack.pop();
-            StackValue a = operandStack.top();
-            operandStack.pop();
+            StackValue b = operandStack.back();
+            operandStack.pop_back();
+            StackValue a = operandStack.back();
+            operandStack.pop_back();
 
-            operandStack.push(StackValue(a.value == b.value ? 1 : 0, true));
+            operandStack.push_back(StackValue(a.value == b.value ? 1 : 0, true));
             programCounter++;
             break;
         }
@@ -320,12 +937,12 @@ bool StackMachineInterpreter::executeInstruction() {
                 std::cerr << "Stack underflow on IAND" << std::endl;
                 return false;
             }
-            StackValue b = operandStack.top();
-            operandStack.pop();
-            StackValue a = operandStack.top();
-            operandStack.pop();
+            StackValue b = operandStack.back();
+            operandStack.pop_back();
+            StackValue a = operandStack.back();
+            operandStack.pop_back();
 
-            operandStack.push(StackValue((a.value != 0 && b.value != 0) ? 1 : 0, true));
+            operandStack.push_back(StackValue((a.value != 0 && b.value != 0) ? 1 : 0, true));
             programCounter++;
             break;
         }
@@ -335,12 +952,12 @@ bool StackMachineInterpreter::executeInstruction() {
                 std::cerr << "Stack underflow on IOR" << std::endl;
                 return false;
             }
-            StackValue b = operandStack.top();
-            operandStack.pop();
-            StackValue a = operandStack.top();
-            operandStack.pop();
+            StackValue b = operandStack.back();
+            operandStack.pop_back();
+            StackValue a = operandStack.back();
+            operandStack.pop_back();
 
-            operandStack.push(StackValue((a.value != 0 || b.value != 0) ? 1 : 0, true));
+            operandStack.push_back(StackValue((a.value != 0 || b.value != 0) ? 1 : 0, true));
             programCounter++;
             break;
         }
@@ -350,18 +967,15 @@ bool StackMachineInterpreter::executeInstruction() {
                 std::cerr << "Stack underflow on INOT" << std::endl;
                 return false;
             }
-            StackValue a = operandStack.top();
-            operandStack.pop();
+            StackValue a = operandStack.back();
+            operandStack.pop_back();
 
-            operandStack.push(StackValue(a.value == 0 ? 1 : 0, true));
+            operandStack.push_back(StackValue(a.value == 0 ? 1 : 0, true));
             programCounter++;
             break;
         }
         case OpCode::GOTO: {
-            if (!jumpToBlock(argument)) {
-                std::cerr << "Failed to jump to method: " << argument << std::endl;
-                return false;
-            }
+            programCounter = instruction.operand;
             break;
         }
         case OpCode::IFFALSEGOTO: {
@@ -371,26 +985,83 @@ bool StackMachineInterpreter::executeInstruction() {
                 return false;
             }
 
-            int condition = operandStack.top().value;
-            operandStack.pop();
+            int condition = operandStack.back().value;
+            operandStack.pop_back();
 
             if (condition == 0) {
-                if (!jumpToBlock(argument)) {
-                    std::cerr << "Failed to jump to method: " << argument << std::endl;
-                    return false;
-                }
+                programCounter = instruction.operand;
             } else {
                 programCounter++;
             }
             break;
         }
-        case OpCode::INVOKEVIRTUAL: {
-            // Push current method and address to stack frame
-            stackFrame.push({currentBlock, programCounter + 1, localVariables});
-            if (!jumpToBlock(argument)) {
-                std::cerr << "Failed to jump to method: " << argument << std::endl;
+        case OpCode::IFNE: {
+            // Conditional jump if top of stack is true
+            if (operandStack.empty()) {
+                std::cerr << "Stack underflow on IFNE" << std::endl;
+                return false;
+            }
+
+            int condition = operandStack.back().value;
+            operandStack.pop_back();
+
+            programCounter = condition != 0 ? instruction.operand : programCounter + 1;
+            break;
+        }
+        case OpCode::IF_ICMPLT:
+        case OpCode::IF_ICMPGE:
+        case OpCode::IF_ICMPGT:
+        case OpCode::IF_ICMPLE:
+        case OpCode::IF_ICMPEQ:
+        case OpCode::IF_ICMPNE: {
+            // Compare the top two values and jump if the comparison holds
+            if (operandStack.size() < 2) {
+                std::cerr << "Stack underflow on IF_ICMP" << std::endl;
                 return false;
             }
+            int b = operandStack.back().value;
+            operandStack.pop_back();
+            int a = operandStack.back().value;
+            operandStack.pop_back();
+
+            bool taken = false;
+            switch (instruction.opcode) {
+                case OpCode::IF_ICMPLT:
+                    taken = a < b;
+                    break;
+                case OpCode::IF_ICMPGE:
+                    taken = a >= b;
+                    break;
+                case OpCode::IF_ICMPGT:
+                    taken = a > b;
+                    break;
+                case OpCode::IF_ICMPLE:
+                    taken = a <= b;
+                    break;
+                case OpCode::IF_ICMPEQ:
+                    taken = a == b;
+                    break;
+                default:
+                    taken = a != b;
+                    break;
+            }
+            programCounter = taken ? instruction.operand : programCounter + 1;
+            break;
+        }
+        case OpCode::INVOKEVIRTUAL: {
+            // The callee's frame starts right above the caller's, and only its slots are cleared
+            const MethodInfo &callee = methods[instruction.operand];
+            size_t calleeFrame = framePointer + methods[currentMethod].frameSize;
+            if (calleeFrame + callee.frameSize > frameSlots.size()) {
+                frameSlots.resize(std::max(frameSlots.size() * 2, calleeFrame + callee.frameSize));
+            }
+            std::fill_n(frameSlots.begin() + calleeFrame, callee.frameSize, StackValue());
+
+            stackFrame.push_back({programCounter + 1, framePointer, currentMethod});
+            maxCallDepth = std::max(maxCallDepth, stackFrame.size());
+            framePointer = calleeFrame;
+            currentMethod = instruction.operand;
+            programCounter = callee.entry;
             break;
         }
         case OpCode::IRETURN: {
@@ -405,12 +1076,11 @@ bool StackMachineInterpreter::executeInstruction() {
                 return false;
             } else {
                 // Restore state
-                StackFrame frame = stackFrame.top();
-                stackFrame.pop();
-
-                currentBlock = frame.method;
+                const StackFrame &frame = stackFrame.back();
                 programCounter = frame.returnAddress;
-                localVariables = frame.localVariables;
+                framePointer = frame.framePointer;
+                currentMethod = frame.method;
+                stackFrame.pop_back();
             }
             break;
         }
@@ -421,7 +1091,7 @@ bool StackMachineInterpreter::executeInstruction() {
                 return false;
             }
 
-            const StackValue &val = operandStack.top();
+            const StackValue &val = operandStack.back();
 
             // If it's a boolean type, print true/false, otherwise print the number
             if (val.isBoolean) {
@@ -430,7 +1100,7 @@ bool StackMachineInterpreter::executeInstruction() {
                 std::cout << val.value << std::endl;
             }
 
-            operandStack.pop();
+            operandStack.pop_back();
             programCounter++;
             break;
         }
@@ -439,8 +1109,107 @@ bool StackMachineInterpreter::executeInstruction() {
             running = false;
             return true;
         }
+        case OpCode::NEWARRAY: {
+            if (!newArray()) return false;
+            programCounter++;
+            break;
+        }
+        case OpCode::IALOAD:
+        case OpCode::IALOAD_UNCHECKED: {
+            if (!arrayLoad()) return false;
+            programCounter++;
+            break;
+        }
+        case OpCode::IASTORE:
+        case OpCode::IASTORE_UNCHECKED: {
+            if (!arrayStore()) return false;
+            programCounter++;
+            break;
+        }
+        case OpCode::ARRAYLENGTH: {
+            if (!arrayLength()) return false;
+            programCounter++;
+            break;
+        }
+        case OpCode::NEW: {
+            if (!newObject(instruction.operand)) return false;
+            programCounter++;
+            break;
+        }
+        case OpCode::GETFIELD: {
+            if (!getField(instruction.operand)) return false;
+            programCounter++;
+            break;
+        }
+        case OpCode::PUTFIELD: {
+            if (!putField(instruction.operand)) return false;
+            programCounter++;
+            break;
+        }
+        case OpCode::ILOAD_ILOAD: {
+            operandStack.push_back(frameSlots[framePointer + instruction.operand]);
+            operandStack.push_back(frameSlots[framePointer + code[programCounter + 1].operand]);
+            programCounter += 2;
+            break;
+        }
+        case OpCode::ILOAD_ICONST: {
+            const Instruction &constant = code[programCounter + 1];
+            operandStack.push_back(frameSlots[framePointer + instruction.operand]);
+            operandStack.push_back(StackValue(constant.operand, constant.isBoolean));
+            programCounter += 2;
+            break;
+        }
+        case OpCode::ILOAD_GETFIELD: {
+            operandStack.push_back(frameSlots[framePointer + instruction.operand]);
+            programCounter++;
+            if (!getField(code[programCounter].operand)) return false;
+            programCounter++;
+            break;
+        }
+        case OpCode::IADD_ISTORE:
+        case OpCode::ISUB_ISTORE: {
+            bool add = instruction.opcode == OpCode::IADD_ISTORE;
+            if (operandStack.size() < 2) {
+                std::cerr << "Stack underflow on " << (add ? "IADD" : "ISUB") << std::endl;
+                return false;
+            }
+            StackValue b = operandStack.back();
+            operandStack.pop_back();
+            StackValue a = operandStack.back();
+            operandStack.pop_back();
+            frameSlots[framePointer + code[programCounter + 1].operand] =
+                StackValue(add ? a.value + b.value : a.value - b.value, false);
+            programCounter += 2;
+            break;
+        }
+        case OpCode::ISTORE_GOTO: {
+            if (operandStack.empty()) {
+                std::cerr << "Stack underflow on ISTORE" << std::endl;
+                return false;
+            }
+            frameSlots[framePointer + instruction.operand] = operandStack.back();
+            operandStack.pop_back();
+            programCounter = code[programCounter + 1].operand;
+            break;
+        }
+        case OpCode::ILOAD_ILOAD_IADD: {
+            int a = frameSlots[framePointer + instruction.operand].value;
+            int b = frameSlots[framePointer + code[programCounter + 1].operand].value;
+            operandStack.push_back(StackValue(a + b, false));
+            programCounter += 3;
+            break;
+        }
+        case OpCode::ILOAD_ICONST_IADD_ISTORE:
+        case OpCode::ILOAD_ICONST_ISUB_ISTORE: {
+            int a = frameSlots[framePointer + instruction.operand].value;
+            int b = code[programCounter + 1].operand;
+            bool add = instruction.opcode == OpCode::ILOAD_ICONST_IADD_ISTORE;
+            frameSlots[framePointer + code[programCounter + 3].operand] = StackValue(add ? a + b : a - b, false);
+            programCounter += 4;
+            break;
+        }
         default: {
-            std::cerr << "Unknown opcode: " << static_cast<int>(opcode) << std::endl;
+            std::cerr << "Unknown opcode: " << static_cast<int>(instruction.opcode) << std::endl;
             return false;
         }
     }
@@ -448,32 +1217,559 @@ bool StackMachineInterpreter::executeInstruction() {
     return true;
 }
 
-bool StackMachineInterpreter::jumpToBlock(const std::string &methodName) {
-    // Check if block exists
-    if (blocks.find(methodName) == blocks.end()) {
-        std::cerr << "Block not found: " << methodName << std::endl;
+#if defined(__GNUC__) && !defined(NO_THREADED_DISPATCH)
+
+bool StackMachineInterpreter::runThreaded() {
+    // One handler per opcode, in the order of the OpCode enum
+    static void *const handlers[] = {
+        &&op_iload,
+        &&op_iconst,
+        &&op_istore,
+        &&op_iadd,
+        &&op_isub,
+        &&op_imul,
+        &&op_idiv,
+        &&op_ilt,
+        &&op_igt,
+        &&op_ieq,
+        &&op_iand,
+        &&op_ior,
+        &&op_inot,
+        &&op_goto,
+        &&op_iffalsegoto,
+        &&op_invokevirtual,
+        &&op_ireturn,
+        &&op_print,
+        &&op_stop,
+        &&op_newarray,
+        &&op_iaload,
+        &&op_iastore,
+        &&op_arraylength,
+        &&op_new,
+        &&op_getfield,
+        &&op_putfield,
+        &&op_ifne,
+        &&op_if_icmplt,
+        &&op_if_icmpge,
+        &&op_if_icmpgt,
+        &&op_if_icmple,
+        &&op_if_icmpeq,
+        &&op_if_icmpne,
+        &&op_iaload,  // The unchecked forms, whose index is checked all the same
+        &&op_iastore,
+        &&op_iload_iload,
+        &&op_iload_iconst,
+        &&op_iload_getfield,
+        &&op_iadd_istore,
+        &&op_isub_istore,
+        &&op_istore_goto,
+        &&op_iload_iload_iadd,
+        &&op_iload_iconst_iadd_istore,
+        &&op_iload_iconst_isub_istore,
+    };
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == LINKED_OPCODE_COUNT,
+                  "Every opcode needs a threaded handler");
+
+    // Thread the code: each instruction is replaced by the address of its handler
+    std::vector<void *> threadedCode(code.size() + 1);
+    for (size_t i = 0; i < code.size(); i++) {
+        threadedCode[i] = handlers[static_cast<size_t>(code[i].opcode)];
+    }
+    threadedCode[code.size()] = &&out_of_bounds;
+
+#define DISPATCH()                          \
+    do {                                    \
+        dispatchCount++;                    \
+        goto *threadedCode[programCounter]; \
+    } while (0)
+#define NEXT()            \
+    do {                  \
+        programCounter++; \
+        DISPATCH();       \
+    } while (0)
+#define POP_OPERANDS(name)                                    \
+    if (operandStack.size() < 2) {                            \
+        std::cerr << "Stack underflow on " name << std::endl; \
+        return false;                                         \
+    }                                                         \
+    StackValue b = operandStack.back();                       \
+    operandStack.pop_back();                                  \
+    StackValue a = operandStack.back();                       \
+    operandStack.pop_back()
+
+    DISPATCH();
+
+op_iload:
+    operandStack.push_back(frameSlots[framePointer + code[programCounter].operand]);
+    NEXT();
+
+op_iconst:
+    operandStack.push_back(StackValue(code[programCounter].operand, code[programCounter].isBoolean));
+    NEXT();
+
+op_istore:
+    if (operandStack.empty()) {
+        std::cerr << "Stack underflow on ISTORE" << std::endl;
         return false;
     }
+    frameSlots[framePointer + code[programCounter].operand] = operandStack.back();
+    operandStack.pop_back();
+    NEXT();
 
-    currentBlock = methodName;
-    programCounter = 0;
+op_iadd: {
+    POP_OPERANDS("IADD");
+    operandStack.push_back(StackValue(a.value + b.value, false));
+    NEXT();
+}
+
+op_isub: {
+    POP_OPERANDS("ISUB");
+    operandStack.push_back(StackValue(a.value - b.value, false));
+    NEXT();
+}
+
+op_imul: {
+    POP_OPERANDS("IMUL");
+    operandStack.push_back(StackValue(a.value * b.value, false));
+    NEXT();
+}
+
+op_idiv: {
+    if (operandStack.size() < 2) {
+        std::cerr << "Stack underflow on IDIV" << std::endl;
+        return false;
+    }
+    if (operandStack.back().value == 0) {
+        std::cerr << "Division by zero" << std::endl;
+        return false;
+    }
+    POP_OPERANDS("IDIV");
+    operandStack.push_back(StackValue(a.value / b.value, false));
+    NEXT();
+}
+
+op_ilt: {
+    POP_OPERANDS("ILT");
+    operandStack.push_back(StackValue(a.value < b.value ? 1 : 0, true));
+    NEXT();
+}
+
+op_igt: {
+    POP_OPERANDS("IGT");
+    operandStack.push_back(StackValue(a.value > b.value ? 1 : 0, true));
+    NEXT();
+}
+
+op_ieq: {
+    POP_OPERANDS("IEQ");
+    operandStack.push_back(StackValue(a.value == b.value ? 1 : 0, true));
+    NEXT();
+}
+
+op_iand: {
+    POP_OPERANDS("IAND");
+    operandStack.push_back(StackValue((a.value != 0 && b.value != 0) ? 1 : 0, true));
+    NEXT();
+}
+
+op_ior: {
+    POP_OPERANDS("IOR");
+    operandStack.push_back(StackValue((a.value != 0 || b.value != 0) ? 1 : 0, true));
+    NEXT();
+}
+
+op_inot:
+    if (operandStack.empty()) {
+        std::cerr << "Stack underflow on INOT" << std::endl;
+        return false;
+    }
+    operandStack.back() = StackValue(operandStack.back().value == 0 ? 1 : 0, true);
+    NEXT();
+
+op_goto:
+    programCounter = code[programCounter].operand;
+    DISPATCH();
+
+op_iffalsegoto: {
+    if (operandStack.empty()) {
+        std::cerr << "Stack underflow on IFFALSEGOTO" << std::endl;
+        return false;
+    }
+    int condition = operandStack.back().value;
+    operandStack.pop_back();
+    if (condition == 0) {
+        programCounter = code[programCounter].operand;
+        DISPATCH();
+    }
+    NEXT();
+}
+
+op_ifne: {
+    if (operandStack.empty()) {
+        std::cerr << "Stack underflow on IFNE" << std::endl;
+        return false;
+    }
+    int condition = operandStack.back().value;
+    operandStack.pop_back();
+    if (condition != 0) {
+        programCounter = code[programCounter].operand;
+        DISPATCH();
+    }
+    NEXT();
+}
+
+#define COMPARE_AND_JUMP(name, comparison)                 \
+    {                                                      \
+        POP_OPERANDS(name);                                \
+        if (a.value comparison b.value) {                  \
+            programCounter = code[programCounter].operand; \
+            DISPATCH();                                    \
+        }                                                  \
+        NEXT();                                            \
+    }
+
+op_if_icmplt:
+    COMPARE_AND_JUMP("IF_ICMPLT", <)
+op_if_icmpge:
+    COMPARE_AND_JUMP("IF_ICMPGE", >=)
+op_if_icmpgt:
+    COMPARE_AND_JUMP("IF_ICMPGT", >)
+op_if_icmple:
+    COMPARE_AND_JUMP("IF_ICMPLE", <=)
+op_if_icmpeq:
+    COMPARE_AND_JUMP("IF_ICMPEQ", ==)
+op_if_icmpne:
+    COMPARE_AND_JUMP("IF_ICMPNE", !=)
+
+#undef COMPARE_AND_JUMP
+
+op_invokevirtual: {
+    const MethodInfo &callee = methods[code[programCounter].operand];
+    size_t calleeFrame = framePointer + methods[currentMethod].frameSize;
+    if (calleeFrame + callee.frameSize > frameSlots.size()) {
+        frameSlots.resize(std::max(frameSlots.size() * 2, calleeFrame + callee.frameSize));
+    }
+    std::fill_n(frameSlots.begin() + calleeFrame, callee.frameSize, StackValue());
+
+    stackFrame.push_back({programCounter + 1, framePointer, currentMethod});
+    maxCallDepth = std::max(maxCallDepth, stackFrame.size());
+    framePointer = calleeFrame;
+    currentMethod = code[programCounter].operand;
+    programCounter = callee.entry;
+    DISPATCH();
+}
+
+op_ireturn: {
+    if (operandStack.empty()) {
+        std::cerr << "Stack underflow on IRETURN" << std::endl;
+        return false;
+    }
+    if (stackFrame.empty()) {
+        std::cerr << "Call stack underflow on IRETURN" << std::endl;
+        running = false;
+        return false;
+    }
+    const StackFrame &frame = stackFrame.back();
+    programCounter = frame.returnAddress;
+    framePointer = frame.framePointer;
+    currentMethod = frame.method;
+    stackFrame.pop_back();
+    DISPATCH();
+}
+
+op_print: {
+    if (operandStack.empty()) {
+        std::cerr << "Stack underflow on PRINT" << std::endl;
+        return false;
+    }
+    const StackValue &val = operandStack.back();
+    if (val.isBoolean) {
+        std::cout << (val.value == 1 ? "true" : "false") << std::endl;
+    } else {
+        std::cout << val.value << std::endl;
+    }
+    operandStack.pop_back();
+    NEXT();
+}
+
+op_stop:
+    running = false;
+    return true;
+
+op_newarray:
+    if (!newArray()) return false;
+    NEXT();
+
+op_iaload:
+    if (!arrayLoad()) return false;
+    NEXT();
+
+op_iastore:
+    if (!arrayStore()) return false;
+    NEXT();
+
+op_arraylength:
+    if (!arrayLength()) return false;
+    NEXT();
+
+op_new:
+    if (!newObject(code[programCounter].operand)) return false;
+    NEXT();
+
+op_getfield:
+    if (!getField(code[programCounter].operand)) return false;
+    NEXT();
+
+op_putfield:
+    if (!putField(code[programCounter].operand)) return false;
+    NEXT();
+
+op_iload_iload:
+    operandStack.push_back(frameSlots[framePointer + code[programCounter].operand]);
+    operandStack.push_back(frameSlots[framePointer + code[programCounter + 1].operand]);
+    programCounter += 2;
+    DISPATCH();
+
+op_iload_iconst:
+    operandStack.push_back(frameSlots[framePointer + code[programCounter].operand]);
+    operandStack.push_back(StackValue(code[programCounter + 1].operand, code[programCounter + 1].isBoolean));
+    programCounter += 2;
+    DISPATCH();
+
+op_iload_getfield:
+    operandStack.push_back(frameSlots[framePointer + code[programCounter].operand]);
+    programCounter++;
+    if (!getField(code[programCounter].operand)) return false;
+    NEXT();
+
+op_iadd_istore: {
+    POP_OPERANDS("IADD");
+    frameSlots[framePointer + code[programCounter + 1].operand] = StackValue(a.value + b.value, false);
+    programCounter += 2;
+    DISPATCH();
+}
+
+op_isub_istore: {
+    POP_OPERANDS("ISUB");
+    frameSlots[framePointer + code[programCounter + 1].operand] = StackValue(a.value - b.value, false);
+    programCounter += 2;
+    DISPATCH();
+}
+
+op_istore_goto:
+    if (operandStack.empty()) {
+        std::cerr << "Stack underflow on ISTORE" << std::endl;
+        return false;
+    }
+    frameSlots[framePointer + code[programCounter].operand] = operandStack.back();
+    operandStack.pop_back();
+    programCounter = code[programCounter + 1].operand;
+    DISPATCH();
+
+op_iload_iload_iadd: {
+    int a = frameSlots[framePointer + code[programCounter].operand].value;
+    int b = frameSlots[framePointer + code[programCounter + 1].operand].value;
+    operandStack.push_back(StackValue(a + b, false));
+    programCounter += 3;
+    DISPATCH();
+}
+
+op_iload_iconst_iadd_istore: {
+    int a = frameSlots[framePointer + code[programCounter].operand].value;
+    int b = code[programCounter + 1].operand;
+    frameSlots[framePointer + code[programCounter + 3].operand] = StackValue(a + b, false);
+    programCounter += 4;
+    DISPATCH();
+}
+
+op_iload_iconst_isub_istore: {
+    int a = frameSlots[framePointer + code[programCounter].operand].value;
+    int b = code[programCounter + 1].operand;
+    frameSlots[framePointer + code[programCounter + 3].operand] = StackValue(a - b, false);
+    programCounter += 4;
+    DISPATCH();
+}
+
+out_of_bounds:
+    std::cerr << "Program counter out of bounds: " << programCounter << std::endl;
+    running = false;
+    return false;
+
+#undef POP_OPERANDS
+#undef NEXT
+#undef DISPATCH
+}
+
+#else
+
+bool StackMachineInterpreter::runThreaded() {
+    // Labels as values are a GNU extension, other compilers use the switch loop
+    return runSwitch();
+}
+
+#endif
+
+int StackMachineInterpreter::allocate(int size) {
+    if (!heap.canAllocate(size)) collectGarbage();
+    return heap.allocate(size);
+}
+
+void StackMachineInterpreter::collectGarbage() {
+    // Slots above the current frame belong to methods that have returned and hold no live values
+    roots.clear();
+    size_t frameEnd = framePointer + methods[currentMethod].frameSize;
+    for (size_t slot = 0; slot < frameEnd; slot++) {
+        if (frameSlots[slot].isReference) roots.push_back(&frameSlots[slot]);
+    }
+    for (StackValue &value : operandStack) {
+        if (value.isReference) roots.push_back(&value);
+    }
+    heap.collect(roots);
+}
+
+bool StackMachineInterpreter::popReference(const char *opcodeName, int &address) {
+    if (operandStack.empty()) {
+        std::cerr << "Stack underflow on " << opcodeName << std::endl;
+        return false;
+    }
+    StackValue ref = operandStack.back();
+    operandStack.pop_back();
+    if (!ref.isReference || ref.value == 0) {
+        std::cerr << "Null reference on " << opcodeName << std::endl;
+        return false;
+    }
+    address = ref.value;
+    return true;
+}
+
+bool StackMachineInterpreter::newArray() {
+    if (operandStack.empty()) {
+        std::cerr << "Stack underflow on NEWARRAY" << std::endl;
+        return false;
+    }
+    int length = operandStack.back().value;
+    operandStack.pop_back();
+    if (length < 0) {
+        std::cerr << "Negative array size: " << length << std::endl;
+        return false;
+    }
+    int address = allocate(length);
+    if (address == 0) {
+        std::cerr << "Out of memory on NEWARRAY: " << length << std::endl;
+        return false;
+    }
+    operandStack.push_back(StackValue::reference(address));
+    return true;
+}
+
+bool StackMachineInterpreter::arrayLoad() {
+    if (operandStack.size() < 2) {
+        std::cerr << "Stack underflow on IALOAD" << std::endl;
+        return false;
+    }
+    int index = operandStack.back().value;
+    operandStack.pop_back();
+    int address;
+    if (!popReference("IALOAD", address)) return false;
+    if (static_cast<uint32_t>(index) >= static_cast<uint32_t>(heap.sizeOf(address))) {
+        std::cerr << "Array index out of bounds: " << index << std::endl;
+        return false;
+    }
+    operandStack.push_back(heap.load(address, index));
+    return true;
+}
+
+bool StackMachineInterpreter::arrayStore() {
+    if (operandStack.size() < 3) {
+        std::cerr << "Stack underflow on IASTORE" << std::endl;
+        return false;
+    }
+    StackValue value = operandStack.back();
+    operandStack.pop_back();
+    int index = operandStack.back().value;
+    operandStack.pop_back();
+    int address;
+    if (!popReference("IASTORE", address)) return false;
+    if (static_cast<uint32_t>(index) >= static_cast<uint32_t>(heap.sizeOf(address))) {
+        std::cerr << "Array index out of bounds: " << index << std::endl;
+        return false;
+    }
+    heap.store(address, index, value);
+    return true;
+}
+
+bool StackMachineInterpreter::arrayLength() {
+    int address;
+    if (!popReference("ARRAYLENGTH", address)) return false;
+    operandStack.push_back(StackValue(heap.sizeOf(address)));
+    return true;
+}
+
+bool StackMachineInterpreter::newObject(int layout) {
+    const ObjectLayout &objectLayout = layouts[layout];
+    int address = allocate(objectLayout.fieldCount);
+    if (address == 0) {
+        std::cerr << "Out of memory on NEW" << std::endl;
+        return false;
+    }
+    for (int field : objectLayout.booleanFields) heap.store(address, field, StackValue(0, true));
+    operandStack.push_back(StackValue::reference(address));
+    return true;
+}
+
+bool StackMachineInterpreter::getField(int field) {
+    int address;
+    if (!popReference("GETFIELD", address)) return false;
+    if (field < 0 || field >= heap.sizeOf(address)) {
+        std::cerr << "Field index out of bounds on GETFIELD: " << field << std::endl;
+        return false;
+    }
+    operandStack.push_back(heap.load(address, field));
+    return true;
+}
+
+bool StackMachineInterpreter::putField(int field) {
+    if (operandStack.size() < 2) {
+        std::cerr << "Stack underflow on PUTFIELD" << std::endl;
+        return false;
+    }
+    StackValue value = operandStack.back();
+    operandStack.pop_back();
+    int address;
+    if (!popReference("PUTFIELD", address)) return false;
+    if (field < 0 || field >= heap.sizeOf(address)) {
+        std::cerr << "Field index out of bounds on PUTFIELD: " << field << std::endl;
+        return false;
+    }
+    heap.store(address, field, value);
     return true;
 }
 
 void StackMachineInterpreter::reset() {
     // Clear runtime state
-    while (!operandStack.empty()) operandStack.pop();
-    while (!stackFrame.empty()) stackFrame.pop();
-    localVariables.clear();
-    currentBlock = "";
+    heap.reset();
+    operandStack.clear();
+    stackFrame.clear();
+    frameSlots.clear();
+    framePointer = 0;
+    currentMethod = 0;
     programCounter = 0;
     running = false;
+    dispatchCount = 0;
+    maxCallDepth = 0;
+    pairCounts.clear();
+    tripleCounts.clear();
+    sequenceLength = 0;
 }
 
 StackValue StackMachineInterpreter::getVariable(const std::string &name) const {
-    auto it = localVariables.find(name);
-    if (it == localVariables.end()) {
+    if (methods.empty() || frameSlots.empty()) return StackValue(0);
+
+    // Looks the variable up in the frame of the method that is currently executing
+    const auto &slots = methods[currentMethod].slots;
+    auto it = slots.find(name);
+    if (it == slots.end()) {
         return StackValue(0);  // Default value for undefined variables
     }
-    return it->second;
+    return frameSlots[framePointer + it->second];
 }
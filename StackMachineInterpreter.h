@@ -3,47 +3,276 @@
 
 #include <fstream>
 #include <iostream>
-#include <map>
 #include <memory>
-#include <stack>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "BytecodeGenerator.h"
+#include "Heap.h"
+#include "JitCompiler.h"
 
-struct StackValue {
-    int value;
-    bool isBoolean;
+// A pre-resolved instruction. The meaning of the operand depends on the opcode:
+// ILOAD/ISTORE hold a slot in the current frame, ICONST holds the constant itself,
+// jumps hold the absolute address of the target block, INVOKEVIRTUAL
+// holds the index of the called method, NEW the index of the layout of the object and
+// GETFIELD/PUTFIELD the index of the field. A superinstruction replaces only the opcode
+// of the first instruction of its sequence and reads the operands of the rest, which stay
+// in place so that jumps into the middle of the sequence still work.
+struct Instruction {
+    OpCode opcode;
+    bool isBoolean;  // Constant is a boolean literal (ICONST only)
+    int operand;
 
-    StackValue() : value(0), isBoolean(false) {}
-    StackValue(int v, bool b = false) : value(v), isBoolean(b) {}
+    Instruction(OpCode opcode, int operand = 0, bool isBoolean = false)
+        : opcode(opcode), isBoolean(isBoolean), operand(operand) {}
 };
 
+// A block of the program as read from the bytecode file, before linking.
+struct BytecodeBlock {
+    std::string name;
+    std::vector<std::pair<OpCode, std::string>> instructions;
+};
+
+// Location of a linked block within the flat instruction array.
+struct BlockInfo {
+    std::string name;
+    size_t start;
+};
+
+// A method of the linked program with the layout of its frame.
+struct MethodInfo {
+    std::string name;
+    size_t entry;
+    int frameSize;
+    std::unordered_map<std::string, int> slots;
+};
+
+// The layout of the objects a NEW instruction allocates. Boolean fields start out as false rather than 0.
+struct ObjectLayout {
+    int fieldCount;
+    std::vector<int> booleanFields;
+};
+
+// Hotness counter and native code of a block, used by the JIT engine.
+struct JitBlockState {
+    int entries = 0;
+    bool failed = false;  // Compilation was attempted and not possible
+    CompiledBlock compiled;
+};
+
+// Saved caller state. The caller's variables stay in place on the frame stack.
 struct StackFrame {
-    std::string method;
     size_t returnAddress;
-    std::unordered_map<std::string, StackValue> localVariables;
+    size_t framePointer;
+    size_t method;
 };
 
 class StackMachineInterpreter {
    private:
     // Program structure
-    std::map<std::string, std::vector<std::pair<OpCode, std::string>>> blocks;
+    std::vector<Instruction> code;
+    std::vector<BlockInfo> blocks;
+    std::vector<MethodInfo> methods;
+    std::unordered_map<std::string, int> variableIds;
+    std::vector<std::string> variableNames;
+    std::unordered_map<std::string, int> layoutIds;
+    std::vector<ObjectLayout> layouts;
 
     // Runtime state
-    std::stack<StackValue> operandStack;
-    std::stack<StackFrame> stackFrame;
-    std::unordered_map<std::string, StackValue> localVariables;
-    std::string currentBlock;
+    std::vector<StackValue> operandStack;
+    std::vector<StackFrame> stackFrame;
+    std::vector<StackValue> frameSlots;
+    size_t framePointer;
+    size_t currentMethod;
     size_t programCounter;
     bool running;
+    bool threadedDispatch;
+    bool jitEnabled;
+    int jitThreshold;
+    bool printStats;
+    uint64_t dispatchCount;  // Instructions dispatched plus native blocks entered, for the statistics
+    size_t maxCallDepth;     // Deepest the frame stack grew, for the statistics
+
+    // Superinstructions replacing common opcode sequences, formed when the program is loaded
+    bool useSuperinstructions;
+    int superinstructionCount;
+
+    // Opcode profile: how often each pair and triple of opcodes ran back to back at consecutive addresses
+    bool profiling;
+    std::vector<uint64_t> pairCounts;
+    std::vector<uint64_t> tripleCounts;
+    size_t previousAddress;
+    int sequenceLength;  // Instructions of the current straight-line run seen so far, up to 2
+    OpCode previousOpcodes[2];
+
+    // JIT state: the block starting at each address or -1, and the state of every block
+    JitCompiler jit;
+    std::vector<int> blockStarts;
+    std::vector<JitBlockState> jitBlocks;
+
+    // Garbage-collected heap for objects and arrays, and a reusable buffer for its roots
+    Heap heap;
+    std::vector<StackValue *> roots;
+
+    /**
+     * @brief Links the parsed blocks into the flat instruction array
+     * @param parsedBlocks The blocks in the order they appear in the bytecode file
+     * @return True if every block, variable and constant could be resolved
+     */
+    bool link(const std::vector<BytecodeBlock> &parsedBlocks);
+
+    /**
+     * @brief Maps a binary bytecode file into memory and links it
+     * @param filename The file containing the binary bytecode
+     * @return True if loading was successful
+     */
+    bool loadBinaryBytecode(const std::string &filename);
+
+    /**
+     * @brief Links a binary bytecode image into the flat instruction array
+     * @param data The contents of the file
+     * @param size The size of the file in bytes
+     * @return True if the image is well formed and could be resolved
+     */
+    bool linkBinary(const char *data, size_t size);
+
+    /**
+     * @brief Splits the linked program into methods and lays out their frames
+     *
+     * Methods start at the entry point and at every call target, and own the blocks reachable from there.
+     * Variables are renumbered to slots within their method's frame and calls to method indices.
+     *
+     * @return True if the linked program is runnable
+     */
+    bool resolveMethods();
+
+    /**
+     * @brief Gets the program-wide id for a variable name, allocating a new one if needed
+     * @param name The name of the variable
+     * @return The id of the variable
+     */
+    int getVariableId(const std::string &name);
+
+    /**
+     * @brief Gets the id of an object layout, one character per field: Z for a boolean, I for anything else
+     * @param descriptor The layout as written in the bytecode
+     * @return The id of the layout, or -1 if the descriptor is malformed
+     */
+    int getLayoutId(const std::string &descriptor);
+
+    /**
+     * @brief Gets the index of the block containing an address
+     * @param address The address in the flat instruction array
+     * @return The index of the block the address belongs to
+     */
+    size_t blockIndexAt(size_t address) const;
+
+    /**
+     * @brief Runs the program with a switch over the opcode of each instruction
+     * @return False if execution stopped because of an error
+     */
+    bool runSwitch();
+
+    /**
+     * @brief Runs the program with direct-threaded dispatch, jumping straight from handler to handler
+     *
+     * Uses GCC labels as values. Falls back to runSwitch when they are unavailable or when the
+     * interpreter is built with NO_THREADED_DISPATCH.
+     *
+     * @return False if execution stopped because of an error
+     */
+    bool runThreaded();
+
+    /**
+     * @brief Runs the program with the switch loop, compiling blocks to native code once they are hot
+     *
+     * Blocks are counted every time execution reaches their first instruction. Once a block has been
+     * entered jitThreshold times its start is compiled, and from then on runs natively up to the first
+     * instruction the JIT does not support.
+     *
+     * @return False if execution stopped because of an error
+     */
+    bool runJit();
+
+    /**
+     * @brief Allocates a zeroed object or array on the heap, collecting garbage first if it is full
+     * @param size The number of payload words
+     * @return The address of the allocation, or 0 when the heap is out of memory
+     */
+    int allocate(int size);
+
+    /**
+     * @brief Runs the garbage collector with the live frame slots and the operand stack as roots
+     */
+    void collectGarbage();
+
+    /**
+     * @brief Pops a reference from the operand stack, checking that it is not null
+     * @param opcodeName The instruction using the reference, for error messages
+     * @param address Receives the heap address
+     * @return False if the stack was empty or the reference null
+     */
+    bool popReference(const char *opcodeName, int &address);
+
+    // Heap instructions shared by both execution engines. Each returns false on a runtime error. Array accesses
+    // always check the index: a bytecode file may come from anywhere, so its unchecked accesses are not trusted.
+    bool newArray();
+    bool arrayLoad();
+    bool arrayStore();
+    bool arrayLength();
+    bool newObject(int layout);
+    bool getField(int field);
+    bool putField(int field);
+
+    /**
+     * @brief Gets the block containing an address
+     * @param address The address in the flat instruction array
+     * @return The block the address belongs to
+     */
+    const BlockInfo &blockAt(size_t address) const;
+
+    /**
+     * @brief Replaces common opcode sequences with superinstructions
+     *
+     * Sequences are matched greedily from the start of the program, preferring the longest. Only the
+     * first opcode of a sequence is replaced, so addresses and jump targets do not change.
+     */
+    void formSuperinstructions();
+
+    /**
+     * @brief Counts the pair and triple of opcodes ending at the instruction about to execute
+     */
+    void recordProfile();
+
+    /**
+     * @brief Prints the most frequent opcode pairs and triples to stderr
+     */
+    void printProfile() const;
 
    public:
-    StackMachineInterpreter() : programCounter(0), running(false) {}
+    // Number of entries after which a block is compiled
+    static const int DEFAULT_JIT_THRESHOLD = 100;
+
+    StackMachineInterpreter()
+        : framePointer(0),
+          currentMethod(0),
+          programCounter(0),
+          running(false),
+          threadedDispatch(false),
+          jitEnabled(false),
+          jitThreshold(DEFAULT_JIT_THRESHOLD),
+          printStats(false),
+          dispatchCount(0),
+          maxCallDepth(0),
+          useSuperinstructions(true),
+          superinstructionCount(0),
+          profiling(false),
+          previousAddress(0),
+          sequenceLength(0) {}
 
     /**
-     * @brief Loads bytecode from a file
+     * @brief Loads text or binary bytecode from a file and links it
      * @param filename The file containing the bytecode
      * @return True if loading was successful
      */
@@ -56,17 +285,46 @@ class StackMachineInterpreter {
     int execute();
 
     /**
-     * @brief Executes a single instruction
-     * @return True if execution should continue
+     * @brief Selects the execution engine used by execute
+     * @param threaded True for direct-threaded dispatch, false for the switch loop
      */
-    bool executeInstruction();
+    void setThreadedDispatch(bool threaded) { threadedDispatch = threaded; }
 
     /**
-     * @brief Jumps to a block
-     * @param blockName The name of the method to jump to
-     * @return True if the jump was successful
+     * @brief Selects the JIT engine, which takes precedence over the dispatch setting
+     * @param enabled True to compile hot blocks to native code
+     * @param threshold The number of entries after which a block is compiled
+     * @return False if native code is not supported on this platform
      */
-    bool jumpToBlock(const std::string &blockName);
+    bool setJit(bool enabled, int threshold = DEFAULT_JIT_THRESHOLD);
+
+    /**
+     * @brief Enables printing dispatch, garbage collector and JIT statistics to stderr after execution
+     * @param enabled True to print the statistics
+     */
+    void setPrintStats(bool enabled) { printStats = enabled; }
+
+    /**
+     * @brief Enables superinstructions, formed when the program is loaded unless the JIT is enabled
+     * @param enabled True to form superinstructions
+     */
+    void setSuperinstructions(bool enabled) { useSuperinstructions = enabled; }
+
+    /**
+     * @brief Enables profiling opcode pairs and triples, printed to stderr after execution
+     *
+     * Profiling runs the plain opcodes in the switch loop, whatever engine was selected, so that the
+     * counts show which sequences are worth turning into superinstructions.
+     *
+     * @param enabled True to profile
+     */
+    void setProfiling(bool enabled) { profiling = enabled; }
+
+    /**
+     * @brief Executes a single instruction
+     * @return True if execution should continue
+     */
+    bool executeInstruction();
 
     /**
      * @brief Resets the interpreter state
@@ -74,7 +332,7 @@ class StackMachineInterpreter {
     void reset();
 
     /**
-     * @brief Gets the value of a local variable
+     * @brief Gets the value of a local variable in the current frame
      * @param name The name of the variable
      * @return The value of the variable
      */
@@ -0,0 +1,450 @@
+#include "StaticSingleAssignment.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+namespace {
+
+// The arguments of these operators name a class or a method rather than a value
+bool hasNameArguments(Symbol op) { return op == tac::NEW || op == tac::CALL; }
+
+// Field accesses through an object, whose field argument names the field as Class.field
+bool isFieldAccess(Symbol op) { return op == tac::LOAD_FIELD || op == tac::STORE_FIELD; }
+
+}  // namespace
+
+DominatorTree::DominatorTree(const std::vector<std::vector<int>> &successors, int entry) {
+    size_t size = successors.size();
+    immediateDominators.assign(size, -1);
+    children.assign(size, {});
+    frontiers.assign(size, {});
+    postorderNumbers.assign(size, -1);
+
+    // Depth-first search with an explicit stack, since methods can have long chains of blocks
+    std::vector<int> postorder;
+    std::vector<bool> visited(size, false);
+    std::vector<std::pair<int, size_t>> stack = {{entry, 0}};
+    visited[entry] = true;
+    while (!stack.empty()) {
+        int node = stack.back().first;
+        size_t next = stack.back().second++;
+        if (next < successors[node].size()) {
+            int successor = successors[node][next];
+            if (!visited[successor]) {
+                visited[successor] = true;
+                stack.push_back({successor, 0});
+            }
+        } else {
+            postorderNumbers[node] = postorder.size();
+            postorder.push_back(node);
+            stack.pop_back();
+        }
+    }
+    reversePostorder.assign(postorder.rbegin(), postorder.rend());
+
+    std::vector<std::vector<int>> predecessors(size);
+    for (int node : reversePostorder) {
+        for (int successor : successors[node]) predecessors[successor].push_back(node);
+    }
+
+    // Walk up from two nodes until they meet, using postorder numbers to tell which one is deeper
+    auto intersect = [&](int a, int b) {
+        while (a != b) {
+            while (postorderNumbers[a] < postorderNumbers[b]) a = immediateDominators[a];
+            while (postorderNumbers[b] < postorderNumbers[a]) b = immediateDominators[b];
+        }
+        return a;
+    };
+
+    immediateDominators[entry] = entry;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int node : reversePostorder) {
+            if (node == entry) continue;
+            int dominator = -1;
+            for (int predecessor : predecessors[node]) {
+                if (immediateDominators[predecessor] < 0) continue;
+                dominator = dominator < 0 ? predecessor : intersect(predecessor, dominator);
+            }
+            if (dominator != immediateDominators[node]) {
+                immediateDominators[node] = dominator;
+                changed = true;
+            }
+        }
+    }
+    immediateDominators[entry] = -1;
+
+    for (int node : reversePostorder) {
+        if (node != entry) children[immediateDominators[node]].push_back(node);
+    }
+
+    // A join is in the frontier of every node between each predecessor and the join's immediate dominator
+    for (int node : reversePostorder) {
+        if (predecessors[node].size() < 2) continue;
+        for (int runner : predecessors[node]) {
+            while (runner != -1 && runner != immediateDominators[node]) {
+                if (std::find(frontiers[runner].begin(), frontiers[runner].end(), node) == frontiers[runner].end()) {
+                    frontiers[runner].push_back(node);
+                }
+                runner = immediateDominators[runner];
+            }
+        }
+    }
+}
+
+bool DominatorTree::dominates(int dominator, int node) const {
+    if (!isReachable(node)) return false;
+    for (; node != -1; node = immediateDominators[node]) {
+        if (node == dominator) return true;
+    }
+    return false;
+}
+
+bool SSAInstruction::definesResult() const {
+    return op != tac::STORE_INDEX && op != tac::STORE_INDEX_UNCHECKED && op != tac::STORE_FIELD && op != tac::PARAM &&
+           op != tac::PRINT && op != tac::IF && op != tac::RETURN;
+}
+
+void SSAInstruction::forEachUse(const std::function<void(SSAOperand &)> &visit) {
+    if (op == tac::PHI) {
+        for (auto &operand : incoming) visit(operand.second);
+        return;
+    }
+    if (op == tac::STORE_INDEX || op == tac::STORE_INDEX_UNCHECKED || op == tac::STORE_FIELD) visit(result);
+    if (hasNameArguments(op)) return;
+    if (isFieldAccess(op)) {
+        visit(op == tac::LOAD_FIELD ? arg1 : arg2);
+        return;
+    }
+    if (arg1.isValue() || !arg1.name.empty()) visit(arg1);
+    if (arg2.isValue() || !arg2.name.empty()) visit(arg2);
+}
+
+bool SSAInstruction::isPure() const {
+    // Array accesses and allocations can fail at run time, so only object allocation is pure
+    static const std::unordered_set<Symbol> pureOperators = {tac::ADD, tac::SUB, tac::MUL, tac::LESS,
+                                                             tac::GREATER, tac::EQUAL, tac::AND, tac::OR,
+                                                             tac::NOT, Symbol(), tac::NEW, tac::PHI};
+    return result.isValue() && pureOperators.count(op);
+}
+
+bool SSAFunction::isLiteral(Symbol name) {
+    if (name == tac::TRUE_LITERAL || name == tac::FALSE_LITERAL) return true;
+    const std::string &text = name.str();
+    size_t digits = !text.empty() && text[0] == '-' ? 1 : 0;
+    return text.size() > digits && text.find_first_not_of("0123456789", digits) == std::string::npos;
+}
+
+SSAFunction::SSAFunction(const std::vector<BasicBlock *> &methodBlocks, const Method *method)
+    : entry(0), nextTemporary(0) {
+    if (method) {
+        for (const auto &parameter : method->getParameters()) variables.insert(parameter.getName());
+        for (const auto &local : method->getLocalVariables()) variables.insert(local.first.getName());
+    }
+
+    std::unordered_map<const BasicBlock *, int> indices;
+    for (size_t i = 0; i < methodBlocks.size(); i++) {
+        indices[methodBlocks[i]] = i;
+        if (methodBlocks[i]->name == methodBlocks[i]->method) entry = i;
+    }
+    auto indexOf = [&](const BasicBlock *block) {
+        auto it = indices.find(block);
+        return it == indices.end() ? -1 : it->second;
+    };
+
+    for (BasicBlock *basicBlock : methodBlocks) {
+        SSABlock block;
+        block.block = basicBlock;
+        block.trueExit = indexOf(basicBlock->trueExit);
+        block.falseExit = indexOf(basicBlock->falseExit);
+        for (const auto &tacInst : basicBlock->getTacInstructions()) {
+            SSAInstruction instruction;
+            instruction.op = tacInst.op;
+            instruction.result.name = tacInst.result;
+            instruction.arg1.name = tacInst.arg1;
+            instruction.arg2.name = tacInst.arg2;
+            block.instructions.push_back(std::move(instruction));
+
+            // Fresh temporaries are numbered after the highest temporary of the method
+            for (Symbol name : {tacInst.result, tacInst.arg1, tacInst.arg2}) {
+                if (isTemporary(name)) nextTemporary = std::max(nextTemporary, std::atoi(name.c_str() + 2) + 1);
+            }
+        }
+        blocks.push_back(std::move(block));
+    }
+
+    removeUnreachableBlocks();
+    placePhis();
+    rename();
+}
+
+bool SSAFunction::isVariable(Symbol name) const { return isTemporary(name) || variables.count(name); }
+
+int SSAFunction::newValue(Symbol variable, bool isEntry) {
+    SSAValue value;
+    value.variable = variable;
+    value.isEntry = isEntry;
+    values.push_back(value);
+    return values.size() - 1;
+}
+
+std::vector<std::vector<int>> SSAFunction::getSuccessors() const {
+    std::vector<std::vector<int>> successors(blocks.size());
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (blocks[i].removed) continue;
+        for (int exit : {blocks[i].trueExit, blocks[i].falseExit}) {
+            if (exit >= 0 && std::find(successors[i].begin(), successors[i].end(), exit) == successors[i].end()) {
+                successors[i].push_back(exit);
+            }
+        }
+    }
+    return successors;
+}
+
+void SSAFunction::computePredecessors() {
+    std::vector<std::vector<int>> successors = getSuccessors();
+    for (auto &block : blocks) block.predecessors.clear();
+    for (size_t i = 0; i < blocks.size(); i++) {
+        for (int successor : successors[i]) blocks[successor].predecessors.push_back(i);
+    }
+}
+
+int SSAFunction::removeUnreachableBlocks() {
+    dominatorTree = DominatorTree(getSuccessors(), entry);
+    int removedBlocks = 0;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (blocks[i].removed || dominatorTree.isReachable(i)) continue;
+        blocks[i].removed = true;
+        blocks[i].instructions.clear();
+        removedBlocks++;
+    }
+    computePredecessors();
+
+    for (auto &block : blocks) {
+        for (auto &instruction : block.instructions) {
+            if (instruction.op != tac::PHI) break;
+            auto &incoming = instruction.incoming;
+            incoming.erase(std::remove_if(incoming.begin(), incoming.end(),
+                                          [&](const std::pair<int, SSAOperand> &operand) {
+                                              return std::find(block.predecessors.begin(), block.predecessors.end(),
+                                                               operand.first) == block.predecessors.end();
+                                          }),
+                           incoming.end());
+        }
+    }
+    return removedBlocks;
+}
+
+int SSAFunction::addPreheader(int target, const std::vector<int> &predecessors) {
+    int index = blocks.size();
+    auto redirected = [&](int block) {
+        return std::find(predecessors.begin(), predecessors.end(), block) != predecessors.end();
+    };
+    for (int predecessor : predecessors) {
+        if (blocks[predecessor].trueExit == target) blocks[predecessor].trueExit = index;
+        if (blocks[predecessor].falseExit == target) blocks[predecessor].falseExit = index;
+    }
+
+    SSABlock preheader;
+    preheader.block = new BasicBlock();
+    preheader.block->method = blocks[target].block->method;
+    preheader.trueExit = target;
+    preheader.placedBefore = target;
+    for (auto &phi : blocks[target].instructions) {
+        if (phi.op != tac::PHI) break;
+        SSAInstruction merged;
+        merged.op = tac::PHI;
+        merged.result.name = phi.result.name;
+        std::vector<std::pair<int, SSAOperand>> kept;
+        for (const auto &operand : phi.incoming) {
+            (redirected(operand.first) ? merged.incoming : kept).push_back(operand);
+        }
+        if (merged.incoming.empty()) continue;
+
+        // A single operand flows through as it is
+        if (merged.incoming.size() == 1) {
+            kept.emplace_back(index, merged.incoming.front().second);
+        } else {
+            merged.result.value = newValue(values[phi.result.value].variable, false);
+            kept.emplace_back(index, merged.result);
+            preheader.instructions.push_back(std::move(merged));
+        }
+        phi.incoming = std::move(kept);
+    }
+    blocks.push_back(std::move(preheader));
+    removeUnreachableBlocks();
+    return index;
+}
+
+int SSAFunction::newTemporary() { return newValue(Symbol("_t" + std::to_string(nextTemporary++)), false); }
+
+void SSAFunction::placePhis() {
+    // Only variables read in a block before being written there can need a phi
+    std::unordered_set<Symbol> globals;
+    std::unordered_map<Symbol, std::vector<int>> definingBlocks;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        std::unordered_set<Symbol> written;
+        for (auto &instruction : blocks[i].instructions) {
+            instruction.forEachUse([&](SSAOperand &operand) {
+                if (isVariable(operand.name) && !written.count(operand.name)) globals.insert(operand.name);
+            });
+            Symbol name = instruction.result.name;
+            if (instruction.definesResult() && isVariable(name) && written.insert(name).second) {
+                definingBlocks[name].push_back(i);
+            }
+        }
+    }
+
+    // Place phis on the iterated dominance frontier of the blocks defining each variable, in the order of their names
+    std::vector<Symbol> ordered(globals.begin(), globals.end());
+    std::sort(ordered.begin(), ordered.end(), [](Symbol a, Symbol b) { return a.str() < b.str(); });
+    for (Symbol variable : ordered) {
+        std::vector<int> worklist = definingBlocks[variable];
+        std::set<int> defined(worklist.begin(), worklist.end());
+        std::set<int> hasPhi;
+        while (!worklist.empty()) {
+            int block = worklist.back();
+            worklist.pop_back();
+            for (int frontier : dominatorTree.getFrontier(block)) {
+                if (!hasPhi.insert(frontier).second) continue;
+                SSAInstruction phi;
+                phi.op = tac::PHI;
+                phi.result.name = variable;
+                for (int predecessor : blocks[frontier].predecessors) {
+                    SSAOperand operand;
+                    operand.name = variable;
+                    phi.incoming.emplace_back(predecessor, operand);
+                }
+                blocks[frontier].instructions.insert(blocks[frontier].instructions.begin(), std::move(phi));
+                if (defined.insert(frontier).second) worklist.push_back(frontier);
+            }
+        }
+    }
+}
+
+void SSAFunction::rename() {
+    std::unordered_map<Symbol, std::vector<int>> stacks;
+    std::unordered_map<Symbol, int> entryValues;
+    auto current = [&](Symbol variable) {
+        auto &stack = stacks[variable];
+        if (!stack.empty()) return stack.back();
+        auto it = entryValues.find(variable);
+        if (it == entryValues.end()) it = entryValues.emplace(variable, newValue(variable, true)).first;
+        return it->second;
+    };
+
+    // Visit the dominator tree, so every read sees the definitions of the blocks dominating it
+    std::function<void(int)> visit = [&](int index) {
+        SSABlock &block = blocks[index];
+        std::vector<Symbol> pushed;
+        for (auto &instruction : block.instructions) {
+            if (instruction.op != tac::PHI) {
+                instruction.forEachUse([&](SSAOperand &operand) {
+                    if (isVariable(operand.name)) operand.value = current(operand.name);
+                });
+            }
+            if (instruction.definesResult() && isVariable(instruction.result.name)) {
+                instruction.result.value = newValue(instruction.result.name, false);
+                stacks[instruction.result.name].push_back(instruction.result.value);
+                pushed.push_back(instruction.result.name);
+            }
+        }
+
+        for (int successor : {block.trueExit, block.falseExit}) {
+            if (successor < 0) continue;
+            for (auto &instruction : blocks[successor].instructions) {
+                if (instruction.op != tac::PHI) break;
+                for (auto &operand : instruction.incoming) {
+                    if (operand.first == index) operand.second.value = current(operand.second.name);
+                }
+            }
+        }
+
+        for (int child : dominatorTree.getChildren(index)) visit(child);
+        for (Symbol name : pushed) stacks[name].pop_back();
+    };
+    visit(entry);
+}
+
+std::vector<BasicBlock *> SSAFunction::lower() {
+    std::vector<Symbol> names(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        bool ownName = values[i].needsName && !values[i].isEntry;
+        names[i] = ownName ? Symbol("_t" + std::to_string(nextTemporary++)) : values[i].variable;
+    }
+    auto nameOf = [&](const SSAOperand &operand) { return operand.isValue() ? names[operand.value] : operand.name; };
+
+    // Phis whose operands ended up with other names become copies on the incoming edges
+    std::map<std::pair<int, int>, std::vector<std::pair<Symbol, Symbol>>> edgeCopies;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        for (const auto &instruction : blocks[i].instructions) {
+            if (instruction.op != tac::PHI) break;
+            Symbol destination = nameOf(instruction.result);
+            for (const auto &operand : instruction.incoming) {
+                Symbol source = nameOf(operand.second);
+                if (source != destination) edgeCopies[{operand.first, i}].emplace_back(destination, source);
+            }
+        }
+    }
+
+    // Copies on an edge out of a branching block need a block of their own, laid out before the target
+    std::map<std::pair<int, int>, BasicBlock *> splitBlocks;
+    std::map<int, std::vector<BasicBlock *>> layoutBefore;
+    for (const auto &edge : edgeCopies) {
+        SSABlock &predecessor = blocks[edge.first.first];
+        if (predecessor.falseExit < 0) continue;
+        BasicBlock *split = new BasicBlock();
+        split->method = predecessor.block->method;
+        split->trueExit = blocks[edge.first.second].block;
+        for (const auto &copy : edge.second) split->addInstruction(copy.first, copy.second, Symbol(), Symbol());
+        splitBlocks[edge.first] = split;
+        layoutBefore[edge.first.second].push_back(split);
+    }
+    auto exitBlock = [&](int from, int to) -> BasicBlock * {
+        if (to < 0) return nullptr;
+        auto it = splitBlocks.find({from, to});
+        return it != splitBlocks.end() ? it->second : blocks[to].block;
+    };
+
+    // Blocks added by passes go right before the block they were placed before, in the order they were added
+    std::map<int, std::vector<int>> placedBefore;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (blocks[i].placedBefore >= 0) placedBefore[blocks[i].placedBefore].push_back(i);
+    }
+    std::vector<int> order;
+    std::function<void(int)> place = [&](int index) {
+        for (int added : placedBefore[index]) place(added);
+        order.push_back(index);
+    };
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (blocks[i].placedBefore < 0) place(i);
+    }
+
+    std::vector<BasicBlock *> layout;
+    for (int i : order) {
+        SSABlock &block = blocks[i];
+        if (block.removed) continue;
+        layout.insert(layout.end(), layoutBefore[i].begin(), layoutBefore[i].end());
+        layout.push_back(block.block);
+
+        BasicBlock *basicBlock = block.block;
+        basicBlock->clearInstructions();
+        for (const auto &instruction : block.instructions) {
+            if (instruction.op == tac::PHI) continue;
+            basicBlock->addInstruction(nameOf(instruction.result), nameOf(instruction.arg1), instruction.op,
+                                       nameOf(instruction.arg2));
+        }
+        if (block.falseExit < 0 && block.trueExit >= 0) {
+            for (const auto &copy : edgeCopies[{i, block.trueExit}]) {
+                basicBlock->addInstruction(copy.first, copy.second, Symbol(), Symbol());
+            }
+        }
+        basicBlock->trueExit = exitBlock(i, block.trueExit);
+        basicBlock->falseExit = exitBlock(i, block.falseExit);
+    }
+    return layout;
+}
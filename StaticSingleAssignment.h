@@ -0,0 +1,224 @@
+#ifndef STATICSINGLEASSIGNMENT_H
+#define STATICSINGLEASSIGNMENT_H
+
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "IntermediateRepresentation.h"
+#include "SymbolTable.h"
+
+/*
+ * Dominator tree of a graph given as successor lists, computed with the iterative algorithm of Cooper, Harvey
+ * and Kennedy. Nodes that cannot be reached from the entry have no dominator and are not part of the tree.
+ */
+class DominatorTree {
+   public:
+    DominatorTree() {}
+
+    /**
+     * @brief Computes the dominator tree and dominance frontiers of a graph.
+     * @param successors The successors of every node.
+     * @param entry The node the graph is entered through.
+     */
+    DominatorTree(const std::vector<std::vector<int>> &successors, int entry);
+
+    /**
+     * @brief Gets the immediate dominator of a node.
+     * @param node The node.
+     * @return The immediate dominator, or -1 for the entry and unreachable nodes.
+     */
+    int getImmediateDominator(int node) const { return immediateDominators[node]; }
+
+    /**
+     * @brief Gets the nodes a node immediately dominates.
+     * @param node The node.
+     * @return The children of the node in the dominator tree.
+     */
+    const std::vector<int> &getChildren(int node) const { return children[node]; }
+
+    /**
+     * @brief Gets the dominance frontier of a node, where its dominance ends.
+     * @param node The node.
+     * @return The nodes in the dominance frontier.
+     */
+    const std::vector<int> &getFrontier(int node) const { return frontiers[node]; }
+
+    /**
+     * @brief Gets the reachable nodes in reverse postorder, so every node comes after its dominators.
+     * @return The nodes in reverse postorder.
+     */
+    const std::vector<int> &getReversePostorder() const { return reversePostorder; }
+
+    /**
+     * @brief Checks if a node can be reached from the entry.
+     * @param node The node.
+     * @return True if the node is reachable.
+     */
+    bool isReachable(int node) const { return postorderNumbers[node] >= 0; }
+
+    /**
+     * @brief Checks if every path from the entry to a node passes through another node.
+     * @param dominator The node that may dominate.
+     * @param node The node that may be dominated.
+     * @return True if dominator dominates node, which includes dominator == node.
+     */
+    bool dominates(int dominator, int node) const;
+
+   private:
+    std::vector<int> immediateDominators;
+    std::vector<std::vector<int>> children;
+    std::vector<std::vector<int>> frontiers;
+    std::vector<int> reversePostorder;
+    std::vector<int> postorderNumbers;
+};
+
+// An operand of an SSA instruction: an SSA value, or a name that is never renamed such as a literal or a field
+struct SSAOperand {
+    int value = -1;    // The SSA value read or written, or -1
+    Symbol name;       // The name, used when value is -1
+
+    bool isValue() const { return value >= 0; }
+};
+
+// A TAC instruction in SSA form. Phi instructions take one operand per predecessor of their block.
+struct SSAInstruction {
+    Symbol op;  // TAC operator, or "phi"
+    SSAOperand result;
+    SSAOperand arg1;
+    SSAOperand arg2;
+    std::vector<std::pair<int, SSAOperand>> incoming;  // Phi operands by predecessor block
+
+    /**
+     * @brief Checks if the instruction writes its result, as opposed to reading it like an array store.
+     * @return True if the result is a definition.
+     */
+    bool definesResult() const;
+
+    /**
+     * @brief Gets the SSA value the instruction defines.
+     * @return The value, or -1 if the instruction defines none.
+     */
+    int getDefinedValue() const { return definesResult() ? result.value : -1; }
+
+    /**
+     * @brief Calls a function for every operand the instruction reads, including phi operands.
+     * @param visit The function to call.
+     */
+    void forEachUse(const std::function<void(SSAOperand &)> &visit);
+
+    /**
+     * @brief Checks if the instruction may be removed when its result is unused.
+     * @return True if the instruction has no effect besides its result and cannot fail at run time.
+     */
+    bool isPure() const;
+};
+
+// A basic block of an SSAFunction. Exits are block indices, or -1.
+struct SSABlock {
+    BasicBlock *block;
+    std::vector<SSAInstruction> instructions;  // Phis come first
+    std::vector<int> predecessors;
+    int trueExit = -1;
+    int falseExit = -1;
+    bool removed = false;
+    int placedBefore = -1;  // For blocks added by passes, the block they are laid out right before
+};
+
+// Where an SSA value comes from
+struct SSAValue {
+    Symbol variable;         // The TAC variable the value is a version of
+    bool isEntry = false;    // The value the variable holds on entry: a parameter, or nothing yet
+    bool needsName = false;  // Read where its variable may hold another version, so it needs a name of its own
+};
+
+/*
+ * One method of the control flow graph in static single assignment form.
+ *
+ * Temporaries, parameters and local variables are renamed to SSA values, with phi instructions where versions
+ * meet. Fields, this and literals stay names, since fields are memory that calls and stores may change.
+ * Phis are only placed for variables that are live across blocks (semi-pruned SSA), which leaves out the
+ * statement-local temporaries.
+ *
+ * Lowering gives every value the name of its variable again. That is correct as long as passes only replace
+ * reads by constants or by values marked as needing a name of their own, only move instructions whose value
+ * needs a name, and only remove instructions and edges: then no two versions of a variable are ever live at
+ * once. Values that need a name get a fresh temporary, and phis that end up reading another name become copies
+ * on the incoming edges. New variables are safe too, as long as their versions are never live at once either.
+ */
+class SSAFunction {
+   public:
+    std::vector<SSABlock> blocks;
+    std::vector<SSAValue> values;
+    int entry;
+
+    /**
+     * @brief Converts the blocks of one method to SSA form.
+     * @param methodBlocks The blocks of the method, in layout order.
+     * @param method The method in the symbol table, or null if it is unknown.
+     */
+    SSAFunction(const std::vector<BasicBlock *> &methodBlocks, const Method *method);
+
+    /**
+     * @brief Converts the function back to TAC, rewriting its blocks in place.
+     * @return The blocks of the method in layout order, including blocks added on split edges.
+     */
+    std::vector<BasicBlock *> lower();
+
+    /**
+     * @brief Gets the dominator tree of the function, which removeUnreachableBlocks keeps up to date.
+     * @return The dominator tree.
+     */
+    const DominatorTree &getDominatorTree() const { return dominatorTree; }
+
+    /**
+     * @brief Updates predecessors and dominators after exits changed, removing blocks that can no longer be
+     * reached from the entry and phi operands of edges that no longer exist.
+     * @return The number of blocks removed.
+     */
+    int removeUnreachableBlocks();
+
+    /**
+     * @brief Adds a block that some edges into a block go through instead, laid out right before it. Phi
+     * operands of the redirected edges merge in the new block.
+     * @param target The block the edges lead to.
+     * @param predecessors The predecessors whose edges are redirected.
+     * @return The index of the new block.
+     */
+    int addPreheader(int target, const std::vector<int> &predecessors);
+
+    /**
+     * @brief Creates a new version of a variable, which nothing reads or writes yet.
+     * @param variable The variable.
+     * @param isEntry Whether the value is the one the variable holds on entry.
+     * @return The new value.
+     */
+    int newValue(Symbol variable, bool isEntry = false);
+
+    /**
+     * @brief Creates a value for a fresh temporary, which nothing reads or writes yet.
+     * @return The new value.
+     */
+    int newTemporary();
+
+    /**
+     * @brief Checks if a name is a literal, which is never renamed.
+     * @param name The name to check.
+     * @return True for integer and boolean literals.
+     */
+    static bool isLiteral(Symbol name);
+
+   private:
+    DominatorTree dominatorTree;
+    std::unordered_set<Symbol> variables;  // Parameters and locals, renamed along with temporaries
+    int nextTemporary;                     // Number of the next fresh temporary, above every temporary of the method
+
+    bool isVariable(Symbol name) const;
+    void computePredecessors();
+    std::vector<std::vector<int>> getSuccessors() const;
+    void placePhis();
+    void rename();
+};
+
+#endif  // STATICSINGLEASSIGNMENT_H
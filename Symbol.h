@@ -0,0 +1,203 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+ * The process-wide pool of interned strings.
+ *
+ * Every distinct string is stored once and numbered in the order it was first seen, with the empty string as
+ * number 0. The strings live in chunks that double in size and never move, so looking a number up takes no lock
+ * and a reference to an interned string stays valid until the program ends.
+ *
+ * Numbers are found by string in an open-addressing table of atomic slots. A slot is filled only after its string
+ * is stored, and a full table is replaced by a larger copy rather than resized in place, so finding a string that
+ * was interned before takes no lock either. Only interning a new string locks.
+ */
+class SymbolPool {
+   public:
+    SymbolPool(const SymbolPool &) = delete;
+    SymbolPool &operator=(const SymbolPool &) = delete;
+
+    /**
+     * @brief Gets the pool of the process.
+     * @return The pool.
+     */
+    static SymbolPool &get() {
+        static SymbolPool pool;
+        return pool;
+    }
+
+    /**
+     * @brief Interns a string.
+     * @param text The string.
+     * @return The number of the string, the same for every string with the same characters.
+     */
+    uint32_t intern(const std::string &text) {
+        if (text.empty()) return 0;
+        size_t hash = std::hash<std::string>()(text);
+        uint32_t id = find(*table.load(std::memory_order_acquire), text, hash);
+        if (id) return id;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Table *current = table.load(std::memory_order_relaxed);
+        id = find(*current, text, hash);
+        if (id) return id;
+
+        id = count;
+        size_t chunk = chunkOf(id);
+        if (!chunks[chunk]) chunks[chunk] = new std::string[chunkSize(chunk)];
+        chunks[chunk][id + FIRST_CHUNK_SIZE - chunkSize(chunk)] = text;
+        count++;
+
+        // At most half the slots are used, so probing stays short and always ends at an empty slot
+        if (2 * static_cast<size_t>(count) > current->size) current = grow(*current);
+        insert(*current, id, hash);
+        return id;
+    }
+
+    /**
+     * @brief Looks up an interned string.
+     * @param id The number of the string.
+     * @return The string.
+     */
+    const std::string &lookup(uint32_t id) const {
+        size_t chunk = chunkOf(id);
+        return chunks[chunk][id + FIRST_CHUNK_SIZE - chunkSize(chunk)];
+    }
+
+    /**
+     * @brief Gets the number of strings interned so far.
+     * @return The number of strings, including the empty string.
+     */
+    uint32_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return count;
+    }
+
+   private:
+    static const size_t FIRST_CHUNK_SIZE = 1024;
+    static const size_t MAX_CHUNKS = 23;  // Enough for every 32-bit number
+    static const size_t FIRST_TABLE_SIZE = 4096;
+
+    // Slots hold string numbers, with 0 for an empty slot
+    struct Table {
+        explicit Table(size_t size) : size(size), slots(new std::atomic<uint32_t>[size]) {
+            for (size_t i = 0; i < size; i++) slots[i].store(0, std::memory_order_relaxed);
+        }
+        size_t size;  // A power of two
+        std::unique_ptr<std::atomic<uint32_t>[]> slots;
+    };
+
+    SymbolPool() : chunks(), count(1) {
+        chunks[0] = new std::string[FIRST_CHUNK_SIZE];
+        tables.emplace_back(new Table(FIRST_TABLE_SIZE));
+        table.store(tables.back().get(), std::memory_order_release);
+    }
+    ~SymbolPool() {
+        for (std::string *chunk : chunks) delete[] chunk;
+    }
+
+    uint32_t find(const Table &in, const std::string &text, size_t hash) const {
+        for (size_t slot = hash & (in.size - 1);; slot = (slot + 1) & (in.size - 1)) {
+            uint32_t id = in.slots[slot].load(std::memory_order_acquire);
+            if (id == 0 || lookup(id) == text) return id;
+        }
+    }
+
+    void insert(Table &in, uint32_t id, size_t hash) {
+        size_t slot = hash & (in.size - 1);
+        while (in.slots[slot].load(std::memory_order_relaxed) != 0) slot = (slot + 1) & (in.size - 1);
+        in.slots[slot].store(id, std::memory_order_release);
+    }
+
+    // Copies the table into one twice as large. The old table is kept, as other threads may still be reading it.
+    Table *grow(const Table &from) {
+        tables.emplace_back(new Table(from.size * 2));
+        Table *to = tables.back().get();
+        for (size_t slot = 0; slot < from.size; slot++) {
+            uint32_t id = from.slots[slot].load(std::memory_order_relaxed);
+            if (id) insert(*to, id, std::hash<std::string>()(lookup(id)));
+        }
+        table.store(to, std::memory_order_release);
+        return to;
+    }
+
+    // Chunk k holds FIRST_CHUNK_SIZE << k strings, starting at number (FIRST_CHUNK_SIZE << k) - FIRST_CHUNK_SIZE
+    static size_t chunkSize(size_t chunk) { return FIRST_CHUNK_SIZE << chunk; }
+    static size_t chunkOf(uint32_t id) { return 63 - __builtin_clzll((id + FIRST_CHUNK_SIZE) / FIRST_CHUNK_SIZE); }
+
+    std::mutex mutex;  // Guards interning new strings
+    std::string *chunks[MAX_CHUNKS];
+    uint32_t count;
+    std::atomic<Table *> table;                 // The table strings are found in
+    std::vector<std::unique_ptr<Table>> tables;  // Every table made so far, the current one last
+};
+
+/*
+ * An interned string: identifiers, types, temporaries, block names and operators.
+ *
+ * A symbol is the 32-bit number of its string in the SymbolPool, so copying one is copying an integer and two
+ * symbols are equal exactly when their numbers are. It converts to and from std::string, so code that reads or
+ * builds names as strings keeps working. Comparing a symbol with a string literal does not compile: fixed names
+ * such as operators are interned once as constants and compared as symbols.
+ */
+class Symbol {
+   public:
+    Symbol() : id(0) {}
+    Symbol(const std::string &text) : id(SymbolPool::get().intern(text)) {}
+    Symbol(const char *text) : id(*text ? SymbolPool::get().intern(text) : 0) {}
+
+    /**
+     * @brief Gets the string of the symbol.
+     * @return The string, valid until the program ends.
+     */
+    const std::string &str() const { return SymbolPool::get().lookup(id); }
+    operator const std::string &() const { return str(); }
+
+    /**
+     * @brief Gets the number of the symbol.
+     * @return The number of its string in the pool.
+     */
+    uint32_t getId() const { return id; }
+
+    bool empty() const { return id == 0; }
+    size_t size() const { return str().size(); }
+    const char *c_str() const { return str().c_str(); }
+
+    friend bool operator==(Symbol a, Symbol b) { return a.id == b.id; }
+    friend bool operator!=(Symbol a, Symbol b) { return a.id != b.id; }
+    friend bool operator==(Symbol a, const char *b) = delete;
+    friend bool operator!=(Symbol a, const char *b) = delete;
+    friend bool operator==(const char *a, Symbol b) = delete;
+    friend bool operator!=(const char *a, Symbol b) = delete;
+    friend bool operator==(Symbol a, const std::string &b) { return a.str() == b; }
+    friend bool operator!=(Symbol a, const std::string &b) { return a.str() != b; }
+    friend bool operator==(const std::string &a, Symbol b) { return a == b.str(); }
+    friend bool operator!=(const std::string &a, Symbol b) { return a != b.str(); }
+
+    friend std::string operator+(Symbol a, const std::string &b) { return a.str() + b; }
+    friend std::string operator+(const std::string &a, Symbol b) { return a + b.str(); }
+    friend std::string operator+(Symbol a, const char *b) { return a.str() + b; }
+    friend std::string operator+(const char *a, Symbol b) { return a + b.str(); }
+    friend std::ostream &operator<<(std::ostream &out, Symbol symbol) { return out << symbol.str(); }
+
+   private:
+    uint32_t id;
+};
+
+namespace std {
+template <>
+struct hash<Symbol> {
+    size_t operator()(Symbol symbol) const { return symbol.getId(); }
+};
+}  // namespace std
+
+#endif  // SYMBOL_H
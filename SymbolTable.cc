@@ -1,73 +1,53 @@
 #include "SymbolTable.h"
 
 const Method &Class::getMethod(const std::string &methodName) const {
-    auto it = std::find_if(methods.begin(), methods.end(), [&](const Method &m) { return m.getName() == methodName; });
-    return *it;
+    const Method *method = findMethod(methodName);
+    if (!method) throw std::runtime_error("Method not found: " + methodName);
+    return *method;
+}
+
+void SymbolTable::addClass(const Class &cls) {
+    // Inserting at the front places a class before earlier classes with the same name, and the index follows suit
+    auto it = classes.insert(classes.begin(), std::make_pair(cls.getName(), cls));
+    std::vector<const Class *> &named = occurrences[cls.getName()];
+    named.insert(named.begin(), &it->second);
 }
 
 const Class &SymbolTable::getClass(const std::string &className) const {
-    auto it = classes.find(className);
-    if (it != classes.end()) {
-        return it->second;
+    auto it = occurrences.find(className);
+    if (it != occurrences.end()) {
+        return *it->second.front();
     } else {
         throw std::runtime_error("Class not found: " + className);
     }
 }
 
 const Class &SymbolTable::getOccurenceOfClass(const std::string &className, int occurence) const {
-    int count = 0;
-    for (const auto &cls : classes) {
-        if (cls.first == className) {
-            count++;
-            if (count == occurence) {
-                return cls.second;
-            }
-        }
+    auto it = occurrences.find(className);
+    if (it != occurrences.end() && occurence >= 1 && static_cast<size_t>(occurence) <= it->second.size()) {
+        return *it->second[occurence - 1];
     }
     throw std::runtime_error("Class occurence not found: " + className);
 }
 
 std::string SymbolTable::getVariableType(const std::string &identifier, const std::string &method,
-                                         const std::string &className) {
-    auto classIt = classes.find(className);
-    if (classIt != classes.end()) {
-        // Class variables
-        const std::vector<Variable> &variables = classIt->second.getVariables();
-        auto varIt = std::find_if(variables.begin(), variables.end(),
-                                  [&](const Variable &v) { return v.getName() == identifier; });
-        if (varIt != variables.end()) {
-            return varIt->getType();
-        }
-
-        // Method variables
-        const std::vector<Method> &methods = classIt->second.getMethods();
-        auto methodIt =
-            std::find_if(methods.begin(), methods.end(), [&](const Method &m) { return m.getName() == method; });
+                                         const std::string &className) const {
+    auto classIt = occurrences.find(className);
+    if (classIt != occurrences.end()) {
+        const Class &cls = *classIt->second.front();
 
-        if (methodIt != methods.end()) {
-            // Method parameters
-            const std::vector<Variable> &parameters = methodIt->getParameters();
-            auto paramIt = std::find_if(parameters.begin(), parameters.end(),
-                                        [&](const Variable &v) { return v.getName() == identifier; });
+        // Class variables
+        if (const Variable *variable = cls.findVariable(identifier)) return variable->getType();
 
-            if (paramIt != parameters.end()) {
-                return paramIt->getType();
-            } else {
-                // Local variables
-                const std::vector<std::pair<Variable, int>> &localVariables = methodIt->getLocalVariables();
-                auto localVarIt =
-                    std::find_if(localVariables.begin(), localVariables.end(),
-                                 [&](const std::pair<Variable, int> &v) { return v.first.getName() == identifier; });
-                if (localVarIt != localVariables.end()) {
-                    return localVarIt->first.getType();
-                }
-            }
+        // Method parameters, then local variables
+        if (const Method *methodInfo = cls.findMethod(method)) {
+            if (const Variable *parameter = methodInfo->findParameter(identifier)) return parameter->getType();
+            if (const Variable *local = methodInfo->findLocalVariable(identifier)) return local->getType();
         }
     }
 
     // Check if identifier is a class
-    classIt = classes.find(identifier);
-    if (classIt != classes.end()) {
+    if (hasClass(identifier)) {
         return identifier;
     }
 
@@ -76,13 +56,11 @@ std::string SymbolTable::getVariableType(const std::string &identifier, const st
 }
 
 std::string SymbolTable::getMethodReturnType(const std::string &className, const std::string &methodName) const {
-    auto classIt = classes.find(className);
-    if (classIt != classes.end()) {
-        const std::vector<Method> &methods = classIt->second.getMethods();
-        auto methodIt =
-            std::find_if(methods.begin(), methods.end(), [&](const Method &m) { return m.getName() == methodName; });
-        if (methodIt != methods.end()) {
-            return methodIt->getReturnType();
+    auto classIt = occurrences.find(className);
+    if (classIt != occurrences.end()) {
+        const Method *method = classIt->second.front()->findMethod(methodName);
+        if (method) {
+            return method->getReturnType();
         } else {
             throw std::runtime_error("Method not found: " + methodName);
         }
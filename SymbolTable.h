@@ -5,6 +5,7 @@
 #include <map>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 // Class representing a variable
@@ -21,13 +22,13 @@ class Variable {
      * @brief Gets the name of the variable.
      * @return The name of the variable.
      */
-    std::string getName() const { return name; }
+    const std::string &getName() const { return name; }
 
     /**
      * @brief Gets the type of the variable.
      * @return The type of the variable.
      */
-    std::string getType() const { return type; }
+    const std::string &getType() const { return type; }
 
    private:
     std::string name;
@@ -48,26 +49,32 @@ class Method {
      * @brief Gets the name of the method.
      * @return The name of the method.
      */
-    std::string getName() const { return name; }
+    const std::string &getName() const { return name; }
 
     /**
      * @brief Gets the return type of the method.
      * @return The return type of the method.
      */
-    std::string getReturnType() const { return returnType; }
+    const std::string &getReturnType() const { return returnType; }
 
     /**
      * @brief Adds a parameter to the method.
      * @param param The parameter to add.
      */
-    void addParameter(const Variable &param) { parameters.push_back(param); }
+    void addParameter(const Variable &param) {
+        parameterIndices.emplace(param.getName(), parameters.size());
+        parameters.push_back(param);
+    }
 
     /**
      * @brief Adds a local variable to the method.
      * @param var The local variable to add.
      * @param lineNumber The line number where the variable is declared.
      */
-    void addLocalVariable(const Variable &var, int lineNumber) { localVariables.push_back({var, lineNumber}); }
+    void addLocalVariable(const Variable &var, int lineNumber) {
+        localVariableIndices.emplace(var.getName(), localVariables.size());
+        localVariables.push_back({var, lineNumber});
+    }
 
     /**
      * @brief Gets the parameters of the method.
@@ -88,9 +95,9 @@ class Method {
      * @return True if the variable is declared before the line number, otherwise false.
      */
     bool isVariableDeclaredBefore(const std::string &varName, int lineNumber) const {
-        return std::any_of(localVariables.begin(), localVariables.end(), [&](const std::pair<Variable, int> &v) {
-            return v.first.getName() == varName && v.second < lineNumber;
-        });
+        // Locals are added in the order they are declared, so the first with a name is declared on the earliest line
+        auto it = localVariableIndices.find(varName);
+        return it != localVariableIndices.end() && localVariables[it->second].second < lineNumber;
     }
 
     /**
@@ -98,9 +105,26 @@ class Method {
      * @param varName The name of the variable.
      * @return True if the variable is a local variable, otherwise false.
      */
-    bool isLocalVariable(const std::string &varName) const {
-        return std::any_of(localVariables.begin(), localVariables.end(),
-                           [&](const std::pair<Variable, int> &v) { return v.first.getName() == varName; });
+    bool isLocalVariable(const std::string &varName) const { return localVariableIndices.count(varName) != 0; }
+
+    /**
+     * @brief Finds a parameter by name.
+     * @param varName The name of the parameter.
+     * @return The first parameter with the name, or nullptr if there is none.
+     */
+    const Variable *findParameter(const std::string &varName) const {
+        auto it = parameterIndices.find(varName);
+        return it != parameterIndices.end() ? &parameters[it->second] : nullptr;
+    }
+
+    /**
+     * @brief Finds a local variable by name.
+     * @param varName The name of the local variable.
+     * @return The first local variable with the name, or nullptr if there is none.
+     */
+    const Variable *findLocalVariable(const std::string &varName) const {
+        auto it = localVariableIndices.find(varName);
+        return it != localVariableIndices.end() ? &localVariables[it->second].first : nullptr;
     }
 
    private:
@@ -108,6 +132,8 @@ class Method {
     std::string returnType;
     std::vector<Variable> parameters;
     std::vector<std::pair<Variable, int>> localVariables;
+    std::unordered_map<std::string, size_t> parameterIndices;  // Position of the first parameter with each name
+    std::unordered_map<std::string, size_t> localVariableIndices;  // Position of the first local with each name
 };
 
 // Class representing a class
@@ -125,19 +151,25 @@ class Class {
      * @brief Gets the name of the class.
      * @return The name of the class.
      */
-    std::string getName() const { return name; }
+    const std::string &getName() const { return name; }
 
     /**
      * @brief Adds a method to the class.
      * @param method The method to add.
      */
-    void addMethod(const Method &method) { methods.push_back(method); }
+    void addMethod(const Method &method) {
+        methodIndices.emplace(method.getName(), methods.size());
+        methods.push_back(method);
+    }
 
     /**
      * @brief Adds a variable to the class.
      * @param variable The variable to add.
      */
-    void addVariable(const Variable &variable) { variables.push_back(variable); }
+    void addVariable(const Variable &variable) {
+        variableIndices.emplace(variable.getName(), variables.size());
+        variables.push_back(variable);
+    }
 
     /**
      * @brief Gets the methods of the class.
@@ -156,39 +188,63 @@ class Class {
      * @param methodName The name of the method.
      * @return True if the class has the method, otherwise false.
      */
-    bool hasMethod(const std::string &methodName) const {
-        return std::any_of(methods.begin(), methods.end(), [&](const Method &m) { return m.getName() == methodName; });
-    }
+    bool hasMethod(const std::string &methodName) const { return methodIndices.count(methodName) != 0; }
 
     /**
      * @brief Gets a method by name.
      * @param methodName The name of the method.
-     * @return The method with the specified name.
+     * @return The first method with the specified name.
      * @throws std::runtime_error if the method is not found.
      */
     const Method &getMethod(const std::string &methodName) const;
 
+    /**
+     * @brief Finds a method by name.
+     * @param methodName The name of the method.
+     * @return The first method with the name, or nullptr if there is none.
+     */
+    const Method *findMethod(const std::string &methodName) const {
+        auto it = methodIndices.find(methodName);
+        return it != methodIndices.end() ? &methods[it->second] : nullptr;
+    }
+
+    /**
+     * @brief Finds a class variable by name.
+     * @param varName The name of the variable.
+     * @return The first variable with the name, or nullptr if there is none.
+     */
+    const Variable *findVariable(const std::string &varName) const {
+        auto it = variableIndices.find(varName);
+        return it != variableIndices.end() ? &variables[it->second] : nullptr;
+    }
+
    private:
     std::string name;
     std::vector<Method> methods;
     std::vector<Variable> variables;
+    std::unordered_map<std::string, size_t> methodIndices;    // Position of the first method with each name
+    std::unordered_map<std::string, size_t> variableIndices;  // Position of the first variable with each name
 };
 
 // Symbol table class
 class SymbolTable {
    public:
+    SymbolTable() = default;
+    SymbolTable(const SymbolTable &) = delete;  // The index points into the classes
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
     /**
      * @brief Adds a class to the symbol table.
      * @param cls The class to add.
      */
-    void addClass(const Class &cls) { classes.insert(classes.begin(), std::make_pair(cls.getName(), cls)); }
+    void addClass(const Class &cls);
 
     /**
      * @brief Checks if a class exists in the symbol table.
      * @param className The name of the class.
      * @return True if the class exists, otherwise false.
      */
-    bool hasClass(const std::string &className) const { return classes.find(className) != classes.end(); }
+    bool hasClass(const std::string &className) const { return occurrences.count(className) != 0; }
 
     /**
      * @brief Gets a class by name.
@@ -213,7 +269,8 @@ class SymbolTable {
      * @return The type of the variable.
      * @throws std::runtime_error if the variable is not found.
      */
-    std::string getVariableType(const std::string &identifier, const std::string &method, const std::string &className);
+    std::string getVariableType(const std::string &identifier, const std::string &method,
+                                const std::string &className) const;
 
     /**
      * @brief Gets the return type of a method.
@@ -226,24 +283,13 @@ class SymbolTable {
 
     /**
      * @brief Gets all classes in the symbol table.
-     * @return A vector of all classes.
-     */
-    std::vector<Class> getAllClasses() const {
-        std::vector<Class> classList;
-        for (const auto &pair : classes) {
-            classList.push_back(pair.second);
-        }
-        return classList;
-    }
-
-    /**
-     * @brief Gets all classes in the symbol table.
-     * @return A reference to the unordered multimap of classes.
+     * @return A reference to the multimap of classes, ordered by name.
      */
     const std::multimap<std::string, Class> &getClasses() const { return classes; }
 
    private:
     std::multimap<std::string, Class> classes;
+    std::unordered_map<std::string, std::vector<const Class *>> occurrences;  // Classes by name, in multimap order
 };
 
 #endif  // SYMBOL_TABLE_H
\ No newline at end of file
@@ -5,7 +5,7 @@
 
 void processVarDeclarationList(Node *child, Class &cls) {
     for (auto varChild : child->children) {
-        if (varChild->type == "VarDeclaration" && varChild->children.size() >= 2) {
+        if (varChild->kind == NodeKind::VarDeclaration && varChild->children.size() >= 2) {
             auto typeIt = varChild->children.begin();
             auto nameIt = std::next(typeIt);
             Variable var((*nameIt)->value, (*typeIt)->value);
@@ -16,12 +16,12 @@ void processVarDeclarationList(Node *child, Class &cls) {
 
 void processMethodDeclarationList(Node *child, Class &cls) {
     for (auto methodChild : child->children) {
-        if (methodChild->type == "MethodDeclaration" && methodChild->children.size() >= 1) {
+        if (methodChild->kind == NodeKind::MethodDeclaration && methodChild->children.size() >= 1) {
             auto returnType = methodChild->children.begin();
             Method method(methodChild->value, (*returnType)->value);
 
             auto paramList = std::next(methodChild->children.begin());
-            if (paramList != methodChild->children.end() && (*paramList)->type == "ParameterList") {
+            if (paramList != methodChild->children.end() && (*paramList)->kind == NodeKind::ParameterList) {
                 for (auto param : (*paramList)->children) {
                     if (param->children.size() >= 1) {
                         auto paramType = param->children.begin();
@@ -31,9 +31,9 @@ void processMethodDeclarationList(Node *child, Class &cls) {
             }
 
             for (auto methodBodyChild : methodChild->children) {
-                if (methodBodyChild->type == "Code") {
+                if (methodBodyChild->kind == NodeKind::Code) {
                     for (auto varChild : methodBodyChild->children) {
-                        if (varChild->type == "Variable") {
+                        if (varChild->kind == NodeKind::Variable) {
                             std::string name = varChild->value;
                             std::string type = (*varChild->children.begin())->value;
                             Variable var(name, type);
@@ -52,10 +52,15 @@ void processClassDeclaration(Node *current, SymbolTable &symbolTable) {
     Class cls(current->value);
 
     for (auto child : current->children) {
-        if (child->type == "VarDeclarationList") {
-            processVarDeclarationList(child, cls);
-        } else if (child->type == "MethodDeclarationList") {
-            processMethodDeclarationList(child, cls);
+        switch (child->kind) {
+            case NodeKind::VarDeclarationList:
+                processVarDeclarationList(child, cls);
+                break;
+            case NodeKind::MethodDeclarationList:
+                processMethodDeclarationList(child, cls);
+                break;
+            default:
+                break;
         }
     }
 
@@ -82,16 +87,24 @@ void buildSymbolTable(Node *root, SymbolTable &symbolTable) {
         Node *current = nodeStack.top();
         nodeStack.pop();
 
-        if (current->type == "MainClass") {
-            processMainClass(current, symbolTable);
-        } else if (current->type == "ClassDeclaration") {
-            processClassDeclaration(current, symbolTable);
-        }
-
-        for (auto child : current->children) {
-            if (child) {
-                nodeStack.push(child);
-            }
+        // Classes are only declared at the top of the tree, so the walk stops at them
+        switch (current->kind) {
+            case NodeKind::Goal:
+            case NodeKind::ClassDeclarationList:
+                for (auto child : current->children) {
+                    if (child) {
+                        nodeStack.push(child);
+                    }
+                }
+                break;
+            case NodeKind::MainClass:
+                processMainClass(current, symbolTable);
+                break;
+            case NodeKind::ClassDeclaration:
+                processClassDeclaration(current, symbolTable);
+                break;
+            default:
+                break;
         }
     }
 }
\ No newline at end of file
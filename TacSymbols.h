@@ -0,0 +1,48 @@
+#ifndef TAC_SYMBOLS_H
+#define TAC_SYMBOLS_H
+
+#include "Symbol.h"
+
+// The operators and fixed names of three-address code, interned once so that the passes compare them as symbols
+namespace tac {
+
+// Arithmetic and logic
+const Symbol ADD(" + ");
+const Symbol SUB(" - ");
+const Symbol MUL(" * ");
+const Symbol LESS(" < ");
+const Symbol GREATER(" > ");
+const Symbol EQUAL(" == ");
+const Symbol AND(" && ");
+const Symbol OR(" || ");
+const Symbol NOT("!");
+
+// Control flow, calls and output. A copy has no operator: its op is the empty symbol.
+const Symbol IF("if");
+const Symbol PARAM("param");
+const Symbol CALL("call");
+const Symbol RETURN("return");
+const Symbol PRINT("print");
+const Symbol PHI("phi");
+
+// Objects, fields and arrays
+const Symbol NEW("new");
+const Symbol NEW_ARRAY("new int[");
+const Symbol LENGTH("length ");
+const Symbol LOAD_INDEX("[");
+const Symbol STORE_INDEX("[]=");
+const Symbol LOAD_INDEX_UNCHECKED("unchecked[");
+const Symbol STORE_INDEX_UNCHECKED("unchecked[]=");
+const Symbol LOAD_FIELD(".");
+const Symbol STORE_FIELD(".=");
+
+// Operands with a fixed meaning
+const Symbol THIS("this");
+const Symbol TRUE_LITERAL("true");
+const Symbol FALSE_LITERAL("false");
+const Symbol ZERO("0");
+const Symbol ONE("1");
+
+}  // namespace tac
+
+#endif  // TAC_SYMBOLS_H
@@ -0,0 +1,143 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * A pool of threads that runs batches of independent tasks, with work stealing.
+ *
+ * The tasks of a batch are numbered, and every thread gets a queue with a contiguous run of them. A thread takes
+ * tasks from the front of its own queue and, once that is empty, steals from the back of the queues of the others,
+ * so the threads that drew cheap tasks help out with the expensive ones. The thread that runs a batch works on it
+ * too, so a pool of one thread runs every task in order on the calling thread.
+ */
+class ThreadPool {
+   public:
+    /**
+     * @brief Starts the threads of the pool.
+     * @param threadCount The number of threads to run tasks on, including the thread that runs batches.
+     */
+    explicit ThreadPool(unsigned threadCount)
+        : queues(threadCount ? threadCount : 1), current(nullptr), generation(0), active(0), stopping(false) {
+        for (size_t i = 1; i < queues.size(); i++) threads.emplace_back(&ThreadPool::work, this, i);
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &thread : threads) thread.join();
+    }
+
+    /**
+     * @brief Gets the number of threads tasks run on.
+     * @return The number of threads, including the thread that runs batches.
+     */
+    size_t size() const { return queues.size(); }
+
+    /**
+     * @brief Runs a batch of tasks and waits for all of them to finish.
+     * @param count The number of tasks.
+     * @param task The task, called once with every number below count. It must not throw.
+     */
+    void run(size_t count, const std::function<void(size_t)> &task) {
+        for (size_t i = 0; i < queues.size(); i++) {
+            std::lock_guard<std::mutex> lock(queues[i].mutex);
+            for (size_t index = count * i / queues.size(); index < count * (i + 1) / queues.size(); index++) {
+                queues[i].tasks.push_back(index);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = &task;
+            active++;
+            generation++;
+        }
+        wake.notify_all();
+        drain(0, task);
+
+        // The queues are empty, so the batch is over once no thread is still running a task of it
+        std::unique_lock<std::mutex> lock(mutex);
+        active--;
+        finished.wait(lock, [&] { return active == 0; });
+        current = nullptr;
+    }
+
+   private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    // Waits for batches and helps out with them until the pool is destroyed
+    void work(size_t self) {
+        size_t seen = 0;
+        while (true) {
+            const std::function<void(size_t)> *task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                task = current;
+                if (!task) continue;  // Woke up after the batch was over
+                active++;
+            }
+            drain(self, *task);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--active == 0) finished.notify_all();
+        }
+    }
+
+    // Runs tasks from a thread's own queue, then from the others, until every queue is empty
+    void drain(size_t self, const std::function<void(size_t)> &task) {
+        size_t index;
+        while (take(self, index)) task(index);
+    }
+
+    // Takes the next task of a thread's own queue, or steals the last task of another queue
+    bool take(size_t self, size_t &index) {
+        {
+            std::lock_guard<std::mutex> lock(queues[self].mutex);
+            if (!queues[self].tasks.empty()) {
+                index = queues[self].tasks.front();
+                queues[self].tasks.pop_front();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); i++) {
+            Queue &victim = queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                index = victim.tasks.back();
+                victim.tasks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Queue> queues;  // One per thread, the thread that runs batches first
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;  // Guards the batch state below
+    std::condition_variable wake;
+    std::condition_variable finished;
+    const std::function<void(size_t)> *current;  // The task of the batch being run, or nullptr
+    size_t generation;                           // The number of batches started
+    size_t active;                               // Threads working on the batch
+    bool stopping;
+};
+
+#endif  // THREAD_POOL_H
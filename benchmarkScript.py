@@ -0,0 +1,80 @@
+import os
+import subprocess
+import sys
+import time
+
+# ANSI escape codes for colored output
+class Colors:
+    RED = '\033[91m'
+    GREEN = '\033[92m'
+    DARK_GREEN = '\033[32m'
+    END = '\033[0m'
+
+def colored(text, color):
+    return f"{color}{text}{Colors.END}"
+
+def compile_program(file_path):
+    process = subprocess.run(['./compiler', file_path], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return process.returncode == 0 and os.path.exists('output.bc')
+
+def run_interpreter(options):
+    start = time.perf_counter()
+    process = subprocess.run(['./interpreter'] + options + ['output.bc'], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    elapsed = time.perf_counter() - start
+    return process.stdout.decode(), process.stderr.decode(), elapsed
+
+def best_of(options, runs):
+    best = None
+    output = None
+    for _ in range(runs):
+        stdout, stderr, elapsed = run_interpreter(options)
+        output = (stdout, stderr)
+        best = elapsed if best is None else min(best, elapsed)
+    return output, best
+
+def benchmark_folder(folder_path, engines, runs):
+    print(colored(f"\nBenchmarking {folder_path} (best of {runs} runs)...", Colors.GREEN))
+    header = f"    {'program':<50}" + "".join(f"{name:>12}" for name, _ in engines)
+    print(header)
+
+    for file in sorted(os.listdir(folder_path)):
+        if not file.endswith('.java'):
+            continue
+        if os.path.exists('output.bc'):
+            os.remove('output.bc')
+        if not compile_program(os.path.join(folder_path, file)):
+            print(f"    {file:<50}" + colored("  compile error", Colors.RED))
+            continue
+
+        results = [best_of(options, runs) for _, options in engines]
+        reference = results[0][0]
+        line = f"    {file:<50}" + "".join(f"{elapsed * 1000:>10.1f}ms" for _, elapsed in results)
+        if all(output == reference for output, _ in results):
+            print(line)
+        else:
+            print(line + colored("  output differs", Colors.RED))
+
+def main():
+    if not os.path.exists('./compiler') or not os.path.exists('./interpreter'):
+        print(colored("Compiler or interpreter executable not found. Please build both first.", Colors.RED))
+        sys.exit(1)
+
+    runs = 5
+    folders = []
+    for arg in sys.argv[1:]:
+        if arg.startswith('-runs='):
+            runs = int(arg[len('-runs='):])
+        else:
+            folders.append(arg)
+    if not folders:
+        folders = ['test_files/valid']
+
+    # Every engine must produce identical output, the first one is the reference
+    engines = [('switch', ['--dispatch=switch']), ('threaded', ['--dispatch=threaded']), ('jit', ['--dispatch=jit'])]
+
+    for folder in folders:
+        benchmark_folder(folder, engines, runs)
+
+
+if __name__ == "__main__":
+    main()
@@ -1,16 +1,26 @@
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <stack>
+#include <thread>
 
+#include "AssemblyGenerator.h"
 #include "BytecodeGenerator.h"
+#include "Inliner.h"
 #include "IntermediateRepresentation.h"
 #include "Node.h"
+#include "OptimizationPasses.h"
+#include "PeepholeOptimizer.h"
 #include "SemanticAnalyzer.h"
 #include "SymbolTable.h"
 #include "SymbolTableBuilder.h"
 #include "parser.tab.hh"
 
 extern Node *root;
+extern NodeArena nodeArena;
 extern FILE *yyin;
 extern int yylineno;
 extern int lexical_errors;
@@ -67,10 +77,57 @@ void exitWithError(int errorCode) {
 }
 
 int main(int argc, char **argv) {
+    // Options start with "--", the first other argument is the input file.
+    const char *inputFile = nullptr;
+    bool emitBinary = false;
+    bool emitAssembly = false;
+    bool peephole = true;
+    bool ssa = true;
+    bool inlining = true;
+    bool tailCalls = true;
+    bool simplifyCFG = true;
+    bool printStats = false;
+    unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--emit=bcb") {
+            emitBinary = true;
+        } else if (arg == "--emit=asm") {
+            emitAssembly = true;
+        } else if (arg == "--no-peephole") {
+            peephole = false;
+        } else if (arg == "--no-inline") {
+            inlining = false;
+        } else if (arg == "--no-tail-calls") {
+            tailCalls = false;
+        } else if (arg == "--no-simplify-cfg") {
+            simplifyCFG = false;
+        } else if (arg == "--no-ssa") {
+            ssa = false;
+        } else if (arg == "--stats") {
+            printStats = true;
+        } else if (arg.rfind("--jobs=", 0) == 0) {
+            const char *value = arg.c_str() + strlen("--jobs=");
+            char *end = nullptr;
+            errno = 0;
+            long parsed = std::strtol(value, &end, 10);
+            if (!*value || *end || errno == ERANGE || parsed < 1 || parsed > INT_MAX) {
+                std::cerr << "Invalid number of jobs: " << value << std::endl;
+                return 1;
+            }
+            jobs = static_cast<unsigned>(parsed);
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        } else if (!inputFile) {
+            inputFile = argv[i];
+        }
+    }
+
     // Reads from file if a file name is passed as an argument. Otherwise, reads from stdin.
-    if (argc > 1) {
-        if (!(yyin = fopen(argv[1], "r"))) {
-            perror(argv[1]);
+    if (inputFile) {
+        if (!(yyin = fopen(inputFile, "r"))) {
+            perror(inputFile);
             return 1;
         }
     }
@@ -112,7 +169,7 @@ int main(int argc, char **argv) {
 
         // Perform semantic analysis
         try {
-            SemanticAnalyzer semanticAnalyzer(symbolTable);
+            SemanticAnalyzer semanticAnalyzer(symbolTable, jobs);
             semanticAnalyzer.analyze(root);
 
             if (semanticAnalyzer.getSemanticErrors() > 0) {
@@ -127,6 +184,43 @@ int main(int argc, char **argv) {
         ControlFlowGraph cfg;
         try {
             cfg.traverseAST(root);
+
+            // Nothing reads the tree past this point, so it is freed in one go
+            root = nullptr;
+            nodeArena.release();
+
+            // Recursive methods become loops first, so that inlining copies the loops
+            if (tailCalls) {
+                int eliminated = TailCallElimination().run(cfg, symbolTable);
+                if (printStats) std::cerr << "Tail calls: " << eliminated << " eliminated" << std::endl;
+            }
+
+            if (inlining) {
+                int inlined = Inliner().run(cfg, symbolTable);
+                if (printStats) std::cerr << "Inline: " << inlined << " calls inlined" << std::endl;
+            }
+
+            if (ssa) {
+                PassManager passManager;
+                passManager.addPass(std::unique_ptr<SSAPass>(new SparseConditionalConstantPropagation()));
+                passManager.addPass(std::unique_ptr<SSAPass>(new GlobalValueNumbering()));
+                passManager.addPass(std::unique_ptr<SSAPass>(new LoopInvariantCodeMotion()));
+                passManager.addPass(std::unique_ptr<SSAPass>(new StrengthReduction()));
+                passManager.addPass(std::unique_ptr<SSAPass>(new BoundsCheckElimination()));
+                passManager.addPass(std::unique_ptr<SSAPass>(new DeadCodeElimination()));
+                passManager.run(cfg, symbolTable);
+                if (printStats) {
+                    for (const auto &pass : passManager.getStats()) {
+                        std::cerr << "SSA: " << pass.first << ": " << pass.second << std::endl;
+                    }
+                }
+            }
+
+            // Last, as the passes before leave empty blocks and jumps to jumps behind
+            if (simplifyCFG) {
+                int removed = ControlFlowSimplification().run(cfg);
+                if (printStats) std::cerr << "CFG: " << removed << " blocks removed" << std::endl;
+            }
             cfg.writeCFG();
         } catch (const std::exception &e) {
             std::cerr << "Error generating intermediate representation: " << e.what() << std::endl;
@@ -138,15 +232,52 @@ int main(int argc, char **argv) {
             BCProgram program;
             program.generateBytecode(cfg, symbolTable);
 
+            if (peephole) {
+                PeepholeStats stats = PeepholeOptimizer().optimize(program);
+                if (printStats) {
+                    std::cerr << "Peephole: " << stats.instructionsBefore << " -> " << stats.instructionsAfter
+                              << " instructions" << std::endl;
+                    for (const auto &rule : stats.rewrites) {
+                        std::cerr << "Peephole: " << rule.first << ": " << rule.second << std::endl;
+                    }
+                }
+            }
+
             std::ofstream outFile("output.bc");
             if (!outFile) {
                 throw std::runtime_error("Failed to open output.bc for writing");
             }
             program.print(outFile);
+
+            // The binary form is written next to the text form when requested
+            if (emitBinary) {
+                std::ofstream binaryFile("output.bcb", std::ios::binary);
+                if (!binaryFile) {
+                    throw std::runtime_error("Failed to open output.bcb for writing");
+                }
+                program.writeBinary(binaryFile);
+            }
         } catch (const std::exception &e) {
             std::cerr << "Error generating bytecode: " << e.what() << std::endl;
             exitWithError(errCodes::IR_ERROR);
         }
+
+        // Generate native assembly, to be linked with runtime.c
+        if (emitAssembly) {
+            try {
+                AsmProgram program;
+                program.generateAssembly(cfg, symbolTable);
+
+                std::ofstream outFile("output.s");
+                if (!outFile) {
+                    throw std::runtime_error("Failed to open output.s for writing");
+                }
+                program.print(outFile);
+            } catch (const std::exception &e) {
+                std::cerr << "Error generating assembly: " << e.what() << std::endl;
+                exitWithError(errCodes::IR_ERROR);
+            }
+        }
     }
 
     exitWithError(0);
@@ -18,6 +18,7 @@
   YY_DECL;
 
   Node* root;
+  NodeArena nodeArena;  // Owns every node of the tree
   extern int yylineno;
   int class_start_line;
   int method_start_line;
@@ -25,7 +26,8 @@
 
 /* Token definitions for the grammar */
 /* Tokens represent the smallest units of the language, like operators and parentheses */
-%token <std::string> PUBLIC CLASS STATIC VOID MAIN STRING RETURN INTARR BOOL INT IF ELSE WHILE PRINT EQUALSSIGN LP RP RC LC SEMCOL COMMA ANDEXPR OREXPR LTEXPR GTEXPR EQUALSEXPR PLUSOP MINUSOP MULTOP LB RB DOT LEN THIS NEW EXCLMARK TRUE FALSE INTLIT STRLIT
+%token <std::string> PUBLIC CLASS STATIC VOID MAIN STRING RETURN INTARR BOOL INT IF ELSE WHILE PRINT EQUALSSIGN LP RP RC LC SEMCOL COMMA ANDEXPR OREXPR LTEXPR GTEXPR EQUALSEXPR PLUSOP MINUSOP MULTOP LB RB DOT LEN THIS NEW EXCLMARK TRUE FALSE INTLIT
+%token <Symbol> STRLIT
 %token END 0 "end of file"
 
 /* Operator precedence and associativity rules */
@@ -53,14 +55,14 @@ root:
 
 goal:
     main_class class_declaration_list END {
-        $$ = new Node("Goal", "", yylineno);
+        $$ = nodeArena.create(NodeKind::Goal, "", yylineno);
         $$->children.push_back($1);
         $$->children.push_back($2);
     };
 
 class_declaration_list:
     %empty {
-        $$ = new Node("ClassDeclarationList", "", yylineno);
+        $$ = nodeArena.create(NodeKind::ClassDeclarationList, "", yylineno);
     }
     | class_declaration_list class_declaration {
         $$ = $1;
@@ -69,12 +71,12 @@ class_declaration_list:
 
 main_class:
     PUBLIC CLASS identifier LC PUBLIC STATIC VOID MAIN LP STRING LB RB identifier RP LC statement statement_list RC RC {
-        $$ = new Node("MainClass", $3->value, yylineno);
-        Node* stringArgs = new Node("StringArgs", $13->value, yylineno);
+        $$ = nodeArena.create(NodeKind::MainClass, $3->value, yylineno);
+        Node* stringArgs = nodeArena.create(NodeKind::StringArgs, $13->value, yylineno);
         $$->children.push_back(stringArgs);
 
-        Node* statementsNode = new Node("StatementList", "", yylineno);
-        if ($16->type == "StatementList") {
+        Node* statementsNode = nodeArena.create(NodeKind::StatementList, "", yylineno);
+        if ($16->kind == NodeKind::StatementList) {
             for (auto child : $16->children) {
                 statementsNode->children.push_back(child);
             }
@@ -90,14 +92,14 @@ main_class:
 
 class_declaration:
     { class_start_line = yylineno; } CLASS identifier LC var_declaration_list method_declaration_list RC {
-        $$ = new Node("ClassDeclaration", $3->value, class_start_line);
+        $$ = nodeArena.create(NodeKind::ClassDeclaration, $3->value, class_start_line);
         $$->children.push_back($5);
         $$->children.push_back($6);
     };
 
 var_declaration_list:
   %empty {
-        $$ = new Node("VarDeclarationList", "", yylineno);
+        $$ = nodeArena.create(NodeKind::VarDeclarationList, "", yylineno);
     }
     | var_declaration_list var_declaration {
         $$ = $1;
@@ -106,7 +108,7 @@ var_declaration_list:
 
 method_declaration_list:
     %empty {
-        $$ = new Node("MethodDeclarationList", "", yylineno);
+        $$ = nodeArena.create(NodeKind::MethodDeclarationList, "", yylineno);
     }
     | method_declaration_list method_declaration {
         $$ = $1;
@@ -115,20 +117,20 @@ method_declaration_list:
 
 var_declaration:
     type identifier SEMCOL {
-        $$ = new Node("VarDeclaration", "", yylineno);
+        $$ = nodeArena.create(NodeKind::VarDeclaration, "", yylineno);
         $$->children.push_back($1);
         $$->children.push_back($2);
     };
 
 variable:
     type identifier {
-        $$ = new Node("Variable", $2->value, yylineno);
+        $$ = nodeArena.create(NodeKind::Variable, $2->value, yylineno);
         $$->children.push_back($1);
     };
 
 parameter_list:
     %empty {
-        $$ = new Node("ParameterList", "", yylineno);
+        $$ = nodeArena.create(NodeKind::ParameterList, "", yylineno);
     }
     | non_empty_parameter_list {
         $$ = $1;
@@ -136,7 +138,7 @@ parameter_list:
 
 non_empty_parameter_list:
     variable {
-        $$ = new Node("ParameterList", "", yylineno);
+        $$ = nodeArena.create(NodeKind::ParameterList, "", yylineno);
         $$->children.push_back($1);
     }
     | non_empty_parameter_list COMMA variable {
@@ -146,13 +148,13 @@ non_empty_parameter_list:
 
 return:
     RETURN expression SEMCOL {
-        $$ = new Node("Return", "", yylineno);
+        $$ = nodeArena.create(NodeKind::Return, "", yylineno);
         $$->children.push_back($2);
     };
 
 code:
     %empty {
-        $$ = new Node("Code", "", yylineno);
+        $$ = nodeArena.create(NodeKind::Code, "", yylineno);
     }
     | code next_row {
         $$ = $1;
@@ -169,7 +171,7 @@ next_row:
 
 method_declaration:
     { method_start_line = yylineno; } PUBLIC type identifier LP parameter_list RP LC code return RC {
-        $$ = new Node("MethodDeclaration", $4->value, method_start_line);
+        $$ = nodeArena.create(NodeKind::MethodDeclaration, $4->value, method_start_line);
         $$->children.push_back($3);
         $$->children.push_back($6);
         $$->children.push_back($9);
@@ -178,21 +180,21 @@ method_declaration:
 
 type:
     INTARR {
-        $$ = new Node("Type", "IntArray", yylineno);
+        $$ = nodeArena.create(NodeKind::Type, "IntArray", yylineno);
     }
     | BOOL {
-        $$ = new Node("Type", "Bool", yylineno);
+        $$ = nodeArena.create(NodeKind::Type, "Bool", yylineno);
     }
     | INT {
-        $$ = new Node("Type", "Int", yylineno);
+        $$ = nodeArena.create(NodeKind::Type, "Int", yylineno);
     }
     | identifier {
-        $$ = new Node("Type", $1->value, yylineno);
+        $$ = nodeArena.create(NodeKind::Type, $1->value, yylineno);
     };
 
 statement_list:
     %empty {
-        $$ = new Node("StatementList", "", yylineno);
+        $$ = nodeArena.create(NodeKind::StatementList, "", yylineno);
     }
     | statement_list statement {
         $1->children.push_back($2);
@@ -201,7 +203,7 @@ statement_list:
 
 condition:
     expression {
-        $$ = new Node("Condition", "", yylineno);
+        $$ = nodeArena.create(NodeKind::Condition, "", yylineno);
         $$->children.push_back($1);
     };
 
@@ -210,53 +212,53 @@ statement:
         $$ = $2;
     }
     | IF LP condition RP statement {
-        $$ = new Node("IfStatement", "", yylineno);
+        $$ = nodeArena.create(NodeKind::IfStatement, "", yylineno);
         $$->children.push_back($3);
 
-        if ($5->type == "StatementList") {
+        if ($5->kind == NodeKind::StatementList) {
             $$->children.push_back($5);
         } else {
-            Node* ifStatementsNode = new Node("StatementList", "", yylineno);
+            Node* ifStatementsNode = nodeArena.create(NodeKind::StatementList, "", yylineno);
             ifStatementsNode->children.push_back($5);
             $$->children.push_back(ifStatementsNode);
         }
     }
     | IF LP condition RP statement ELSE statement {
-        $$ = new Node("IfElseStatement", "", yylineno);
+        $$ = nodeArena.create(NodeKind::IfElseStatement, "", yylineno);
         $$->children.push_back($3);
 
-        if ($5->type == "StatementList") {
+        if ($5->kind == NodeKind::StatementList) {
             $$->children.push_back($5);
         } else {
-            Node* ifStatementsNode = new Node("StatementList", "", yylineno);
+            Node* ifStatementsNode = nodeArena.create(NodeKind::StatementList, "", yylineno);
             ifStatementsNode->children.push_back($5);
             $$->children.push_back(ifStatementsNode);
         }
 
-        if ($7->type == "StatementList") {
+        if ($7->kind == NodeKind::StatementList) {
             $$->children.push_back($7);
         } else {
-            Node* elseStatementsNode = new Node("StatementList", "", yylineno);
+            Node* elseStatementsNode = nodeArena.create(NodeKind::StatementList, "", yylineno);
             elseStatementsNode->children.push_back($7);
             $$->children.push_back(elseStatementsNode);
         }
     }
     | WHILE LP expression RP statement {
-        $$ = new Node("WhileStatement", "", yylineno);
+        $$ = nodeArena.create(NodeKind::WhileStatement, "", yylineno);
         $$->children.push_back($3);
         $$->children.push_back($5);
     }
     | PRINT LP expression RP SEMCOL {
-        $$ = new Node("PrintStatement", "", yylineno);
+        $$ = nodeArena.create(NodeKind::PrintStatement, "", yylineno);
         $$->children.push_back($3);
     }
     | identifier EQUALSSIGN expression SEMCOL {
-        $$ = new Node("VarInitStatement", "", yylineno);
+        $$ = nodeArena.create(NodeKind::VarInitStatement, "", yylineno);
         $$->children.push_back($1);
         $$->children.push_back($3);
     }
     | identifier LB expression RB EQUALSSIGN expression SEMCOL {
-        $$ = new Node("ArrayInitStatement", "", yylineno);
+        $$ = nodeArena.create(NodeKind::ArrayInitStatement, "", yylineno);
         $$->children.push_back($1);
         $$->children.push_back($3);
         $$->children.push_back($6);
@@ -264,84 +266,84 @@ statement:
 
 expression:
     expression ANDEXPR expression {
-        $$ = new Node("AndExpression", "", yylineno);
+        $$ = nodeArena.create(NodeKind::AndExpression, "", yylineno);
         $$->children.push_back($1);
         $$->children.push_back($3);
     }
     | expression OREXPR expression {
-        $$ = new Node("OrExpression", "", yylineno);
+        $$ = nodeArena.create(NodeKind::OrExpression, "", yylineno);
         $$->children.push_back($1);
         $$->children.push_back($3);
     }
     | expression LTEXPR expression {
-        $$ = new Node("LTExpression", "", yylineno);
+        $$ = nodeArena.create(NodeKind::LTExpression, "", yylineno);
         $$->children.push_back($1);
         $$->children.push_back($3);
     }
     | expression GTEXPR expression {
-        $$ = new Node("GTExpression", "", yylineno);
+        $$ = nodeArena.create(NodeKind::GTExpression, "", yylineno);
         $$->children.push_back($1);
         $$->children.push_back($3);
     }
     | expression EQUALSEXPR expression {
-        $$ = new Node("EqualExpression", "", yylineno);
+        $$ = nodeArena.create(NodeKind::EqualExpression, "", yylineno);
         $$->children.push_back($1);
         $$->children.push_back($3);
     }
     | expression PLUSOP expression {
-        $$ = new Node("AddExpression", "", yylineno);
+        $$ = nodeArena.create(NodeKind::AddExpression, "", yylineno);
         $$->children.push_back($1);
         $$->children.push_back($3);
     }
     | expression MINUSOP expression {
-        $$ = new Node("SubExpression", "", yylineno);
+        $$ = nodeArena.create(NodeKind::SubExpression, "", yylineno);
         $$->children.push_back($1);
         $$->children.push_back($3);
     }
     | expression MULTOP expression {
-        $$ = new Node("MultExpression", "", yylineno);
+        $$ = nodeArena.create(NodeKind::MultExpression, "", yylineno);
         $$->children.push_back($1);
         $$->children.push_back($3);
     }
     | expression LB expression RB {
-        $$ = new Node("ArrayExpression", "", yylineno);
+        $$ = nodeArena.create(NodeKind::ArrayExpression, "", yylineno);
         $$->children.push_back($1);
         $$->children.push_back($3);
     }
     | expression DOT LEN {
-        $$ = new Node("LengthExpression", "", yylineno);
+        $$ = nodeArena.create(NodeKind::LengthExpression, "", yylineno);
         $$->children.push_back($1);
     }
     | expression DOT identifier LP argument_list RP {
-        $$ = new Node("MethodCallExpression", $3->value, yylineno);
+        $$ = nodeArena.create(NodeKind::MethodCallExpression, $3->value, yylineno);
         $$->children.push_back($1);
         $$->children.push_back($5);
     }
     | INTLIT {
-        $$ = new Node("IntLiteral", $1, yylineno);
+        $$ = nodeArena.create(NodeKind::IntLiteral, $1, yylineno);
     }
     | TRUE {
-        $$ = new Node("BoolLiteral", "true", yylineno);
+        $$ = nodeArena.create(NodeKind::BoolLiteral, "true", yylineno);
     }
     | FALSE {
-        $$ = new Node("BoolLiteral", "false", yylineno);
+        $$ = nodeArena.create(NodeKind::BoolLiteral, "false", yylineno);
     }
     | identifier {
         $$ = $1;
     }
     | THIS {
-        $$ = new Node("ThisExpression", "this", yylineno);
+        $$ = nodeArena.create(NodeKind::ThisExpression, "this", yylineno);
     }
     | NEW INT LB expression RB {
-        $$ = new Node("NewIntArrayExpression", "", yylineno);
+        $$ = nodeArena.create(NodeKind::NewIntArrayExpression, "", yylineno);
         $$->children.push_back($4);
     }
     | NEW identifier LP RP {
-        $$ = new Node("NewObjectExpression", "", yylineno);
+        $$ = nodeArena.create(NodeKind::NewObjectExpression, "", yylineno);
         $$->children.push_back($2);
     }
     | EXCLMARK expression {
-        $$ = new Node("NotExpression", "", yylineno);
+        $$ = nodeArena.create(NodeKind::NotExpression, "", yylineno);
         $$->children.push_back($2);
     }
     | LP expression RP {
@@ -350,7 +352,7 @@ expression:
 
 argument_list:
     %empty {
-        $$ = new Node("ArgumentList", "", yylineno);
+        $$ = nodeArena.create(NodeKind::ArgumentList, "", yylineno);
     }
     | non_empty_argument_list {
         $$ = $1;
@@ -358,7 +360,7 @@ argument_list:
 
 non_empty_argument_list:
     expression {
-        $$ = new Node("ArgumentList", "", yylineno);
+        $$ = nodeArena.create(NodeKind::ArgumentList, "", yylineno);
         $$->children.push_back($1);
     }
     | non_empty_argument_list COMMA expression {
@@ -368,5 +370,5 @@ non_empty_argument_list:
 
 identifier:
     STRLIT {
-        $$ = new Node("Identifier", $1, yylineno);
+        $$ = nodeArena.create(NodeKind::Identifier, $1, yylineno);
     };
\ No newline at end of file
@@ -0,0 +1,45 @@
+/*
+ * Runtime support for programs compiled with compiler --emit=asm.
+ *
+ * Build a native executable with: gcc -o program output.s runtime.c
+ *
+ * Objects and arrays are a header word with the number of fields or elements, followed by one 8-byte
+ * word each. Memory is never freed; compiled programs are expected to be short-lived batch jobs.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void fail(const char *message, int32_t value, int hasValue) {
+    fflush(stdout);
+    if (hasValue) {
+        fprintf(stderr, "%s: %d\n", message, value);
+    } else {
+        fprintf(stderr, "%s\n", message);
+    }
+    exit(1);
+}
+
+static int64_t *allocate(int32_t size) {
+    int64_t *memory = calloc((size_t)size + 1, sizeof(int64_t));
+    if (!memory) fail("Out of memory", 0, 0);
+    memory[0] = size;
+    return memory;
+}
+
+void mj_print_int(int32_t value) { printf("%d\n", value); }
+
+void mj_print_bool(int32_t value) { puts(value == 1 ? "true" : "false"); }
+
+int64_t *mj_new_object(int32_t fieldCount) { return allocate(fieldCount); }
+
+int64_t *mj_new_array(int32_t length) {
+    if (length < 0) fail("Negative array size", length, 1);
+    return allocate(length);
+}
+
+void mj_null_reference(void) { fail("Null reference", 0, 0); }
+
+void mj_index_out_of_bounds(int32_t index) { fail("Array index out of bounds", index, 1); }
+
+void mj_stop(void) { exit(0); }
@@ -0,0 +1,64 @@
+public class BoundsChecks {
+    public static void main(String[] a) {
+        System.out.println(new Scanner().run(6));
+    }
+}
+
+class Scanner {
+    int[] data;
+
+    public int fill(int[] values) {
+        int i;
+        i = 0;
+        while (i < values.length) {
+            values[i] = i * i;
+            i = i + 1;
+        }
+        return i;
+    }
+
+    public int run(int n) {
+        int[] local;
+        int i;
+        int j;
+        int sum;
+
+        // Indices counting up from zero below the length need no checks
+        local = new int[n];
+        i = this.fill(local);
+        data = new int[n + 2];
+        i = 0;
+        sum = 0;
+        while (i < local.length) {
+            sum = sum + local[i];
+            data[i + 1] = local[i];
+            i = i + 1;
+        }
+        System.out.println(sum);
+
+        i = 0;
+        while (i < data.length && !(data[i] == 16)) {
+            i = i + 1;
+        }
+        System.out.println(i);
+
+        i = 0;
+        while (i < 3) {
+            j = 0;
+            while (j < data.length) {
+                data[j] = data[j] + i;
+                j = j + 1;
+            }
+            i = i + 1;
+        }
+
+        // Counting down, the index could go below zero as far as the analysis knows
+        i = data.length - 1;
+        sum = 0;
+        while (0 < i + 1) {
+            sum = sum + data[i];
+            i = i - 1;
+        }
+        return sum;
+    }
+}
@@ -0,0 +1,46 @@
+public class ConstantFolding {
+    public static void main(String[] a) {
+        System.out.println(new Folder().run(7));
+    }
+}
+
+class Folder {
+    int calls;
+
+    public boolean touch() {
+        calls = calls + 1;
+        return true;
+    }
+
+    public int run(int x) {
+        int y;
+        boolean b;
+
+        System.out.println(2 + 3 * 4);
+        System.out.println(0 - 2147483647 - 1);
+        System.out.println(1 < 2);
+        System.out.println(!true);
+        System.out.println((3 == 3) && !(4 < 2));
+
+        y = x * 1 + 0;
+        System.out.println(y);
+        System.out.println(x * 2);
+        System.out.println(x * 0);
+        System.out.println(x - 0);
+
+        // The right operand is skipped when the left one decides the result
+        b = false && this.touch();
+        System.out.println(b);
+        b = true || this.touch();
+        System.out.println(b);
+        System.out.println(calls);
+
+        b = true && this.touch();
+        System.out.println(b);
+        b = this.touch() || true;
+        System.out.println(b);
+        b = this.touch() && false;
+        System.out.println(b);
+        return calls;
+    }
+}
@@ -0,0 +1,19 @@
+public class DefaultFields {
+    public static void main(String[] a) {
+        System.out.println(new Flags().run());
+    }
+}
+
+class Flags {
+    boolean done;
+    int count;
+    boolean seen;
+
+    public boolean run() {
+        System.out.println(done);
+        System.out.println(count);
+        seen = !done;
+        System.out.println(seen);
+        return done;
+    }
+}
@@ -0,0 +1,64 @@
+public class GarbageCollection {
+    public static void main(String[] a) {
+        System.out.println(new Driver().run(2000));
+    }
+}
+
+class Node {
+    int value;
+    Node next;
+
+    public int init(int v, Node n) {
+        value = v;
+        next = n;
+        return 0;
+    }
+
+    public int getValue() { return value; }
+
+    public Node getNext() { return next; }
+}
+
+class Driver {
+    Node keep;
+    int[] big;
+
+    public int run(int rounds) {
+        int r;
+        int i;
+        int sum;
+        int aux;
+        Node head;
+        Node n;
+        r = 0;
+        sum = 0;
+        keep = new Node();
+        aux = keep.init(0, keep);
+        while (r < rounds) {
+            head = new Node();
+            aux = head.init(0, head);
+            i = 0;
+            while (i < 100) {
+                n = new Node();
+                aux = n.init(i, head);
+                head = n;
+                i = i + 1;
+            }
+            big = new int[5000 + r];
+            big[4999] = r;
+            n = new Node();
+            aux = n.init(head.getValue(), keep);
+            keep = n;
+            sum = sum + head.getValue() + big[4999];
+            r = r + 1;
+        }
+        i = 0;
+        n = keep;
+        while (i < rounds) {
+            sum = sum + n.getValue();
+            n = n.getNext();
+            i = i + 1;
+        }
+        return sum;
+    }
+}
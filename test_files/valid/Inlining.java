@@ -0,0 +1,111 @@
+public class Inlining {
+    public static void main(String[] a) {
+        System.out.println(new Runner().run(5));
+    }
+}
+
+class Cell {
+    int value;
+    boolean marked;
+    Cell next;
+
+    public int getValue() {
+        return value;
+    }
+
+    public boolean setValue(int v) {
+        value = v;
+        return true;
+    }
+
+    public boolean isMarked() {
+        return marked;
+    }
+
+    public boolean mark() {
+        marked = !marked;
+        return marked;
+    }
+
+    public Cell getNext() {
+        return next;
+    }
+
+    public boolean setNext(Cell n) {
+        next = n;
+        return true;
+    }
+
+    public int max(int x, int y) {
+        if (x < y) x = y;
+        else x = x;
+        return x;
+    }
+
+    public int count(int n) {
+        int c;
+        c = 0;
+        while (0 < n) {
+            c = c + 1;
+            n = n - 1;
+        }
+        return c;
+    }
+}
+
+class Runner {
+    int value;
+    Cell head;
+
+    public int twice(int value) {
+        return value + value;
+    }
+
+    public int total() {
+        return value + head.getValue();
+    }
+
+    public int run(int n) {
+        Cell cell;
+        Cell last;
+        boolean ok;
+        int i;
+
+        // Getters and setters on other objects
+        head = new Cell();
+        ok = head.setValue(n);
+        last = head;
+        i = 1;
+        while (i < n) {
+            cell = new Cell();
+            ok = cell.setValue(i * 10);
+            ok = last.setNext(cell);
+            last = cell;
+            i = i + 1;
+        }
+        cell = head;
+        i = 0;
+        while (i < n) {
+            System.out.println(cell.getValue());
+            cell = cell.getNext();
+            i = i + 1;
+        }
+
+        // Booleans keep their type through inlined fields
+        System.out.println(head.mark());
+        System.out.println(head.isMarked());
+        System.out.println(head.mark());
+
+        // Parameters the callee assigns, and locals of a method inlined twice
+        i = 3;
+        System.out.println(head.max(i, 7));
+        System.out.println(i);
+        System.out.println(head.count(4) + head.count(2));
+
+        // Methods of the same class, where a parameter shadows a field
+        value = 100;
+        System.out.println(this.twice(21));
+        System.out.println(this.total());
+        return value;
+    }
+}
@@ -0,0 +1,60 @@
+public class LoopInvariants {
+    public static void main(String[] a) {
+        System.out.println(new Kernel().run(5, 3));
+    }
+}
+
+class Kernel {
+    int[] data;
+    int grown;
+
+    // Replaces the array the loop in run reads the length of
+    public int grow() {
+        int[] larger;
+        larger = new int[data.length + 1];
+        data = larger;
+        grown = grown + 1;
+        return grown;
+    }
+
+    public int run(int n, int k) {
+        int i;
+        int j;
+        int sum;
+        int x;
+        data = new int[n * 4];
+        i = 0;
+        sum = 0;
+        while (i < data.length) {
+            data[i] = i * 3 + k * n;
+            i = i + 1;
+        }
+        System.out.println(data[19]);
+
+        // Products of the counters step along with them, also when counting down
+        i = n - 1;
+        while (0 < i + 1) {
+            j = 0;
+            while (j < n) {
+                x = i * k;
+                sum = sum + data[j * 4] + x + j * k + (n + k) * 2;
+                j = j + 1;
+            }
+            i = i - 1;
+        }
+        System.out.println(sum);
+
+        // The length changes with every call, so it is read again on every iteration
+        i = 0;
+        while (i < data.length && i < 100) {
+            if (grown < 3) {
+                x = this.grow();
+            } else {
+                x = 0;
+            }
+            i = i + 1;
+        }
+        System.out.println(data.length);
+        return i * 7;
+    }
+}
@@ -0,0 +1,69 @@
+public class ShortCircuit {
+    public static void main(String[] a) {
+        System.out.println(new Checker().run(5));
+        System.out.println(new Checker().first(5));
+        System.out.println(new Checker().second(3));
+    }
+}
+
+class Checker {
+    int calls;
+    int[] arr;
+
+    public boolean hit(boolean v) {
+        calls = calls + 1;
+        return v;
+    }
+
+    public boolean first(int n) {
+        boolean r;
+        r = 0 < n || this.hit(false);
+        System.out.println(r);
+        return r && calls < 1;
+    }
+
+    public boolean second(int k) {
+        boolean b;
+        b = true;
+        System.out.println(b || (k < 0));
+        return b && (k < 0);
+    }
+
+    public int run(int n) {
+        int i;
+        boolean b;
+        arr = new int[n];
+        i = 0;
+        while (i < n && !(arr[i] == 3)) {
+            arr[i] = i + 1;
+            i = i + 1;
+        }
+        System.out.println(i);
+        i = 0;
+        while (i < arr.length && this.hit(i < 3)) {
+            i = i + 1;
+        }
+        System.out.println(calls);
+        b = this.hit(false) && this.hit(true);
+        System.out.println(b);
+        b = this.hit(true) || this.hit(true);
+        System.out.println(b);
+        b = !(this.hit(true) && this.hit(false)) || this.hit(true);
+        System.out.println(b);
+        System.out.println(calls);
+        if ((i < 2 || this.hit(true)) && !(this.hit(false) || i < 0)) {
+            System.out.println(1);
+        } else {
+            System.out.println(0);
+        }
+        if (this.hit(i > 100) || this.hit(false))
+            System.out.println(2);
+        else
+            System.out.println(3);
+        System.out.println(calls);
+        b = this.hit(true) && (this.hit(false) || i == 3);
+        if (b) i = 1; else i = 0;
+        System.out.println(b);
+        return calls;
+    }
+}
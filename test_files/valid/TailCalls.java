@@ -0,0 +1,67 @@
+public class TailCalls {
+    public static void main(String[] a) {
+        System.out.println(new Recursion().run());
+    }
+}
+
+class Recursion {
+    int steps;
+    int[] values;
+
+    // Counts down ten thousand calls, which the tail call turns into a loop in one frame
+    public boolean countDown(int n) {
+        steps = steps + 1;
+        return n < 1 || this.countDown(n - 1);
+    }
+
+    public boolean ordered(int i, int last) {
+        return !(i < values.length) || (!(values[i] < last) && this.ordered(i + 1, values[i]));
+    }
+
+    // The arguments swap the parameters, which must not overwrite each other
+    public boolean alternate(int a, int b, int n) {
+        System.out.println(a);
+        return n < 1 || this.alternate(b, a, n - 1);
+    }
+
+    public boolean parity(int n, boolean even) {
+        boolean next;
+        if (even) {
+            next = false;
+        } else {
+            next = true;
+        }
+        return (n < 1 && even) || (0 < n && this.parity(n - 1, next));
+    }
+
+    public int depth(int n) {
+        int result;
+        if (n < 1) {
+            result = 0;
+        } else {
+            result = 1 + this.depth(n - 1);
+        }
+        return result;
+    }
+
+    public int run() {
+        System.out.println(this.countDown(10000));
+        System.out.println(steps);
+
+        values = new int[5];
+        values[0] = 1;
+        values[1] = 3;
+        values[2] = 3;
+        values[3] = 8;
+        values[4] = 9;
+        System.out.println(this.ordered(0, 0));
+        values[3] = 2;
+        System.out.println(this.ordered(0, 0));
+
+        System.out.println(this.alternate(4, 7, 3));
+        System.out.println(this.parity(10, true));
+        System.out.println(this.parity(7, true));
+        System.out.println(this.depth(100));
+        return 0;
+    }
+}